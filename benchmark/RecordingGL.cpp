@@ -0,0 +1,703 @@
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <GL/glew.h>
+#include "RecordingGL.h"
+
+// A recording implementation of the GL entry points declared in headless/GL/glew.h.
+// Nothing is rendered: calls are counted, object names are handed out from a counter and
+// shader sources are scanned just enough to answer the reflection queries the renderer makes
+// (active attributes/uniforms and their locations).
+
+namespace recording
+{
+	struct ShaderVariable
+	{
+		std::string name;
+		GLenum		type;
+		GLint		size;
+		GLint		location;
+	};
+
+	struct ShaderObject
+	{
+		GLenum		type;
+		std::string source;
+	};
+
+	struct ProgramObject
+	{
+		std::vector<GLuint>			shaders;
+		std::vector<ShaderVariable> attributes;
+		std::vector<ShaderVariable> uniforms;
+		std::vector<std::string>	uniformBlocks;
+		// Binding point of each uniform block, GL_INVALID_INDEX until glUniformBlockBinding.
+		std::vector<GLuint>			blockBindings;
+		// The shaders as they were at the last link, what the program binary is made of.
+		std::vector<ShaderObject>	linkedShaders;
+		bool						linked = false;
+	};
+
+	// The only program binary format: every linked shader as (type, source length, source).
+	const GLenum BinaryFormat = 0x52474C31; // "RGL1"
+
+	GLStats stats{};
+	GLuint nextName = 1;
+	std::unordered_map<GLuint, ShaderObject> shaders;
+	std::unordered_map<GLuint, ProgramObject> programs;
+	// A range bound to a uniform buffer binding point, and the storage generation of its buffer when it was bound.
+	struct UniformRange
+	{
+		GLuint		buffer;
+		uint32_t	storage;
+	};
+
+	GLuint currentProgram = 0;
+	GLuint uniformBufferBinding = 0;
+	// Bumped by every glBufferData, so ranges bound before it can be told apart.
+	std::unordered_map<GLuint, uint32_t> bufferStorage;
+	UniformRange uniformRanges[16] = {};
+
+	// Counts the draw if a uniform block of the current program reads an unbound or orphaned range.
+	void check_uniform_blocks()
+	{
+		const auto program = programs.find(currentProgram);
+		if (program == programs.end())
+		{
+			return;
+		}
+		for (GLuint binding : program->second.blockBindings)
+		{
+			if (binding >= 16) continue;
+			const UniformRange& range = uniformRanges[binding];
+			if (range.buffer == 0 || range.storage != bufferStorage[range.buffer])
+			{
+				++stats.staleUniformDraws;
+				return;
+			}
+		}
+	}
+
+	// Last data uploaded to GL_DRAW_INDIRECT_BUFFER, read back by glMultiDrawElementsIndirect to count triangles.
+	std::vector<char> indirectCommands;
+
+	// Reads every cache line of uploaded data, as a driver copying it would, so uploads from mapped files fault their pages in.
+	volatile unsigned char uploadSink = 0;
+	void readUpload(const void* data, size_t size)
+	{
+		const unsigned char* bytes = static_cast<const unsigned char*>(data);
+		unsigned char sum = 0;
+		for (size_t i = 0; i < size; i += 64) sum += bytes[i];
+		uploadSink = sum;
+	}
+
+	// Backing memory handed out by glMapBufferRange. Written data is discarded.
+	std::vector<char> mappedMemory;
+	GLsizeiptr mappedLength = 0;
+
+	const GLStats& Stats()
+	{
+		return stats;
+	}
+
+	void ResetStats()
+	{
+		stats = GLStats{};
+	}
+
+	GLenum glsl_type(const std::string& type)
+	{
+		if (type == "float")		return GL_FLOAT;
+		if (type == "vec2")			return GL_FLOAT_VEC2;
+		if (type == "vec3")			return GL_FLOAT_VEC3;
+		if (type == "vec4")			return GL_FLOAT_VEC4;
+		if (type == "int")			return GL_INT;
+		if (type == "ivec2")		return GL_INT_VEC2;
+		if (type == "ivec3")		return GL_INT_VEC3;
+		if (type == "ivec4")		return GL_INT_VEC4;
+		if (type == "uint")			return GL_UNSIGNED_INT;
+		if (type == "bool")			return GL_BOOL;
+		if (type == "mat3")			return GL_FLOAT_MAT3;
+		if (type == "mat4")			return GL_FLOAT_MAT4;
+		if (type == "sampler2D")	return GL_SAMPLER_2D;
+		return 0;
+	}
+
+	// Tokens of {source}, with #define, #ifdef, #ifndef, #else and #endif applied (enough for shader variants). Other directives are skipped.
+	std::vector<std::string> tokenize(const std::string& source)
+	{
+		std::vector<std::string> tokens;
+		std::vector<std::string> defines;
+		// One entry per open #ifdef/#ifndef: whether its current branch is compiled.
+		std::vector<bool> active;
+		auto compiled = [&active]() { return std::find(active.begin(), active.end(), false) == active.end(); };
+
+		size_t i = 0;
+		while (i < source.size())
+		{
+			const char c = source[i];
+			if (std::isspace(static_cast<unsigned char>(c)))
+			{
+				++i;
+			}
+			else if (c == '#')
+			{
+				const size_t end = std::min(source.find('\n', i), source.size());
+				char directive[16] = {};
+				char name[64] = {};
+				sscanf(source.substr(i + 1, end - i - 1).c_str(), " %15s %63s", directive, name);
+				const bool defined = std::find(defines.begin(), defines.end(), name) != defines.end();
+
+				if (strcmp(directive, "define") == 0 && compiled())	defines.push_back(name);
+				else if (strcmp(directive, "ifdef") == 0)			active.push_back(defined);
+				else if (strcmp(directive, "ifndef") == 0)			active.push_back(!defined);
+				else if (strcmp(directive, "else") == 0 && !active.empty())		active.back() = !active.back();
+				else if (strcmp(directive, "endif") == 0 && !active.empty())	active.pop_back();
+				i = end;
+			}
+			else if (!compiled())
+			{
+				++i;
+			}
+			else if (std::isalnum(static_cast<unsigned char>(c)) || c == '_')
+			{
+				const size_t begin = i;
+				while (i < source.size() && (std::isalnum(static_cast<unsigned char>(source[i])) || source[i] == '_')) ++i;
+				tokens.emplace_back(source, begin, i - begin);
+			}
+			else
+			{
+				tokens.emplace_back(1, c);
+				++i;
+			}
+		}
+		return tokens;
+	}
+
+	void add_variable(std::vector<ShaderVariable>& variables, const ShaderVariable& variable)
+	{
+		for (const auto& existing : variables)
+		{
+			if (existing.name == variable.name) return;
+		}
+		variables.push_back(variable);
+	}
+
+	// Collects the global "uniform <type> <name>" and (vertex stage) "in <type> <name>" declarations.
+	void reflect(const ShaderObject& shader, ProgramObject& program)
+	{
+		const std::vector<std::string> tokens = tokenize(shader.source);
+		int depth = 0;
+		GLint layoutLocation = -1;
+
+		for (size_t i = 0; i < tokens.size(); ++i)
+		{
+			const std::string& token = tokens[i];
+			if (token == "{" || token == "(") { ++depth; continue; }
+			if (token == "}" || token == ")") { --depth; continue; }
+			if (token == ";") { layoutLocation = -1; continue; }
+			if (depth != 0) continue;
+
+			if (token == "layout" && i + 1 < tokens.size() && tokens[i + 1] == "(")
+			{
+				for (size_t j = i + 2; j + 2 < tokens.size() && tokens[j] != ")"; ++j)
+				{
+					if (tokens[j] == "location" && tokens[j + 1] == "=")
+					{
+						layoutLocation = std::stoi(tokens[j + 2]);
+					}
+				}
+				continue;
+			}
+
+			const bool isUniform = token == "uniform";
+			const bool isAttribute = token == "in" && shader.type == GL_VERTEX_SHADER;
+			if ((!isUniform && !isAttribute) || i + 2 >= tokens.size())
+			{
+				continue;
+			}
+
+			// Interface blocks ("in VS_OUT { ... }", "uniform Block { ... }") are skipped, uniform blocks are only named.
+			if (tokens[i + 2] == "{")
+			{
+				const std::string& block = tokens[i + 1];
+				if (isUniform && std::find(program.uniformBlocks.begin(), program.uniformBlocks.end(), block) == program.uniformBlocks.end())
+				{
+					program.uniformBlocks.push_back(block);
+				}
+				continue;
+			}
+
+			ShaderVariable variable;
+			variable.type = glsl_type(tokens[i + 1]);
+			variable.name = tokens[i + 2];
+			variable.size = 1;
+			if (i + 4 < tokens.size() && tokens[i + 3] == "[")
+			{
+				variable.size = std::stoi(tokens[i + 4]);
+			}
+
+			if (isUniform)
+			{
+				variable.location = static_cast<GLint>(program.uniforms.size());
+				add_variable(program.uniforms, variable);
+			}
+			else
+			{
+				variable.location = layoutLocation >= 0 ? layoutLocation : static_cast<GLint>(program.attributes.size());
+				add_variable(program.attributes, variable);
+			}
+			i += 2;
+		}
+	}
+
+	const ShaderVariable* find_variable(const std::vector<ShaderVariable>& variables, const GLchar* name)
+	{
+		for (const auto& variable : variables)
+		{
+			if (variable.name == name) return &variable;
+		}
+		return nullptr;
+	}
+
+	void copy_name(const std::string& name, GLsizei bufSize, GLsizei* length, GLchar* out)
+	{
+		if (bufSize <= 0) return;
+		const GLsizei written = static_cast<GLsizei>(std::min<size_t>(name.size(), bufSize - 1));
+		memcpy(out, name.data(), written);
+		out[written] = '\0';
+		if (length) *length = written;
+	}
+
+	GLint max_name_length(const std::vector<ShaderVariable>& variables)
+	{
+		GLint length = 0;
+		for (const auto& variable : variables)
+		{
+			length = std::max(length, static_cast<GLint>(variable.name.size() + 1));
+		}
+		return length;
+	}
+
+	std::string program_binary(const ProgramObject& program)
+	{
+		std::string binary;
+		for (const ShaderObject& shader : program.linkedShaders)
+		{
+			const uint32_t size = static_cast<uint32_t>(shader.source.size());
+			binary.append(reinterpret_cast<const char*>(&shader.type), sizeof(shader.type));
+			binary.append(reinterpret_cast<const char*>(&size), sizeof(size));
+			binary.append(shader.source);
+		}
+		return binary;
+	}
+}
+
+using namespace recording;
+
+#define RECORD_CALL()			++stats.calls
+#define RECORD_STATE()			++stats.calls; ++stats.stateChanges
+#define RECORD_UNIFORM()		++stats.calls; ++stats.uniformUploads
+#define RECORD_DRAW()			++stats.calls; ++stats.drawCalls; check_uniform_blocks()
+
+GLboolean glewExperimental = GL_FALSE;
+GLboolean __GLEW_ARB_multi_draw_indirect = GL_TRUE;
+GLboolean __GLEW_ARB_base_instance = GL_TRUE;
+GLboolean __GLEW_ARB_get_program_binary = GL_TRUE;
+GLboolean __GLEW_KHR_parallel_shader_compile = GL_TRUE;
+
+GLenum glewInit()
+{
+	return GLEW_OK;
+}
+
+const GLubyte* glewGetErrorString(GLenum error)
+{
+	return reinterpret_cast<const GLubyte*>(error == GL_NO_ERROR ? "No error" : "Unknown error");
+}
+
+GLenum glGetError()
+{
+	RECORD_CALL();
+	return GL_NO_ERROR;
+}
+
+void glGetIntegerv(GLenum pname, GLint* data)
+{
+	RECORD_CALL();
+	switch (pname)
+	{
+	case GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT:	*data = 256; break;
+	case GL_NUM_PROGRAM_BINARY_FORMATS:			*data = 1; break;
+	case GL_PROGRAM_BINARY_FORMATS:				*data = static_cast<GLint>(BinaryFormat); break;
+	default:									*data = 0; break;
+	}
+}
+
+const GLubyte* glGetString(GLenum name)
+{
+	RECORD_CALL();
+	switch (name)
+	{
+	case GL_VENDOR:		return reinterpret_cast<const GLubyte*>("open-gl-game");
+	case GL_RENDERER:	return reinterpret_cast<const GLubyte*>("Recording GL");
+	case GL_VERSION:	return reinterpret_cast<const GLubyte*>("3.3 Recording");
+	default:			return reinterpret_cast<const GLubyte*>("");
+	}
+}
+
+void glClear(GLbitfield)									{ RECORD_CALL(); }
+void glClearColor(GLfloat, GLfloat, GLfloat, GLfloat)		{ RECORD_STATE(); }
+void glViewport(GLint, GLint, GLsizei, GLsizei)				{ RECORD_STATE(); }
+void glEnable(GLenum)										{ RECORD_STATE(); }
+void glDisable(GLenum)										{ RECORD_STATE(); }
+void glCullFace(GLenum)										{ RECORD_STATE(); }
+void glPolygonMode(GLenum, GLenum)							{ RECORD_STATE(); }
+void glDepthFunc(GLenum)									{ RECORD_STATE(); }
+void glDepthMask(GLboolean)									{ RECORD_STATE(); }
+void glBlendFunc(GLenum, GLenum)							{ RECORD_STATE(); }
+
+void glGenTextures(GLsizei n, GLuint* textures)
+{
+	RECORD_CALL();
+	for (GLsizei i = 0; i < n; ++i) textures[i] = nextName++;
+}
+
+void glDeleteTextures(GLsizei, const GLuint*)				{ RECORD_CALL(); }
+void glActiveTexture(GLenum)								{ RECORD_STATE(); }
+void glBindTexture(GLenum, GLuint)							{ RECORD_STATE(); }
+
+void glGenVertexArrays(GLsizei n, GLuint* arrays)
+{
+	RECORD_CALL();
+	for (GLsizei i = 0; i < n; ++i) arrays[i] = nextName++;
+}
+
+void glDeleteVertexArrays(GLsizei, const GLuint*)			{ RECORD_CALL(); }
+void glBindVertexArray(GLuint)								{ RECORD_STATE(); }
+void glEnableVertexAttribArray(GLuint)						{ RECORD_STATE(); }
+void glVertexAttribDivisor(GLuint, GLuint)					{ RECORD_STATE(); }
+void glVertexAttribPointer(GLuint, GLint, GLenum, GLboolean, GLsizei, const void*) { RECORD_STATE(); }
+
+void glGenBuffers(GLsizei n, GLuint* buffers)
+{
+	RECORD_CALL();
+	for (GLsizei i = 0; i < n; ++i) buffers[i] = nextName++;
+}
+
+void glDeleteBuffers(GLsizei, const GLuint*)				{ RECORD_CALL(); }
+void glBindBuffer(GLenum target, GLuint buffer)
+{
+	RECORD_STATE();
+	if (target == GL_UNIFORM_BUFFER) uniformBufferBinding = buffer;
+}
+
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum)
+{
+	RECORD_CALL();
+	if (data) stats.bufferUploadBytes += size;
+	if (data) readUpload(data, size);
+	if (target == GL_UNIFORM_BUFFER)
+	{
+		++bufferStorage[uniformBufferBinding];
+		++stats.uniformBufferOrphans;
+	}
+	if (target == GL_DRAW_INDIRECT_BUFFER)
+	{
+		indirectCommands.resize(size);
+		if (data) memcpy(indirectCommands.data(), data, size);
+	}
+}
+
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data)
+{
+	RECORD_CALL();
+	stats.bufferUploadBytes += size;
+	readUpload(data, size);
+	if (target == GL_DRAW_INDIRECT_BUFFER)
+	{
+		if (indirectCommands.size() < static_cast<size_t>(offset + size)) indirectCommands.resize(offset + size);
+		memcpy(indirectCommands.data() + offset, data, size);
+	}
+}
+
+void* glMapBufferRange(GLenum, GLintptr, GLsizeiptr length, GLbitfield)
+{
+	RECORD_CALL();
+	if (mappedMemory.size() < static_cast<size_t>(length))
+	{
+		mappedMemory.resize(length);
+	}
+	mappedLength = length;
+	return mappedMemory.data();
+}
+
+GLboolean glUnmapBuffer(GLenum)
+{
+	RECORD_CALL();
+	stats.bufferUploadBytes += mappedLength;
+	mappedLength = 0;
+	return GL_TRUE;
+}
+
+void glCopyBufferSubData(GLenum, GLenum, GLintptr, GLintptr, GLsizeiptr) { RECORD_CALL(); }
+void glBindBufferBase(GLenum target, GLuint index, GLuint buffer)
+{
+	RECORD_STATE();
+	if (target == GL_UNIFORM_BUFFER && index < 16)
+	{
+		uniformBufferBinding = buffer;
+		uniformRanges[index] = { buffer, bufferStorage[buffer] };
+	}
+}
+
+void glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr, GLsizeiptr)
+{
+	glBindBufferBase(target, index, buffer);
+}
+
+void glDrawArrays(GLenum, GLint, GLsizei count)					{ RECORD_DRAW(); stats.trianglesDrawn += count / 3; }
+void glDrawElements(GLenum, GLsizei count, GLenum, const void*)	{ RECORD_DRAW(); stats.trianglesDrawn += count / 3; }
+void glDrawArraysInstanced(GLenum, GLint, GLsizei count, GLsizei instances)	{ RECORD_DRAW(); stats.trianglesDrawn += uint64_t(count / 3) * instances; }
+void glDrawElementsInstanced(GLenum, GLsizei count, GLenum, const void*, GLsizei instances) { RECORD_DRAW(); stats.trianglesDrawn += uint64_t(count / 3) * instances; }
+void glDrawElementsBaseVertex(GLenum, GLsizei count, GLenum, const void*, GLint) { RECORD_DRAW(); stats.trianglesDrawn += count / 3; }
+void glDrawElementsInstancedBaseVertex(GLenum, GLsizei count, GLenum, const void*, GLsizei instances, GLint) { RECORD_DRAW(); stats.trianglesDrawn += uint64_t(count / 3) * instances; }
+
+void glMultiDrawElementsIndirect(GLenum, GLenum, const void* indirect, GLsizei drawCount, GLsizei stride)
+{
+	RECORD_DRAW();
+
+	// Commands are { count, instanceCount, firstIndex, baseVertex, baseInstance }.
+	const size_t commandStride = stride != 0 ? stride : 5 * sizeof(GLuint);
+	for (GLsizei i = 0; i < drawCount; ++i)
+	{
+		const size_t offset = reinterpret_cast<size_t>(indirect) + i * commandStride;
+		if (offset + 2 * sizeof(GLuint) > indirectCommands.size())
+		{
+			break;
+		}
+		GLuint command[2];
+		memcpy(command, indirectCommands.data() + offset, sizeof(command));
+		stats.trianglesDrawn += uint64_t(command[0] / 3) * command[1];
+	}
+}
+
+GLuint glCreateShader(GLenum type)
+{
+	RECORD_CALL();
+	const GLuint name = nextName++;
+	shaders[name] = ShaderObject{ type, std::string() };
+	return name;
+}
+
+void glDeleteShader(GLuint shader)
+{
+	RECORD_CALL();
+	shaders.erase(shader);
+}
+
+void glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)
+{
+	RECORD_CALL();
+	std::string& source = shaders[shader].source;
+	source.clear();
+	for (GLsizei i = 0; i < count; ++i)
+	{
+		if (length && length[i] >= 0)	source.append(string[i], length[i]);
+		else							source.append(string[i]);
+	}
+}
+
+void glCompileShader(GLuint)								{ RECORD_CALL(); }
+
+void glGetShaderiv(GLuint, GLenum pname, GLint* params)
+{
+	RECORD_CALL();
+	*params = pname == GL_COMPILE_STATUS ? GL_TRUE : 0;
+}
+
+GLuint glCreateProgram()
+{
+	RECORD_CALL();
+	const GLuint name = nextName++;
+	programs[name] = ProgramObject{};
+	return name;
+}
+
+void glDeleteProgram(GLuint program)
+{
+	RECORD_CALL();
+	programs.erase(program);
+}
+
+void glAttachShader(GLuint program, GLuint shader)
+{
+	RECORD_CALL();
+	programs[program].shaders.push_back(shader);
+}
+
+void glDetachShader(GLuint program, GLuint shader)
+{
+	RECORD_CALL();
+	auto& attached = programs[program].shaders;
+	attached.erase(std::remove(attached.begin(), attached.end(), shader), attached.end());
+}
+
+void glLinkProgram(GLuint program)
+{
+	RECORD_CALL();
+	ProgramObject& object = programs[program];
+	object.attributes.clear();
+	object.uniforms.clear();
+	object.uniformBlocks.clear();
+	object.blockBindings.clear();
+	object.linkedShaders.clear();
+	for (GLuint shader : object.shaders)
+	{
+		reflect(shaders[shader], object);
+		object.linkedShaders.push_back(shaders[shader]);
+	}
+	object.linked = true;
+}
+
+void glGetProgramiv(GLuint program, GLenum pname, GLint* params)
+{
+	RECORD_CALL();
+	const ProgramObject& object = programs[program];
+	switch (pname)
+	{
+	case GL_LINK_STATUS:					*params = object.linked ? GL_TRUE : GL_FALSE; break;
+	case GL_ACTIVE_ATTRIBUTES:				*params = static_cast<GLint>(object.attributes.size()); break;
+	case GL_ACTIVE_ATTRIBUTE_MAX_LENGTH:	*params = max_name_length(object.attributes); break;
+	case GL_ACTIVE_UNIFORMS:				*params = static_cast<GLint>(object.uniforms.size()); break;
+	case GL_ACTIVE_UNIFORM_MAX_LENGTH:		*params = max_name_length(object.uniforms); break;
+	case GL_PROGRAM_BINARY_LENGTH:			*params = object.linked ? static_cast<GLint>(program_binary(object).size()) : 0; break;
+	// Nothing is compiled, so every program is done as soon as it is asked.
+	case GL_COMPLETION_STATUS_KHR:			*params = GL_TRUE; break;
+	default:								*params = 0; break;
+	}
+}
+
+void glProgramParameteri(GLuint, GLenum, GLint)			{ RECORD_CALL(); }
+void glMaxShaderCompilerThreadsKHR(GLuint)					{ RECORD_CALL(); }
+
+void glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary)
+{
+	RECORD_CALL();
+	const std::string contents = program_binary(programs[program]);
+	const bool fits = programs[program].linked && contents.size() <= static_cast<size_t>(bufSize);
+	if (fits)
+	{
+		memcpy(binary, contents.data(), contents.size());
+		*binaryFormat = BinaryFormat;
+	}
+	if (length) *length = fits ? static_cast<GLsizei>(contents.size()) : 0;
+}
+
+// Rebuilds the program from the shaders in the binary, the way a driver skips straight to the linked result.
+// Anything malformed leaves the program unlinked, like a driver rejecting a binary.
+void glProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length)
+{
+	RECORD_CALL();
+	ProgramObject& object = programs[program];
+	object = ProgramObject{};
+
+	const char* data = static_cast<const char*>(binary);
+	size_t offset = 0;
+	auto read = [&](void* value, size_t size)
+	{
+		if (size > static_cast<size_t>(length) - offset) return false;
+		memcpy(value, data + offset, size);
+		offset += size;
+		return true;
+	};
+
+	if (binaryFormat != BinaryFormat)
+	{
+		return;
+	}
+	while (offset < static_cast<size_t>(length))
+	{
+		ShaderObject shader{};
+		uint32_t size = 0;
+		if (!read(&shader.type, sizeof(shader.type)) || !read(&size, sizeof(size)) || size > static_cast<size_t>(length) - offset ||
+			(shader.type != GL_VERTEX_SHADER && shader.type != GL_FRAGMENT_SHADER && shader.type != GL_GEOMETRY_SHADER &&
+			 shader.type != GL_TESS_CONTROL_SHADER && shader.type != GL_TESS_EVALUATION_SHADER))
+		{
+			object = ProgramObject{};
+			return;
+		}
+		shader.source.assign(data + offset, size);
+		offset += size;
+		reflect(shader, object);
+		object.linkedShaders.push_back(std::move(shader));
+	}
+	object.linked = !object.linkedShaders.empty();
+}
+
+void glUseProgram(GLuint program)
+{
+	RECORD_STATE();
+	currentProgram = program;
+}
+
+void glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+	RECORD_CALL();
+	const ShaderVariable& attribute = programs[program].attributes.at(index);
+	copy_name(attribute.name, bufSize, length, name);
+	*size = attribute.size;
+	*type = attribute.type;
+}
+
+GLint glGetAttribLocation(GLuint program, const GLchar* name)
+{
+	RECORD_CALL();
+	const ShaderVariable* attribute = find_variable(programs[program].attributes, name);
+	return attribute ? attribute->location : -1;
+}
+
+void glGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name)
+{
+	RECORD_CALL();
+	const ShaderVariable& uniform = programs[program].uniforms.at(index);
+	copy_name(uniform.name, bufSize, length, name);
+	*size = uniform.size;
+	*type = uniform.type;
+}
+
+GLint glGetUniformLocation(GLuint program, const GLchar* name)
+{
+	RECORD_CALL();
+	const ShaderVariable* uniform = find_variable(programs[program].uniforms, name);
+	return uniform ? uniform->location : -1;
+}
+
+GLuint glGetUniformBlockIndex(GLuint program, const GLchar* uniformBlockName)
+{
+	RECORD_CALL();
+	const auto& blocks = programs[program].uniformBlocks;
+	const auto block = std::find(blocks.begin(), blocks.end(), uniformBlockName);
+	return block != blocks.end() ? static_cast<GLuint>(block - blocks.begin()) : GL_INVALID_INDEX;
+}
+
+void glUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding)
+{
+	RECORD_CALL();
+	ProgramObject& object = programs[program];
+	object.blockBindings.resize(object.uniformBlocks.size(), GL_INVALID_INDEX);
+	if (uniformBlockIndex < object.blockBindings.size()) object.blockBindings[uniformBlockIndex] = uniformBlockBinding;
+}
+
+void glUniform1i(GLint, GLint)										{ RECORD_UNIFORM(); }
+void glUniform1f(GLint, GLfloat)									{ RECORD_UNIFORM(); }
+void glUniform2fv(GLint, GLsizei, const GLfloat*)					{ RECORD_UNIFORM(); }
+void glUniform3fv(GLint, GLsizei, const GLfloat*)					{ RECORD_UNIFORM(); }
+void glUniform4fv(GLint, GLsizei, const GLfloat*)					{ RECORD_UNIFORM(); }
+void glUniformMatrix3fv(GLint, GLsizei, GLboolean, const GLfloat*)	{ RECORD_UNIFORM(); }
+void glUniformMatrix4fv(GLint, GLsizei, GLboolean, const GLfloat*)	{ RECORD_UNIFORM(); }
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstdint>
+
+namespace recording
+{
+	// Counters accumulated by the recording GL backend since the last ResetStats().
+	struct GLStats
+	{
+		// Every GL entry point, including queries.
+		uint64_t calls;
+		// glUniform* calls.
+		uint64_t uniformUploads;
+		// glDraw* calls.
+		uint64_t drawCalls;
+		// Triangles submitted by the draws (count / 3 per instance, every draw is assumed to be GL_TRIANGLES).
+		uint64_t trianglesDrawn;
+		// Binds, program changes and fixed function state (glEnable, glPolygonMode, ...).
+		uint64_t stateChanges;
+		// Bytes passed to glBufferData/glBufferSubData.
+		uint64_t bufferUploadBytes;
+		// glBufferData calls on GL_UNIFORM_BUFFER, each orphaning the ranges bound from the buffer's old storage.
+		uint64_t uniformBufferOrphans;
+		// Draws reading a uniform block whose binding point has no range, or a range of storage orphaned since it was bound.
+		uint64_t staleUniformDraws;
+	};
+
+	const GLStats& Stats();
+	void ResetStats();
+}
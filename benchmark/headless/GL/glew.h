@@ -0,0 +1,214 @@
+#pragma once
+// Headless stand-in for <GL/glew.h>.
+// The benchmark puts this directory ahead of the real GLEW include path so the renderer
+// sources compile unchanged against a recording GL function table (see RecordingGL.cpp).
+// Only the entry points and enums used by the renderer are declared here; the enum values
+// match the Khronos registry so anything that switches on them behaves the same.
+#include <cstddef>
+#include <cstdint>
+
+typedef unsigned int	GLenum;
+typedef unsigned char	GLboolean;
+typedef unsigned int	GLbitfield;
+typedef void			GLvoid;
+typedef signed char		GLbyte;
+typedef unsigned char	GLubyte;
+typedef short			GLshort;
+typedef unsigned short	GLushort;
+typedef int				GLint;
+typedef unsigned int	GLuint;
+typedef int				GLsizei;
+typedef float			GLfloat;
+typedef double			GLdouble;
+typedef char			GLchar;
+typedef std::ptrdiff_t	GLintptr;
+typedef std::ptrdiff_t	GLsizeiptr;
+typedef int64_t			GLint64;
+typedef uint64_t		GLuint64;
+
+#define GLEW_OK								0
+#define GL_FALSE							0
+#define GL_TRUE								1
+#define GL_NO_ERROR							0
+
+// Primitives
+#define GL_POINTS							0x0000
+#define GL_LINES							0x0001
+#define GL_TRIANGLES						0x0004
+#define GL_TRIANGLE_STRIP					0x0005
+
+// Data types
+#define GL_BYTE								0x1400
+#define GL_UNSIGNED_BYTE					0x1401
+#define GL_SHORT							0x1402
+#define GL_UNSIGNED_SHORT					0x1403
+#define GL_INT								0x1404
+#define GL_UNSIGNED_INT						0x1405
+#define GL_FLOAT							0x1406
+#define GL_HALF_FLOAT						0x140B
+#define GL_INT_2_10_10_10_REV				0x8D9F
+#define GL_FLOAT_VEC2						0x8B50
+#define GL_FLOAT_VEC3						0x8B51
+#define GL_FLOAT_VEC4						0x8B52
+#define GL_INT_VEC2							0x8B53
+#define GL_INT_VEC3							0x8B54
+#define GL_INT_VEC4							0x8B55
+#define GL_BOOL								0x8B56
+#define GL_FLOAT_MAT3						0x8B5B
+#define GL_FLOAT_MAT4						0x8B5C
+#define GL_SAMPLER_2D						0x8B5E
+
+// Buffers
+#define GL_ARRAY_BUFFER						0x8892
+#define GL_ELEMENT_ARRAY_BUFFER				0x8893
+#define GL_STREAM_DRAW						0x88E0
+#define GL_STATIC_DRAW						0x88E4
+#define GL_DYNAMIC_DRAW						0x88E8
+#define GL_UNIFORM_BUFFER					0x8A11
+#define GL_DRAW_INDIRECT_BUFFER				0x8F3F
+#define GL_COPY_READ_BUFFER					0x8F36
+#define GL_COPY_WRITE_BUFFER				0x8F37
+#define GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT	0x8A34
+#define GL_INVALID_INDEX					0xFFFFFFFFu
+#define GL_MAP_READ_BIT						0x0001
+#define GL_MAP_WRITE_BIT					0x0002
+#define GL_MAP_INVALIDATE_RANGE_BIT			0x0004
+#define GL_MAP_INVALIDATE_BUFFER_BIT		0x0008
+#define GL_MAP_FLUSH_EXPLICIT_BIT			0x0010
+#define GL_MAP_UNSYNCHRONIZED_BIT			0x0020
+
+// Shaders
+#define GL_FRAGMENT_SHADER					0x8B30
+#define GL_VERTEX_SHADER					0x8B31
+#define GL_GEOMETRY_SHADER					0x8DD9
+#define GL_TESS_EVALUATION_SHADER			0x8E87
+#define GL_TESS_CONTROL_SHADER				0x8E88
+#define GL_COMPILE_STATUS					0x8B81
+#define GL_LINK_STATUS						0x8B82
+#define GL_INFO_LOG_LENGTH					0x8B84
+#define GL_ACTIVE_UNIFORMS					0x8B86
+#define GL_ACTIVE_UNIFORM_MAX_LENGTH		0x8B87
+#define GL_ACTIVE_ATTRIBUTES				0x8B89
+#define GL_ACTIVE_ATTRIBUTE_MAX_LENGTH		0x8B8A
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT	0x8257
+#define GL_PROGRAM_BINARY_LENGTH			0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS		0x87FE
+#define GL_PROGRAM_BINARY_FORMATS			0x87FF
+#define GL_COMPLETION_STATUS_KHR			0x91B1
+
+// Fixed function state
+#define GL_DEPTH_BUFFER_BIT					0x00000100
+#define GL_COLOR_BUFFER_BIT					0x00004000
+#define GL_FRONT							0x0404
+#define GL_BACK								0x0405
+#define GL_FRONT_AND_BACK					0x0408
+#define GL_CULL_FACE						0x0B44
+#define GL_DEPTH_TEST						0x0B71
+#define GL_BLEND							0x0BE2
+#define GL_LINE								0x1B01
+#define GL_FILL								0x1B02
+#define GL_ZERO								0
+#define GL_ONE								1
+#define GL_LESS								0x0201
+#define GL_LEQUAL							0x0203
+#define GL_SRC_ALPHA						0x0302
+#define GL_ONE_MINUS_SRC_ALPHA				0x0303
+
+// Textures
+#define GL_TEXTURE_2D						0x0DE1
+#define GL_TEXTURE_3D						0x806F
+#define GL_TEXTURE_CUBE_MAP					0x8513
+#define GL_TEXTURE_2D_ARRAY					0x8C1A
+#define GL_TEXTURE0							0x84C0
+#define GL_VENDOR							0x1F00
+#define GL_RENDERER							0x1F01
+#define GL_VERSION							0x1F02
+
+extern GLboolean glewExperimental;
+// Extension flags, named like GLEW's. The recording backend reports them as supported; the benchmark can turn them off.
+extern GLboolean __GLEW_ARB_multi_draw_indirect;
+extern GLboolean __GLEW_ARB_base_instance;
+extern GLboolean __GLEW_ARB_get_program_binary;
+extern GLboolean __GLEW_KHR_parallel_shader_compile;
+#define GLEW_ARB_multi_draw_indirect		__GLEW_ARB_multi_draw_indirect
+#define GLEW_ARB_base_instance				__GLEW_ARB_base_instance
+#define GLEW_ARB_get_program_binary			__GLEW_ARB_get_program_binary
+#define GLEW_KHR_parallel_shader_compile	__GLEW_KHR_parallel_shader_compile
+GLenum glewInit();
+const GLubyte* glewGetErrorString(GLenum error);
+
+GLenum glGetError();
+void glGetIntegerv(GLenum pname, GLint* data);
+const GLubyte* glGetString(GLenum name);
+void glClear(GLbitfield mask);
+void glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+void glEnable(GLenum cap);
+void glDisable(GLenum cap);
+void glCullFace(GLenum mode);
+void glPolygonMode(GLenum face, GLenum mode);
+void glDepthFunc(GLenum func);
+void glDepthMask(GLboolean flag);
+void glBlendFunc(GLenum sfactor, GLenum dfactor);
+
+void glGenTextures(GLsizei n, GLuint* textures);
+void glDeleteTextures(GLsizei n, const GLuint* textures);
+void glActiveTexture(GLenum texture);
+void glBindTexture(GLenum target, GLuint texture);
+
+void glGenVertexArrays(GLsizei n, GLuint* arrays);
+void glDeleteVertexArrays(GLsizei n, const GLuint* arrays);
+void glBindVertexArray(GLuint array);
+void glEnableVertexAttribArray(GLuint index);
+void glVertexAttribDivisor(GLuint index, GLuint divisor);
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride, const void* pointer);
+
+void glGenBuffers(GLsizei n, GLuint* buffers);
+void glDeleteBuffers(GLsizei n, const GLuint* buffers);
+void glBindBuffer(GLenum target, GLuint buffer);
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+GLboolean glUnmapBuffer(GLenum target);
+void glCopyBufferSubData(GLenum readTarget, GLenum writeTarget, GLintptr readOffset, GLintptr writeOffset, GLsizeiptr size);
+void glBindBufferBase(GLenum target, GLuint index, GLuint buffer);
+void glBindBufferRange(GLenum target, GLuint index, GLuint buffer, GLintptr offset, GLsizeiptr size);
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instancecount);
+void glDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount);
+void glMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+void glDrawElementsBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLint basevertex);
+void glDrawElementsInstancedBaseVertex(GLenum mode, GLsizei count, GLenum type, const void* indices, GLsizei instancecount, GLint basevertex);
+
+GLuint glCreateShader(GLenum type);
+void glDeleteShader(GLuint shader);
+void glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+void glCompileShader(GLuint shader);
+void glGetShaderiv(GLuint shader, GLenum pname, GLint* params);
+GLuint glCreateProgram();
+void glDeleteProgram(GLuint program);
+void glAttachShader(GLuint program, GLuint shader);
+void glDetachShader(GLuint program, GLuint shader);
+void glLinkProgram(GLuint program);
+void glGetProgramiv(GLuint program, GLenum pname, GLint* params);
+void glProgramParameteri(GLuint program, GLenum pname, GLint value);
+void glGetProgramBinary(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+void glProgramBinary(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+void glMaxShaderCompilerThreadsKHR(GLuint count);
+void glUseProgram(GLuint program);
+void glGetActiveAttrib(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name);
+GLint glGetAttribLocation(GLuint program, const GLchar* name);
+void glGetActiveUniform(GLuint program, GLuint index, GLsizei bufSize, GLsizei* length, GLint* size, GLenum* type, GLchar* name);
+GLint glGetUniformLocation(GLuint program, const GLchar* name);
+GLuint glGetUniformBlockIndex(GLuint program, const GLchar* uniformBlockName);
+void glUniformBlockBinding(GLuint program, GLuint uniformBlockIndex, GLuint uniformBlockBinding);
+
+void glUniform1i(GLint location, GLint v0);
+void glUniform1f(GLint location, GLfloat v0);
+void glUniform2fv(GLint location, GLsizei count, const GLfloat* value);
+void glUniform3fv(GLint location, GLsizei count, const GLfloat* value);
+void glUniform4fv(GLint location, GLsizei count, const GLfloat* value);
+void glUniformMatrix3fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
+void glUniformMatrix4fv(GLint location, GLsizei count, GLboolean transpose, const GLfloat* value);
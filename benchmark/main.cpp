@@ -0,0 +1,729 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include <GL/glew.h>
+
+#include "Game.h"
+#include "GLState.h"
+#include "MeshCache.h"
+#include "MeshImporter.h"
+#include "MeshOptimizer.h"
+#include "PrimitiveLoader.h"
+#include "Primitives.h"
+#include "RecordingGL.h"
+
+// Headless frame benchmark.
+// Runs the same begin_game/update_game/render_game code as the game against the recording GL backend
+// for a fixed number of scripted frames, and reports CPU time and GL traffic per frame.
+//
+// It also times CreateMesh on pre-generated primitive data to track mesh upload cost, and CreateCachedMesh for comparison,
+// serial against job system generation of large primitives, raw generator throughput and vertex cache efficiency.
+//
+// Usage: open-gl-game-benchmark [--frames N] [--objects N] [--uploads N] [--no-instancing] [--no-culling] [--no-multi-draw] [--no-lod] [--no-command-buffers] [--no-optimize] [--no-indirect]
+// Exits with 1 if any of the correctness checks made along the way failed.
+
+const double frameDelta = 1.0 / 60.0;
+
+bool checksFailed = false;
+
+// Reports {what} on stderr and fails the run unless {passed}. Returns {passed}.
+bool check(bool passed, const char* what)
+{
+	if (!passed)
+	{
+		std::cerr << "CHECK FAILED: " << what << std::endl;
+		checksFailed = true;
+	}
+	return passed;
+}
+
+// Deterministic input: walk forward, strafe, then look around with the right mouse button held.
+GameInput scripted_input(int frame, int frameCount)
+{
+	GameInput input{};
+	const int phase = (frame * 4) / glm::max(frameCount, 1);
+	input.up			= phase == 0;
+	input.right			= phase == 1;
+	input.rightMouse	= phase >= 2;
+	input.mouseDelta	= phase >= 2 ? glm::vec2(3.0f, phase == 2 ? 1.0f : -1.0f) : glm::vec2(0, 0);
+	return input;
+}
+
+enum UploadMode
+{
+	// CreateMesh, alternating interleaved and separate layouts.
+	UploadMode_Separate,
+	UploadMode_Pooled,
+	// CreateCachedMesh (pooled). Only the first upload of each primitive generates and uploads, the rest are cache hits.
+	UploadMode_Cached
+};
+
+// Uploads {uploadCount} meshes in {format}. Except for UploadMode_Cached, generation happens up front and isn't timed.
+void benchmark_uploads(int uploadCount, const gfx::VertexFormat& format, UploadMode mode, const char* label)
+{
+	const std::vector<gfx::PrimitiveDesc> primitives =
+	{
+		gfx::primitive::DescribeQuad(1.0f, 1.0f),
+		gfx::primitive::DescribeBox(1.0f, 1.0f, 1.0f),
+		gfx::primitive::DescribeSphere(3, 0.5f),
+		gfx::primitive::DescribeCylinder(0.5f, 1.0f, 32),
+		gfx::primitive::DescribeCapsule(0.5f, 1.0f, 16, 16, 2),
+	};
+
+	std::vector<gfx::MeshData> sources;
+	if (mode != UploadMode_Cached)
+	{
+		for (const auto& primitive : primitives)
+		{
+			sources.push_back(gfx::primitive::Generate(primitive));
+		}
+	}
+
+	std::vector<gfx::Mesh> uploaded;
+	uploaded.reserve(uploadCount);
+
+	recording::ResetStats();
+	const gfx::GLStateStats stateBefore = gfx::GetGLStateStats();
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < uploadCount; ++i)
+	{
+		switch (mode)
+		{
+		case UploadMode_Separate:	uploaded.push_back(gfx::CreateMesh(sources[i % sources.size()], i % 2 == 0, format)); break;
+		case UploadMode_Pooled:		uploaded.push_back(gfx::CreatePooledMesh(sources[i % sources.size()], format)); break;
+		case UploadMode_Cached:		uploaded.push_back(gfx::CreateCachedMesh(primitives[i % primitives.size()], format)); break;
+		}
+	}
+	const auto end = std::chrono::steady_clock::now();
+
+	const recording::GLStats stats = recording::Stats();
+	const gfx::GLStateStats stateAfter = gfx::GetGLStateStats();
+	const double uploads = uploadCount;
+	const double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+	std::cout << "mesh uploads (" << label << "):" << std::endl;
+	std::cout << "  meshes:                " << uploadCount << std::endl;
+	std::cout << "  cpu us/upload:         " << milliseconds * 1000.0 / uploads << std::endl;
+	std::cout << "  gl calls/upload:       " << stats.calls / uploads << std::endl;
+	std::cout << "  elided calls/upload:   " << (stateAfter.elided - stateBefore.elided) / uploads << std::endl;
+	std::cout << "  buffer bytes/upload:   " << stats.bufferUploadBytes / uploads << std::endl;
+
+	if (mode != UploadMode_Separate)
+	{
+		const gfx::MeshPoolStats poolStats = gfx::GetMeshPoolStats();
+		std::cout << "  gl objects:            " << poolStats.glObjects << " (" << poolStats.pools << " pools)" << std::endl;
+		std::cout << "  pool vertex bytes:     " << poolStats.vertexBytesUsed << " / " << poolStats.vertexBytes << std::endl;
+		std::cout << "  pool index bytes:      " << poolStats.indexBytesUsed << " / " << poolStats.indexBytes << std::endl;
+	}
+	else
+	{
+		size_t glObjects = 0;
+		for (const auto& mesh : uploaded)
+		{
+			glObjects += 2 + (mesh.ibo != 0);
+		}
+		std::cout << "  gl objects:            " << glObjects << std::endl;
+	}
+
+	if (mode == UploadMode_Cached)
+	{
+		const gfx::MeshCacheStats cacheStats = gfx::GetMeshCacheStats();
+		std::cout << "  cache hits/misses:     " << cacheStats.hits << " / " << cacheStats.misses << " (" << cacheStats.meshes << " meshes)" << std::endl;
+	}
+
+	for (auto& mesh : uploaded)
+	{
+		gfx::DeleteMesh(mesh);
+	}
+	gfx::DeleteMeshCache();
+	gfx::DeleteMeshPools();
+}
+
+// Reports how fast {generate} produces vertices, repeating it for at least a quarter second. Nothing is uploaded.
+void benchmark_primitive_throughput(const char* label, const std::function<gfx::MeshData()>& generate)
+{
+	size_t vertices = 0;
+	int runs = 0;
+	double seconds = 0.0;
+
+	const auto start = std::chrono::steady_clock::now();
+	do
+	{
+		vertices += generate().vertexCount();
+		++runs;
+		seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	} while (seconds < 0.25);
+
+	std::cout << "primitive throughput (" << label << "):" << std::endl;
+	std::cout << "  vertices/primitive:    " << vertices / runs << std::endl;
+	std::cout << "  ms/primitive:          " << seconds * 1000.0 / runs << std::endl;
+	std::cout << "  mvertices/s:           " << vertices / seconds / 1e6 << std::endl;
+}
+
+// Reports simulated vertex cache efficiency of {primitive} as generated and after OptimizeMesh.
+void benchmark_vertex_cache(const char* label, const gfx::PrimitiveDesc& primitive)
+{
+	gfx::MeshData meshData = gfx::primitive::Generate(primitive);
+	const size_t vertexCount = meshData.vertexCount();
+	const gfx::VertexCacheStats before = gfx::AnalyzeVertexCache(meshData.indices(), vertexCount);
+
+	gfx::OptimizeMesh(meshData);
+	const gfx::VertexCacheStats after = gfx::AnalyzeVertexCache(meshData.indices(), meshData.vertexCount());
+
+	std::cout << "vertex cache (" << label << ", " << gfx::DefaultVertexCacheSize << " entries):" << std::endl;
+	std::cout << "  vertices:              " << vertexCount << " -> " << meshData.vertexCount() << std::endl;
+	std::cout << "  acmr:                  " << before.acmr << " -> " << after.acmr << std::endl;
+	std::cout << "  atvr:                  " << before.atvr << " -> " << after.atvr << std::endl;
+
+	// An index count that isn't a multiple of 3 must only reorder the whole triangles.
+	std::vector<GLuint> indices(meshData.indices().begin(), meshData.indices().end());
+	indices.push_back(0);
+	indices.push_back(1);
+	gfx::OptimizeVertexCache(indices, meshData.vertexCount());
+	const bool partialKept = check(indices[indices.size() - 2] == 0 && indices.back() == 1,
+		"OptimizeVertexCache must leave indices past the last whole triangle in place");
+	std::cout << "  partial triangle:      " << (partialKept ? "left in place" : "REORDERED") << std::endl;
+}
+
+// A mesh without indices draws as a triangle strip: OptimizeMesh must turn it into a list of the same triangles, wound the
+// same way. The last vertex repeats the second, so welding merges one.
+void benchmark_strip_optimize()
+{
+	const glm::vec3 positions[] = { { 0, 0, 0 }, { 0, 1, 0 }, { 1, 0, 0 }, { 1, 1, 0 }, { 2, 0, 0 }, { 0, 1, 0 } };
+	const size_t vertexCount = std::size(positions);
+	gfx::MeshData meshData(gfx::VertexAttribute_Position, vertexCount);
+	std::copy(std::begin(positions), std::end(positions), meshData.vertices().begin());
+
+	gfx::OptimizeMesh(meshData);
+
+	// Triangle t of the strip, wound like GL draws it, matched against every triangle of the list in each rotation.
+	const std::span<const GLuint> indices = meshData.indices();
+	const std::span<const glm::vec3> vertices = meshData.vertices();
+	size_t matched = 0;
+	for (size_t t = 0; t + 2 < vertexCount; ++t)
+	{
+		const glm::vec3 expected[3] = { positions[t + (t & 1)], positions[t + 1 - (t & 1)], positions[t + 2] };
+		for (size_t i = 0; i + 2 < indices.size(); i += 3)
+		{
+			bool same = false;
+			for (size_t rotation = 0; rotation < 3 && !same; ++rotation)
+			{
+				same = vertices[indices[i + rotation]] == expected[0] && vertices[indices[i + (rotation + 1) % 3]] == expected[1] &&
+					vertices[indices[i + (rotation + 2) % 3]] == expected[2];
+			}
+			if (same)
+			{
+				++matched;
+				break;
+			}
+		}
+	}
+
+	check(matched == vertexCount - 2 && indices.size() == 3 * (vertexCount - 2), "OptimizeMesh must keep the triangles of a strip");
+
+	std::cout << "strip to triangle list:" << std::endl;
+	std::cout << "  triangles:             " << matched << "/" << vertexCount - 2 << " kept with their winding, " << indices.size() / 3
+			  << " in the list, " << vertexCount << " -> " << meshData.vertexCount() << " vertices" << std::endl;
+}
+
+// Generates and uploads {primitiveCount} distinct high resolution primitives, once serially with CreateCachedMesh
+// and once through a PrimitiveLoader on a job system.
+void benchmark_generation(int primitiveCount)
+{
+	std::vector<gfx::PrimitiveDesc> primitives;
+	for (int i = 0; i < primitiveCount; ++i)
+	{
+		const float size = 0.5f + i * 0.01f;
+		primitives.push_back(i % 2 == 0 ? gfx::primitive::DescribeSphere(5, size) : gfx::primitive::DescribeCapsule(size, 1.0f, 64, 64, 8));
+	}
+
+	std::vector<gfx::Mesh> meshes;
+	meshes.reserve(primitiveCount);
+
+	const auto serialStart = std::chrono::steady_clock::now();
+	for (const auto& primitive : primitives)
+	{
+		meshes.push_back(gfx::CreateCachedMesh(primitive, gfx::VertexFormat_Compact));
+	}
+	const auto serialEnd = std::chrono::steady_clock::now();
+
+	for (auto& mesh : meshes)
+	{
+		gfx::DeleteMesh(mesh);
+	}
+	meshes.clear();
+	gfx::DeleteMeshCache();
+	gfx::DeleteMeshPools();
+
+	gfx::JobSystem jobs;
+	jobs.Start();
+	gfx::PrimitiveLoader loader(jobs);
+
+	const auto parallelStart = std::chrono::steady_clock::now();
+	std::vector<gfx::PrimitiveLoadTicket> tickets;
+	for (const auto& primitive : primitives)
+	{
+		tickets.push_back(loader.Request(primitive, gfx::VertexFormat_Compact));
+	}
+	loader.Finish();
+	const auto parallelEnd = std::chrono::steady_clock::now();
+	const unsigned int workers = jobs.ThreadCount();
+
+	for (auto ticket : tickets)
+	{
+		meshes.push_back(loader.Take(ticket));
+	}
+	for (auto& mesh : meshes)
+	{
+		gfx::DeleteMesh(mesh);
+	}
+	loader.Clear();
+	jobs.Stop();
+	gfx::DeleteMeshCache();
+	gfx::DeleteMeshPools();
+
+	std::cout << "primitive generation + upload:" << std::endl;
+	std::cout << "  primitives:            " << primitiveCount << std::endl;
+	std::cout << "  serial ms:             " << std::chrono::duration<double, std::milli>(serialEnd - serialStart).count() << std::endl;
+	std::cout << "  job system ms:         " << std::chrono::duration<double, std::milli>(parallelEnd - parallelStart).count()
+			  << " (" << workers << " workers)" << std::endl;
+}
+
+// Uploads {primitiveCount} distinct high resolution primitives through the mesh cache with a mesh file directory:
+// once baking the files (generate, write, upload), then again from the files alone.
+void benchmark_mesh_files(int primitiveCount)
+{
+	std::vector<gfx::PrimitiveDesc> primitives;
+	for (int i = 0; i < primitiveCount; ++i)
+	{
+		const float size = 0.5f + i * 0.01f;
+		primitives.push_back(i % 2 == 0 ? gfx::primitive::DescribeSphere(5, size) : gfx::primitive::DescribeCapsule(size, 1.0f, 64, 64, 8));
+	}
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "open-gl-game-benchmark-meshes";
+	std::filesystem::remove_all(directory);
+	gfx::meshFileDirectory = directory.string();
+
+	auto uploadAll = [&]()
+	{
+		std::vector<gfx::Mesh> meshes;
+		const auto start = std::chrono::steady_clock::now();
+		for (const auto& primitive : primitives)
+		{
+			meshes.push_back(gfx::CreateCachedMesh(primitive, gfx::VertexFormat_Compact));
+		}
+		const auto end = std::chrono::steady_clock::now();
+
+		for (auto& mesh : meshes)
+		{
+			gfx::DeleteMesh(mesh);
+		}
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	};
+
+	const double bakeMilliseconds = uploadAll();
+	const size_t written = gfx::GetMeshCacheStats().fileWrites;
+	gfx::DeleteMeshCache();
+	gfx::DeleteMeshPools();
+
+	size_t fileBytes = 0;
+	for (const auto& primitive : primitives)
+	{
+		fileBytes += gfx::CachedMeshFileSize(primitive, gfx::VertexFormat_Compact);
+	}
+
+	const double loadMilliseconds = uploadAll();
+	const gfx::MeshCacheStats stats = gfx::GetMeshCacheStats();
+	gfx::DeleteMeshCache();
+	gfx::DeleteMeshPools();
+
+	gfx::meshFileDirectory.clear();
+	std::filesystem::remove_all(directory);
+
+	std::cout << "mesh files:" << std::endl;
+	std::cout << "  primitives:            " << primitiveCount << " (" << written << " files, " << fileBytes / 1024 << " KiB)" << std::endl;
+	std::cout << "  bake ms:               " << bakeMilliseconds << std::endl;
+	std::cout << "  load ms:               " << loadMilliseconds << " (" << stats.fileLoads << " from files, " << stats.generated << " generated)" << std::endl;
+	std::cout << "  load MB/s:             " << fileBytes / (loadMilliseconds / 1000.0) / 1e6 << std::endl;
+}
+
+// Writes a high resolution capsule as OBJ text (v, vt, vn, f v/vt/vn) and imports it serially and on the job system.
+void benchmark_import()
+{
+	const gfx::MeshData capsule = gfx::primitive::Capsule(0.5f, 1.0f, 512, 512, 8);
+	const auto positions = capsule.vertices();
+	const auto normals = capsule.normals();
+	const auto indices = capsule.indices();
+
+	std::string obj;
+	char line[128];
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		obj.append(line, snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", positions[i].x, positions[i].y, positions[i].z));
+	}
+	for (size_t i = 0; i < positions.size(); ++i)
+	{
+		obj.append(line, snprintf(line, sizeof(line), "vt %.6f %.6f\n", positions[i].x + 0.5f, positions[i].y + 0.5f));
+	}
+	for (size_t i = 0; i < normals.size(); ++i)
+	{
+		obj.append(line, snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", normals[i].x, normals[i].y, normals[i].z));
+	}
+	for (size_t i = 0; i < indices.size(); i += 3)
+	{
+		const GLuint a = indices[i] + 1, b = indices[i + 1] + 1, c = indices[i + 2] + 1;
+		obj.append(line, snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c));
+	}
+
+	auto import = [&obj](gfx::JobSystem* jobs, size_t& vertexCount)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		vertexCount = gfx::ParseObj(obj, jobs).vertexCount();
+		const auto end = std::chrono::steady_clock::now();
+		return std::chrono::duration<double, std::milli>(end - start).count();
+	};
+
+	size_t vertexCount = 0;
+	const double serialMilliseconds = import(nullptr, vertexCount);
+
+	gfx::JobSystem jobs;
+	jobs.Start();
+	const double parallelMilliseconds = import(&jobs, vertexCount);
+	const unsigned int workers = jobs.ThreadCount();
+	jobs.Stop();
+
+	std::cout << "obj import:" << std::endl;
+	std::cout << "  file:                  " << obj.size() / 1024 / 1024 << " MiB, " << indices.size() / 3 << " triangles -> " << vertexCount << " vertices" << std::endl;
+	std::cout << "  serial ms:             " << serialMilliseconds << " (" << obj.size() / (serialMilliseconds / 1000.0) / 1e6 << " MB/s)" << std::endl;
+	std::cout << "  job system ms:         " << parallelMilliseconds << " (" << obj.size() / (parallelMilliseconds / 1000.0) / 1e6 << " MB/s, "
+			  << workers << " workers)" << std::endl;
+}
+
+// Compiles the built-in shaders with a shader cache directory: cold (compile, link, write the binaries), warm (binaries only),
+// then with one binary corrupted, which must be rejected and rebuilt. The recording GL compiles nothing, so only the GL call
+// counts, not the times, reflect what a driver would save.
+void benchmark_shader_cache()
+{
+	const gfx::ShaderSource* sources[] = { &gfx::default_unlit_texture, &gfx::default_unlit_color, &gfx::default_lit_color, &gfx::default_lit_color_instanced };
+
+	const std::filesystem::path directory = std::filesystem::temp_directory_path() / "open-gl-game-benchmark-shaders";
+	std::filesystem::remove_all(directory);
+	gfx::shaderCacheDirectory = directory.string();
+
+	struct Pass
+	{
+		gfx::ShaderCacheStats	stats;
+		uint64_t				calls;
+		bool					valid;
+	};
+	auto compileAll = [&]()
+	{
+		const gfx::ShaderCacheStats before = gfx::GetShaderCacheStats();
+		recording::ResetStats();
+		bool valid = true;
+		for (const gfx::ShaderSource* source : sources)
+		{
+			gfx::ShaderHandle handle = gfx::CompileShader(*source);
+			valid = valid && handle != 0 && !gfx::GetShaderVertexAttributes(handle).empty();
+			gfx::DeleteShader(handle);
+		}
+
+		const gfx::ShaderCacheStats after = gfx::GetShaderCacheStats();
+		const gfx::ShaderCacheStats delta = { after.binaryLoads - before.binaryLoads, after.binaryRejects - before.binaryRejects,
+											  after.compiles - before.compiles, after.binaryWrites - before.binaryWrites };
+		return Pass{ delta, recording::Stats().calls, valid };
+	};
+
+	const Pass cold = compileAll();
+	const Pass warm = compileAll();
+
+	// Damage the first byte after the header of one binary, which the driver (and the recording GL) has to refuse.
+	for (const auto& entry : std::filesystem::directory_iterator(directory))
+	{
+		std::fstream file(entry.path(), std::ios::in | std::ios::out | std::ios::binary);
+		file.seekp(24);
+		file.put('\xff');
+		break;
+	}
+	const Pass corrupted = compileAll();
+	check(cold.valid && warm.valid && corrupted.valid, "the shader binary cache must build every shader");
+	check(warm.stats.compiles == 0 && corrupted.stats.binaryRejects == 1, "the shader binary cache must load intact binaries and reject the corrupted one");
+
+	// "u31992" and "u605430" have the same FNV-1a hash, so SetUniform couldn't tell them apart: the program must fail to build,
+	// and not be written to the binary cache.
+	gfx::ShaderSource colliding = gfx::default_unlit_color;
+	colliding.fragment.insert(colliding.fragment.find("void main"), "uniform float u31992;\nuniform float u605430;\n");
+	const size_t writesBefore = gfx::GetShaderCacheStats().binaryWrites;
+	gfx::ShaderHandle collidingHandle = gfx::CompileShader(colliding);
+	const bool collisionRejected = check(collidingHandle == 0 && gfx::GetShaderCacheStats().binaryWrites == writesBefore,
+		"a program with colliding uniform names must fail to build, and not be cached");
+	gfx::DeleteShader(collidingHandle);
+
+	gfx::shaderCacheDirectory.clear();
+	std::filesystem::remove_all(directory);
+
+	auto print = [](const char* label, const Pass& pass)
+	{
+		std::cout << label << pass.stats.compiles << " compiled, " << pass.stats.binaryLoads << " from binaries, " << pass.stats.binaryRejects
+				  << " rejected, " << pass.stats.binaryWrites << " written, " << pass.calls << " GL calls" << (pass.valid ? "" : " (FAILED)") << std::endl;
+	};
+	std::cout << "shader binary cache:" << std::endl;
+	print("  cold:                  ", cold);
+	print("  warm:                  ", warm);
+	print("  one corrupted:         ", corrupted);
+	std::cout << "  uniform hash clash:    " << (collisionRejected ? "rejected" : "NOT REJECTED") << std::endl;
+}
+
+// Builds the built-in shaders through a ShaderCompiler, with and without KHR_parallel_shader_compile: how many Polls (frames)
+// it takes until all are ready. The recording GL finishes every compile at once, so with the extension one Poll is enough.
+void benchmark_shader_compiler()
+{
+	const gfx::ShaderSource* sources[] = { &gfx::default_unlit_texture, &gfx::default_unlit_color, &gfx::default_lit_color, &gfx::default_lit_color_instanced };
+
+	auto compileAll = [&](bool parallel)
+	{
+		const GLboolean supported = __GLEW_KHR_parallel_shader_compile;
+		__GLEW_KHR_parallel_shader_compile = parallel ? GL_TRUE : GL_FALSE;
+
+		gfx::ShaderCompiler compiler;
+		std::vector<gfx::ShaderCompileTicket> tickets;
+		for (const gfx::ShaderSource* source : sources)
+		{
+			tickets.push_back(compiler.Request(*source));
+		}
+
+		int polls = 0;
+		while (compiler.Pending() != 0)
+		{
+			compiler.Poll();
+			++polls;
+		}
+
+		size_t ready = 0;
+		for (auto ticket : tickets)
+		{
+			ready += compiler.IsReady(ticket) && compiler.Get(ticket) != 0;
+		}
+		compiler.Clear();
+
+		__GLEW_KHR_parallel_shader_compile = supported;
+		check(ready == tickets.size(), "ShaderCompiler must build every shader");
+		std::cout << "  " << (parallel ? "parallel compile:      " : "serial compile:        ") << ready << "/" << tickets.size()
+				  << " ready after " << polls << " polls" << std::endl;
+	};
+
+	std::cout << "async shader compile:" << std::endl;
+	compileAll(true);
+	compileAll(false);
+}
+
+// Builds every variant of default_shader through ShaderVariants and checks each reflects exactly its features' vertex
+// attributes. A second pass over the keys must find them all cached and compile nothing.
+void benchmark_shader_variants()
+{
+	const uint32_t keyCount = 1u << gfx::ShaderFeature_Count;
+	gfx::ShaderVariants variants;
+
+	auto compileAll = [&]()
+	{
+		const size_t before = gfx::GetShaderCacheStats().compiles;
+		size_t valid = 0;
+		for (gfx::ShaderVariantKey key = 0; key < keyCount; ++key)
+		{
+			// Position, plus normal, uv and color for their features, plus the 4 instance attributes.
+			const size_t expected = 1 + ((key & gfx::ShaderFeature_Lit) != 0) + ((key & gfx::ShaderFeature_Texture) != 0) +
+				((key & gfx::ShaderFeature_VertexColor) != 0) + ((key & gfx::ShaderFeature_Instanced) != 0 ? 4 : 0);
+			const gfx::ShaderHandle handle = variants.Get(key);
+			valid += handle != 0 && gfx::GetShaderVertexAttributes(handle).size() == expected;
+		}
+		return std::make_pair(valid, gfx::GetShaderCacheStats().compiles - before);
+	};
+
+	const auto cold = compileAll();
+	const auto warm = compileAll();
+	variants.Clear();
+
+	// Requested from a compiler first: Get must wait for those requests instead of returning 0 or compiling again.
+	gfx::ShaderCompiler compiler;
+	for (gfx::ShaderVariantKey key = 0; key < keyCount; ++key)
+	{
+		variants.Get(key, compiler, 0);
+	}
+	const auto pending = compileAll();
+	const bool invalidKey = check(variants.Get(keyCount) == 0 && variants.Get(keyCount, compiler, 0) == 0,
+		"ShaderVariants must reject keys outside the variant table");
+	check(cold.first == keyCount && warm.first == keyCount && warm.second == 0, "ShaderVariants must build every variant once");
+	check(pending.first == keyCount && variants.Count() == keyCount, "ShaderVariants::Get must finish pending requests instead of building again");
+
+	std::cout << "shader variants:" << std::endl;
+	std::cout << "  first pass:            " << cold.first << "/" << keyCount << " valid, " << cold.second << " compiles" << std::endl;
+	std::cout << "  second pass:           " << warm.first << "/" << keyCount << " valid, " << warm.second << " compiles" << std::endl;
+	std::cout << "  after async requests:  " << pending.first << "/" << keyCount << " valid, " << variants.Count() << " built" <<
+		(invalidKey ? "" : ", invalid key not rejected") << std::endl;
+	variants.Clear();
+	compiler.Clear();
+}
+
+// Runs the game on every render path with a uniform ring that starts small, so it orphans its storage every frame or two.
+// The recording GL counts draws reading a Frame or Object range orphaned after it was bound; there must be none.
+void benchmark_uniform_ring(int objectCount, int frameCount)
+{
+	struct RenderPath
+	{
+		const char*	label;
+		bool		instancing;
+		bool		commandBuffers;
+	};
+	const RenderPath paths[] =
+	{
+		{ "instanced:             ", true, true },
+		{ "recorded:              ", false, true },
+		{ "per object:            ", false, false },
+	};
+
+	const bool savedInstancing = useInstancing;
+	const bool savedCommandBuffers = useCommandBuffers;
+	const size_t savedRingSize = uniformRingSize;
+
+	std::cout << "uniform ring wrap:" << std::endl;
+	for (const RenderPath& path : paths)
+	{
+		useInstancing = path.instancing;
+		useCommandBuffers = path.commandBuffers;
+		uniformRingSize = 64 * 1024;
+		// Same scripted flight on every path.
+		camera = Camera(glm::vec3(0, 1, 3));
+
+		begin_game(1280, 720);
+		populate_grid(objectCount);
+		recording::ResetStats();
+		for (int frame = 0; frame < frameCount; ++frame)
+		{
+			const GameInput input = scripted_input(frame, frameCount);
+			update_game(input, frameDelta);
+			render_game(input);
+		}
+		const recording::GLStats stats = recording::Stats();
+		end_game();
+
+		std::cout << "  " << path.label << stats.uniformBufferOrphans << " orphans, " << stats.staleUniformDraws << "/"
+				  << stats.drawCalls << " draws with a stale uniform block" << std::endl;
+		check(stats.staleUniformDraws == 0, "no draw may read a uniform range orphaned after it was bound");
+	}
+
+	useInstancing = savedInstancing;
+	useCommandBuffers = savedCommandBuffers;
+	uniformRingSize = savedRingSize;
+}
+
+int main(int argc, char** argv)
+{
+	int frameCount = 1000;
+	int objectCount = 1024;
+	int uploadCount = 1000;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)			frameCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--objects") == 0 && i + 1 < argc)		objectCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--uploads") == 0 && i + 1 < argc)		uploadCount = atoi(argv[++i]);
+		else if (strcmp(argv[i], "--no-instancing") == 0)				useInstancing = false;
+		else if (strcmp(argv[i], "--no-culling") == 0)					useCulling = false;
+		else if (strcmp(argv[i], "--no-multi-draw") == 0)				useMultiDraw = false;
+		else if (strcmp(argv[i], "--no-lod") == 0)						useLod = false;
+		else if (strcmp(argv[i], "--no-command-buffers") == 0)			useCommandBuffers = false;
+		else if (strcmp(argv[i], "--no-optimize") == 0)					gfx::optimizeCachedMeshes = false;
+		// Pretend the driver lacks GL_ARB_multi_draw_indirect, to measure the GL 3.3 fallback.
+		else if (strcmp(argv[i], "--no-indirect") == 0)					__GLEW_ARB_multi_draw_indirect = GL_FALSE;
+		else
+		{
+			std::cerr << "Usage: " << argv[0] << " [--frames N] [--objects N] [--uploads N] [--no-instancing] [--no-culling] [--no-multi-draw] [--no-lod] [--no-command-buffers] [--no-optimize] [--no-indirect]" << std::endl;
+			return 1;
+		}
+	}
+
+	if (frameCount <= 0 || objectCount < 0 || uploadCount <= 0)
+	{
+		std::cerr << "--frames and --uploads must be positive and --objects must not be negative" << std::endl;
+		return 1;
+	}
+
+	begin_game(1280, 720);
+	populate_grid(objectCount);
+
+	recording::ResetStats();
+	const gfx::GLStateStats stateBefore = gfx::GetGLStateStats();
+
+	size_t queueItems = 0;
+	size_t queueBatches = 0;
+	size_t queueStateChanges = 0;
+
+	const auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < frameCount; ++frame)
+	{
+		const GameInput input = scripted_input(frame, frameCount);
+		update_game(input, frameDelta);
+		render_game(input);
+
+		// Without instancing the draws are recorded into commandQueue instead, which doesn't batch.
+		queueItems += renderQueue.Stats().items + commandQueue.Stats().commands;
+		queueBatches += renderQueue.Stats().batches;
+		queueStateChanges += renderQueue.Stats().stateChanges() + commandQueue.Stats().shaderChanges;
+	}
+	const auto end = std::chrono::steady_clock::now();
+
+	const recording::GLStats stats = recording::Stats();
+	const gfx::GLStateStats stateAfter = gfx::GetGLStateStats();
+	const double frames = frameCount;
+	const double milliseconds = std::chrono::duration<double, std::milli>(end - start).count();
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "frames:                  " << frameCount << std::endl;
+	std::cout << "draw calls in scene:     " << drawCalls.size() << std::endl;
+	std::cout << "visible draw calls/frame: " << queueItems / frames << std::endl;
+	std::cout << "cpu ms/frame:            " << milliseconds / frames << std::endl;
+	std::cout << "gl calls/frame:          " << stats.calls / frames << std::endl;
+	std::cout << "gl draws/frame:          " << stats.drawCalls / frames << std::endl;
+	std::cout << "triangles/frame:         " << stats.trianglesDrawn / frames << std::endl;
+	std::cout << "uniform uploads/frame:   " << stats.uniformUploads / frames << std::endl;
+	std::cout << "state changes/frame:     " << stats.stateChanges / frames << std::endl;
+	std::cout << "elided state calls/frame: " << (stateAfter.elided - stateBefore.elided) / frames << " of "
+			  << (stateAfter.calls - stateBefore.calls) / frames << std::endl;
+	std::cout << "buffer bytes/frame:      " << stats.bufferUploadBytes / frames << std::endl;
+	std::cout << "queue batches/frame:     " << queueBatches / frames << std::endl;
+	std::cout << "queue state changes/frame: " << queueStateChanges / frames << std::endl;
+
+	end_game();
+
+	benchmark_uniform_ring(objectCount, std::min(frameCount, 100));
+	benchmark_uploads(uploadCount, gfx::VertexFormat_Float, UploadMode_Separate, "float");
+	benchmark_uploads(uploadCount, gfx::VertexFormat_Compact, UploadMode_Separate, "compact");
+	benchmark_uploads(uploadCount, gfx::VertexFormat_Compact, UploadMode_Pooled, "compact, pooled");
+	benchmark_uploads(uploadCount, gfx::VertexFormat_Compact, UploadMode_Cached, "compact, pooled, cached");
+	benchmark_generation(64);
+	benchmark_mesh_files(64);
+	benchmark_import();
+	benchmark_shader_cache();
+	benchmark_shader_compiler();
+	benchmark_shader_variants();
+	benchmark_vertex_cache("sphere 4", gfx::primitive::DescribeSphere(4, 0.5f));
+	benchmark_vertex_cache("cylinder 64", gfx::primitive::DescribeCylinder(0.5f, 1.0f, 64));
+	benchmark_vertex_cache("capsule 64x64", gfx::primitive::DescribeCapsule(0.5f, 1.0f, 64, 64, 4));
+	benchmark_strip_optimize();
+	benchmark_primitive_throughput("capsule 512x512", [] { return gfx::primitive::Capsule(0.5f, 1.0f, 512, 512, 8); });
+	benchmark_primitive_throughput("cylinder 65536", [] { return gfx::primitive::Cylinder(0.5f, 1.0f, 65536); });
+
+	return checksFailed ? 1 : 0;
+}
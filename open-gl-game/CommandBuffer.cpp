@@ -0,0 +1,102 @@
+#include <cstring>
+#include "CommandBuffer.h"
+
+namespace gfx
+{
+	void CommandBuffer::Reset()
+	{
+		commands.clear();
+		payloads.clear();
+	}
+
+	void CommandBuffer::Draw(uint64_t key, ShaderHandle shader, const Mesh& mesh, const void* uniforms, size_t size)
+	{
+		const size_t offset = payloads.size();
+		payloads.resize(offset + size);
+		memcpy(payloads.data() + offset, uniforms, size);
+		commands.push_back({ key, shader, mesh, static_cast<uint32_t>(offset), static_cast<uint32_t>(size) });
+	}
+
+	void CommandQueue::Begin(size_t count)
+	{
+		if (buffers.size() < count)
+		{
+			buffers.resize(count);
+		}
+		bufferCount = count;
+		for (size_t i = 0; i < bufferCount; ++i)
+		{
+			buffers[i].Reset();
+		}
+	}
+
+	void CommandQueue::Clear()
+	{
+		for (CommandBuffer& buffer : buffers)
+		{
+			buffer.Reset();
+		}
+		bufferCount = 0;
+		stats = CommandQueueStats{};
+	}
+
+	void CommandQueue::Submit(UniformRingBuffer& ring, GLuint binding)
+	{
+		stats = CommandQueueStats{};
+		stats.buffers = bufferCount;
+
+		recorded.clear();
+		sortEntries.clear();
+		for (size_t b = 0; b < bufferCount; ++b)
+		{
+			const CommandBuffer& buffer = buffers[b];
+			for (const DrawCommand& command : buffer.Commands())
+			{
+				sortEntries.push_back({ command.key, static_cast<uint32_t>(recorded.size()) });
+				recorded.push_back({ &command, buffer.Payload(command) });
+				stats.payloadBytes += ring.AlignedSize(command.payloadSize);
+			}
+		}
+
+		stats.commands = recorded.size();
+		if (recorded.empty())
+		{
+			return;
+		}
+
+		RadixSort(sortEntries, sortScratch);
+
+		// Payloads go into the ring in draw order, so consecutive draws read consecutive ranges.
+		size_t payloadsOffset = 0;
+		char* payloads = ring.Map(stats.payloadBytes, payloadsOffset);
+		size_t offset = 0;
+		for (const SortEntry& entry : sortEntries)
+		{
+			const RecordedCommand& recordedCommand = recorded[entry.index];
+			memcpy(payloads + offset, recordedCommand.payload, recordedCommand.command->payloadSize);
+			offset += ring.AlignedSize(recordedCommand.command->payloadSize);
+		}
+		ring.Unmap();
+
+		ShaderHandle shader = 0;
+		offset = payloadsOffset;
+		for (const SortEntry& entry : sortEntries)
+		{
+			const DrawCommand& command = *recorded[entry.index].command;
+			if (command.shader != shader || stats.shaderChanges == 0)
+			{
+				shader = command.shader;
+				UseShader(shader);
+				++stats.shaderChanges;
+			}
+
+			BindMesh(command.mesh);
+			if (command.payloadSize > 0)
+			{
+				ring.BindRange(binding, offset, command.payloadSize);
+			}
+			DrawBoundMesh(command.mesh);
+			offset += ring.AlignedSize(command.payloadSize);
+		}
+	}
+}
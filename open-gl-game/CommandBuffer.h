@@ -0,0 +1,93 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include "Mesh.h"
+#include "RenderQueue.h"
+#include "Shader.h"
+#include "UniformBuffer.h"
+
+namespace gfx
+{
+	// One recorded draw. Its uniform payload lives in the CommandBuffer that recorded it.
+	struct DrawCommand
+	{
+		// See MakeSortKey.
+		uint64_t		key;
+		ShaderHandle	shader;
+		Mesh			mesh;
+		uint32_t		payloadOffset;
+		uint32_t		payloadSize;
+	};
+
+	// Draws recorded without touching GL, so any thread can fill one, to be replayed later by the thread owning the context.
+	// A buffer must only be written by one thread at a time. Commands and payloads are appended to arrays that keep their
+	// capacity across Reset, so recording a frame like the last one allocates nothing.
+	class CommandBuffer
+	{
+	public:
+		void Reset();
+
+		// Records a draw of {mesh} with {shader}, with {size} bytes of uniform block data to bind while it draws.
+		void Draw(uint64_t key, ShaderHandle shader, const Mesh& mesh, const void* uniforms, size_t size);
+		template<typename Uniforms>
+		inline void Draw(uint64_t key, ShaderHandle shader, const Mesh& mesh, const Uniforms& uniforms)
+		{
+			Draw(key, shader, mesh, &uniforms, sizeof(Uniforms));
+		}
+
+		inline const std::vector<DrawCommand>& Commands() const { return commands; }
+		inline const char* Payload(const DrawCommand& command) const { return payloads.data() + command.payloadOffset; }
+
+	private:
+		std::vector<DrawCommand>	commands;
+		std::vector<char>			payloads;
+	};
+
+	struct CommandQueueStats
+	{
+		size_t buffers;
+		size_t commands;
+		size_t shaderChanges;
+		size_t payloadBytes;
+	};
+
+	// CommandBuffers recorded in parallel, one per job, then submitted together on the GL thread.
+	class CommandQueue
+	{
+	public:
+		// Resets the buffers and makes sure there are {bufferCount} of them. Not thread safe: call before recording starts.
+		void Begin(size_t bufferCount);
+		// Resets every buffer and the stats.
+		void Clear();
+
+		// Thread safe for distinct {index}es.
+		inline CommandBuffer& Buffer(size_t index) { return buffers[index]; }
+		inline size_t BufferCount() const { return bufferCount; }
+
+		// GL thread only. Sorts the commands of all buffers by key (equal keys keep buffer, then recording order), writes every
+		// payload with one mapping of {ring} and draws them in order, binding each payload to uniform block binding {binding}.
+		// Programs are only bound when they change; the GL state cache skips rebinding the same VAO.
+		// If that mapping orphans {ring}, ranges bound from it earlier in the frame go stale: when something (like the Frame
+		// block) is bound before Submit, Reserve the payloads together with it first. Stats().payloadBytes of a similar frame
+		// is what Submit maps.
+		void Submit(UniformRingBuffer& ring, GLuint binding);
+
+		inline const CommandQueueStats& Stats() const { return stats; }
+
+	private:
+		struct RecordedCommand
+		{
+			const DrawCommand*	command;
+			const char*			payload;
+		};
+
+		std::vector<CommandBuffer>		buffers;
+		size_t							bufferCount = 0;
+		// The commands of every buffer, in buffer order, indexed by the sort entries.
+		std::vector<RecordedCommand>	recorded;
+		std::vector<SortEntry>			sortEntries;
+		std::vector<SortEntry>			sortScratch;
+		CommandQueueStats				stats{};
+	};
+}
@@ -0,0 +1,191 @@
+#include <bit>
+#include "Culling.h"
+
+#if defined(__AVX__)
+#define GFX_CULL_AVX 1
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFX_CULL_SSE 1
+#endif
+
+#if defined(GFX_CULL_AVX) || defined(GFX_CULL_SSE)
+#include <immintrin.h>
+#endif
+
+namespace gfx
+{
+	Frustum ExtractFrustum(const glm::mat4& viewProjection)
+	{
+		// glm is column major, row i of the matrix is (m[0][i], m[1][i], m[2][i], m[3][i]).
+		auto row = [&viewProjection](int i)
+		{
+			return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+		};
+
+		const glm::vec4 x = row(0);
+		const glm::vec4 y = row(1);
+		const glm::vec4 z = row(2);
+		const glm::vec4 w = row(3);
+
+		// Clip space is -w <= x, y, z <= w.
+		Frustum frustum;
+		frustum.planes[0] = w + x;
+		frustum.planes[1] = w - x;
+		frustum.planes[2] = w + y;
+		frustum.planes[3] = w - y;
+		frustum.planes[4] = w + z;
+		frustum.planes[5] = w - z;
+
+		for (glm::vec4& plane : frustum.planes)
+		{
+			plane /= glm::length(glm::vec3(plane));
+		}
+		return frustum;
+	}
+
+	void TransformBounds(const glm::vec3& min, const glm::vec3& max, const glm::mat4& transform, glm::vec3& outMin, glm::vec3& outMax)
+	{
+		// Transform the center, and project the extents onto each world axis (Arvo).
+		const glm::vec3 center = (min + max) * 0.5f;
+		const glm::vec3 extents = (max - min) * 0.5f;
+
+		const glm::vec3 worldCenter = glm::vec3(transform * glm::vec4(center, 1.0f));
+		const glm::vec3 worldExtents =
+			glm::abs(glm::vec3(transform[0])) * extents.x +
+			glm::abs(glm::vec3(transform[1])) * extents.y +
+			glm::abs(glm::vec3(transform[2])) * extents.z;
+
+		outMin = worldCenter - worldExtents;
+		outMax = worldCenter + worldExtents;
+	}
+
+	void CullingSet::Clear()
+	{
+		minX.clear();
+		minY.clear();
+		minZ.clear();
+		maxX.clear();
+		maxY.clear();
+		maxZ.clear();
+	}
+
+	void CullingSet::Reserve(size_t count)
+	{
+		minX.reserve(count);
+		minY.reserve(count);
+		minZ.reserve(count);
+		maxX.reserve(count);
+		maxY.reserve(count);
+		maxZ.reserve(count);
+	}
+
+	uint32_t CullingSet::Add(const glm::vec3& min, const glm::vec3& max)
+	{
+		minX.push_back(min.x);
+		minY.push_back(min.y);
+		minZ.push_back(min.z);
+		maxX.push_back(max.x);
+		maxY.push_back(max.y);
+		maxZ.push_back(max.z);
+		return static_cast<uint32_t>(minX.size() - 1);
+	}
+
+	void CullingSet::Set(uint32_t index, const glm::vec3& min, const glm::vec3& max)
+	{
+		minX[index] = min.x;
+		minY[index] = min.y;
+		minZ[index] = min.z;
+		maxX[index] = max.x;
+		maxY[index] = max.y;
+		maxZ[index] = max.z;
+	}
+
+	void CullingSet::Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const
+	{
+		// A box is outside a plane when its corner furthest along the plane normal is.
+		// Which of min or max that corner takes on each axis only depends on the sign of the normal,
+		// so the choice is made once per plane and the box loop is plain multiply-adds over the arrays.
+		struct PlaneTest
+		{
+			const float* x;
+			const float* y;
+			const float* z;
+			glm::vec4 plane;
+		};
+
+		PlaneTest tests[6];
+		for (int p = 0; p < 6; ++p)
+		{
+			const glm::vec4& plane = frustum.planes[p];
+			tests[p].x = plane.x >= 0.0f ? maxX.data() : minX.data();
+			tests[p].y = plane.y >= 0.0f ? maxY.data() : minY.data();
+			tests[p].z = plane.z >= 0.0f ? maxZ.data() : minZ.data();
+			tests[p].plane = plane;
+		}
+
+		const size_t count = Size();
+		visible.resize(count);
+		uint32_t* out = visible.data();
+		size_t visibleCount = 0;
+		size_t i = 0;
+
+#if defined(GFX_CULL_AVX)
+		for (; i + 8 <= count; i += 8)
+		{
+			__m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+			for (const PlaneTest& test : tests)
+			{
+				__m256 distance = _mm256_set1_ps(test.plane.w);
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_loadu_ps(test.x + i), _mm256_set1_ps(test.plane.x)));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_loadu_ps(test.y + i), _mm256_set1_ps(test.plane.y)));
+				distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_loadu_ps(test.z + i), _mm256_set1_ps(test.plane.z)));
+				inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_GE_OQ));
+			}
+
+			for (unsigned int mask = _mm256_movemask_ps(inside); mask != 0; mask &= mask - 1)
+			{
+				out[visibleCount++] = static_cast<uint32_t>(i + std::countr_zero(mask));
+			}
+		}
+#endif
+
+#if defined(GFX_CULL_SSE)
+		for (; i + 4 <= count; i += 4)
+		{
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (const PlaneTest& test : tests)
+			{
+				__m128 distance = _mm_set1_ps(test.plane.w);
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(test.x + i), _mm_set1_ps(test.plane.x)));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(test.y + i), _mm_set1_ps(test.plane.y)));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(test.z + i), _mm_set1_ps(test.plane.z)));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, _mm_setzero_ps()));
+			}
+
+			for (unsigned int mask = _mm_movemask_ps(inside); mask != 0; mask &= mask - 1)
+			{
+				out[visibleCount++] = static_cast<uint32_t>(i + std::countr_zero(mask));
+			}
+		}
+#endif
+
+		// Remaining boxes, or all of them without SIMD.
+		for (; i < count; ++i)
+		{
+			bool inside = true;
+			for (const PlaneTest& test : tests)
+			{
+				const float distance = test.plane.w + test.x[i] * test.plane.x + test.y[i] * test.plane.y + test.z[i] * test.plane.z;
+				inside &= distance >= 0.0f;
+			}
+
+			if (inside)
+			{
+				out[visibleCount++] = static_cast<uint32_t>(i);
+			}
+		}
+
+		visible.resize(visibleCount);
+	}
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace gfx
+{
+	// Left, right, bottom, top, near and far planes as (normal, distance) with normals pointing inwards:
+	// a point p is on the inside of a plane when dot(plane.xyz, p) + plane.w >= 0.
+	struct Frustum
+	{
+		glm::vec4 planes[6];
+	};
+
+	// Extracts the planes of the view volume of {viewProjection} (Gribb & Hartmann), in world space.
+	Frustum ExtractFrustum(const glm::mat4& viewProjection);
+
+	// Axis aligned box enclosing the box {min, max} transformed by {transform}.
+	void TransformBounds(const glm::vec3& min, const glm::vec3& max, const glm::mat4& transform, glm::vec3& outMin, glm::vec3& outMax);
+
+	// World space AABBs stored as a structure of arrays, so Cull can test 4 (SSE) or 8 (AVX) boxes per plane at once.
+	class CullingSet
+	{
+	public:
+		void Clear();
+		void Reserve(size_t count);
+		// Returns the index Cull reports the box as.
+		uint32_t Add(const glm::vec3& min, const glm::vec3& max);
+		void Set(uint32_t index, const glm::vec3& min, const glm::vec3& max);
+		inline size_t Size() const { return minX.size(); }
+
+		// Replaces the contents of {visible} with the indices, in increasing order, of the boxes not fully outside a plane of {frustum}.
+		// The test is conservative: a box outside the frustum but near one of its edges can be reported visible.
+		void Cull(const Frustum& frustum, std::vector<uint32_t>& visible) const;
+
+	private:
+		std::vector<float> minX;
+		std::vector<float> minY;
+		std::vector<float> minZ;
+		std::vector<float> maxX;
+		std::vector<float> maxY;
+		std::vector<float> maxZ;
+	};
+}
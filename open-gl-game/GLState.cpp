@@ -0,0 +1,316 @@
+#include <cstring>
+#include "GLState.h"
+
+namespace gfx
+{
+	// Shadowed state that is not known is all bits set, which is no valid name or enum, so the next setter call reaches GL.
+	const GLuint unknownState = 0xFFFFFFFF;
+	const GLuint shadowedTextureUnits = 16;
+	const GLuint shadowedUniformBindings = 16;
+
+	struct UniformBufferRange
+	{
+		GLuint	buffer;
+		size_t	offset;
+		size_t	size;
+	};
+
+	struct GLStateShadow
+	{
+		GLuint				program;
+		GLuint				vao;
+		// Indexed by bufferTargetIndex.
+		GLuint				buffers[6];
+		UniformBufferRange	uniformRanges[shadowedUniformBindings];
+		GLuint				activeTextureUnit;
+		// Indexed by unit, then textureTargetIndex.
+		GLuint				textures[shadowedTextureUnits][4];
+		GLuint				polygonMode;
+		// Indexed by capabilityIndex.
+		GLuint				enabled[3];
+		GLuint				cullFace;
+		GLuint				depthFunc;
+		GLuint				depthMask;
+		GLuint				blendSource;
+		GLuint				blendDestination;
+	};
+
+	GLStateShadow unknownShadow()
+	{
+		GLStateShadow shadow;
+		memset(&shadow, 0xFF, sizeof(shadow));
+		return shadow;
+	}
+
+	GLStateShadow shadow = unknownShadow();
+	GLStateStats glStateStats{};
+
+	int bufferTargetIndex(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_ARRAY_BUFFER:			return 0;
+		case GL_ELEMENT_ARRAY_BUFFER:	return 1;
+		case GL_COPY_READ_BUFFER:		return 2;
+		case GL_COPY_WRITE_BUFFER:		return 3;
+		case GL_UNIFORM_BUFFER:			return 4;
+		case GL_DRAW_INDIRECT_BUFFER:	return 5;
+		default:						return -1;
+		}
+	}
+
+	int textureTargetIndex(GLenum target)
+	{
+		switch (target)
+		{
+		case GL_TEXTURE_2D:			return 0;
+		case GL_TEXTURE_3D:			return 1;
+		case GL_TEXTURE_CUBE_MAP:	return 2;
+		case GL_TEXTURE_2D_ARRAY:	return 3;
+		default:					return -1;
+		}
+	}
+
+	int capabilityIndex(GLenum capability)
+	{
+		switch (capability)
+		{
+		case GL_DEPTH_TEST:	return 0;
+		case GL_CULL_FACE:	return 1;
+		case GL_BLEND:		return 2;
+		default:			return -1;
+		}
+	}
+
+	// Counts a setter call. Returns true, counting it elided, if {current} already is {value}; else stores {value}.
+	bool elide(GLuint& current, GLuint value)
+	{
+		++glStateStats.calls;
+		if (current == value)
+		{
+			++glStateStats.elided;
+			return true;
+		}
+		current = value;
+		return false;
+	}
+
+	void BindProgram(GLuint program)
+	{
+		if (!elide(shadow.program, program))
+		{
+			glUseProgram(program);
+		}
+	}
+
+	void BindVertexArray(GLuint vao)
+	{
+		if (!elide(shadow.vao, vao))
+		{
+			glBindVertexArray(vao);
+			shadow.buffers[bufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = unknownState;
+		}
+	}
+
+	void BindBuffer(GLenum target, GLuint buffer)
+	{
+		const int index = bufferTargetIndex(target);
+		if (index < 0)
+		{
+			++glStateStats.calls;
+			glBindBuffer(target, buffer);
+		}
+		else if (!elide(shadow.buffers[index], buffer))
+		{
+			glBindBuffer(target, buffer);
+		}
+	}
+
+	void BindUniformBufferRange(GLuint index, GLuint buffer, size_t offset, size_t size)
+	{
+		++glStateStats.calls;
+		GLuint& generic = shadow.buffers[bufferTargetIndex(GL_UNIFORM_BUFFER)];
+		if (index < shadowedUniformBindings)
+		{
+			UniformBufferRange& range = shadow.uniformRanges[index];
+			if (range.buffer == buffer && range.offset == offset && range.size == size && generic == buffer)
+			{
+				++glStateStats.elided;
+				return;
+			}
+			range = { buffer, offset, size };
+		}
+
+		glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer, offset, size);
+		generic = buffer;
+	}
+
+	void BindTexture(GLuint unit, GLenum target, GLuint texture)
+	{
+		const int index = textureTargetIndex(target);
+		if (unit < shadowedTextureUnits && index >= 0)
+		{
+			if (elide(shadow.textures[unit][index], texture))
+			{
+				return;
+			}
+		}
+		else
+		{
+			++glStateStats.calls;
+		}
+
+		if (shadow.activeTextureUnit != unit)
+		{
+			glActiveTexture(GL_TEXTURE0 + unit);
+			shadow.activeTextureUnit = unit;
+		}
+		glBindTexture(target, texture);
+	}
+
+	void SetPolygonMode(GLenum mode)
+	{
+		if (!elide(shadow.polygonMode, mode))
+		{
+			glPolygonMode(GL_FRONT_AND_BACK, mode);
+		}
+	}
+
+	void SetEnabled(GLenum capability, bool enabled)
+	{
+		const int index = capabilityIndex(capability);
+		if (index >= 0 && elide(shadow.enabled[index], enabled))
+		{
+			return;
+		}
+		if (index < 0)
+		{
+			++glStateStats.calls;
+		}
+
+		if (enabled)	glEnable(capability);
+		else			glDisable(capability);
+	}
+
+	void SetCullFace(GLenum face)
+	{
+		if (!elide(shadow.cullFace, face))
+		{
+			glCullFace(face);
+		}
+	}
+
+	void SetDepthFunc(GLenum func)
+	{
+		if (!elide(shadow.depthFunc, func))
+		{
+			glDepthFunc(func);
+		}
+	}
+
+	void SetDepthMask(bool write)
+	{
+		if (!elide(shadow.depthMask, write))
+		{
+			glDepthMask(write ? GL_TRUE : GL_FALSE);
+		}
+	}
+
+	void SetBlendFunc(GLenum source, GLenum destination)
+	{
+		++glStateStats.calls;
+		if (shadow.blendSource == source && shadow.blendDestination == destination)
+		{
+			++glStateStats.elided;
+			return;
+		}
+
+		shadow.blendSource = source;
+		shadow.blendDestination = destination;
+		glBlendFunc(source, destination);
+	}
+
+	void DeleteBuffer(GLuint& buffer)
+	{
+		if (buffer == 0)
+		{
+			return;
+		}
+
+		for (GLuint& bound : shadow.buffers)
+		{
+			if (bound == buffer) bound = 0;
+		}
+		for (UniformBufferRange& range : shadow.uniformRanges)
+		{
+			if (range.buffer == buffer) range.buffer = unknownState;
+		}
+
+		glDeleteBuffers(1, &buffer);
+		buffer = 0;
+	}
+
+	void DeleteVertexArray(GLuint& vao)
+	{
+		if (vao == 0)
+		{
+			return;
+		}
+
+		if (shadow.vao == vao)
+		{
+			// GL falls back to VAO 0, whose element array buffer we don't know.
+			shadow.vao = 0;
+			shadow.buffers[bufferTargetIndex(GL_ELEMENT_ARRAY_BUFFER)] = unknownState;
+		}
+
+		glDeleteVertexArrays(1, &vao);
+		vao = 0;
+	}
+
+	void DeleteTexture(GLuint& texture)
+	{
+		if (texture == 0)
+		{
+			return;
+		}
+
+		for (auto& unit : shadow.textures)
+		{
+			for (GLuint& bound : unit)
+			{
+				if (bound == texture) bound = 0;
+			}
+		}
+
+		glDeleteTextures(1, &texture);
+		texture = 0;
+	}
+
+	void DeleteProgram(GLuint& program)
+	{
+		if (program == 0)
+		{
+			return;
+		}
+
+		// A deleted program stays in use until another one is bound, but nothing may be drawn with it anymore.
+		if (shadow.program == program)
+		{
+			shadow.program = unknownState;
+		}
+
+		glDeleteProgram(program);
+		program = 0;
+	}
+
+	void ResetGLState()
+	{
+		shadow = unknownShadow();
+	}
+
+	GLStateStats GetGLStateStats()
+	{
+		return glStateStats;
+	}
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <cstddef>
+#include <GL/glew.h>
+
+namespace gfx
+{
+	// Shadow copy of the GL state the renderer changes: bound program, VAO, buffers and textures, polygon mode, and depth, cull
+	// and blend state. Every setter compares against the shadow and skips the GL call when it wouldn't change anything.
+	// Only valid while all of this state is changed through here. After anything else touched it (another library, a new
+	// context), call ResetGLState so the next call of every setter reaches GL again.
+	//
+	// The element array buffer binding belongs to the VAO, so binding a VAO forgets it.
+
+	struct GLStateStats
+	{
+		// Setter calls, and the part of them skipped because the state was already set.
+		size_t	calls;
+		size_t	elided;
+	};
+
+	void BindProgram(GLuint program);
+	void BindVertexArray(GLuint vao);
+	// GL_ARRAY_BUFFER, GL_ELEMENT_ARRAY_BUFFER, GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, GL_UNIFORM_BUFFER and
+	// GL_DRAW_INDIRECT_BUFFER are shadowed, other targets always reach GL.
+	void BindBuffer(GLenum target, GLuint buffer);
+	// Binds [offset, offset + size) of {buffer} to uniform block binding point {index}. Like glBindBufferRange, this also
+	// binds {buffer} to GL_UNIFORM_BUFFER.
+	void BindUniformBufferRange(GLuint index, GLuint buffer, size_t offset, size_t size);
+	// Binds {texture} to {target} of texture unit {unit}, switching the active unit only when needed.
+	// GL_TEXTURE_2D, GL_TEXTURE_3D, GL_TEXTURE_CUBE_MAP and GL_TEXTURE_2D_ARRAY of the first 16 units are shadowed.
+	void BindTexture(GLuint unit, GLenum target, GLuint texture);
+
+	void SetPolygonMode(GLenum mode);
+	// GL_DEPTH_TEST, GL_CULL_FACE or GL_BLEND.
+	void SetEnabled(GLenum capability, bool enabled);
+	void SetCullFace(GLenum face);
+	void SetDepthFunc(GLenum func);
+	void SetDepthMask(bool write);
+	void SetBlendFunc(GLenum source, GLenum destination);
+
+	// Delete the object and drop it from the shadow: GL unbinds a deleted object, and its name may come back for a new one.
+	void DeleteBuffer(GLuint& buffer);
+	void DeleteVertexArray(GLuint& vao);
+	void DeleteTexture(GLuint& texture);
+	void DeleteProgram(GLuint& program);
+
+	// Forgets all shadowed state.
+	void ResetGLState();
+	GLStateStats GetGLStateStats();
+}
@@ -0,0 +1,484 @@
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <GL/glew.h>
+
+#include "GLErrorCheck.h"
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "Game.h"
+#include "CommandBuffer.h"
+#include "GLState.h"
+#include "Shader.h"
+#include "Primitives.h"
+#include "MeshCache.h"
+#include "PrimitiveLoader.h"
+#include "UniformBuffer.h"
+#include "Culling.h"
+#include "Lod.h"
+
+float nearPlane = 0.1f;
+float farPlane = 100.0f;
+float fieldOfView = 70;
+bool useInstancing = true;
+bool useCulling = true;
+bool useMultiDraw = true;
+bool useLod = true;
+bool useCommandBuffers = true;
+
+gfx::ShaderHandle shader;
+glm::mat4 projection;
+glm::mat4 view;
+
+// Every material is opaque, so the variants skip the alpha test and keep early depth testing.
+constexpr gfx::ShaderVariantKey litVariant = gfx::MakeShaderVariantKey(gfx::ShaderFeature_Lit);
+constexpr gfx::ShaderVariantKey litInstancedVariant = gfx::MakeShaderVariantKey(gfx::ShaderFeature_Lit, gfx::ShaderFeature_Instanced);
+gfx::ShaderVariants shaderVariants;
+// The instanced variant is built in the background. Until it is ready every frame draws per object with {shader}.
+gfx::ShaderCompiler shaderCompiler;
+
+size_t meshUploadBudget = 1 << 20;
+size_t uniformRingSize = 1 << 20;
+
+// Primitives are generated on the job system's workers and uploaded by render_game, meshUploadBudget bytes per frame.
+gfx::JobSystem jobSystem;
+gfx::PrimitiveLoader primitiveLoader(jobSystem);
+
+// Frame and Object uniform blocks for the whole frame are streamed through here.
+gfx::UniformRingBuffer uniformRing;
+
+// Colors indexed by DrawCall::material.
+std::vector<glm::vec4> materials =
+{
+	glm::vec4(0.f, 1.f, 0.f, 1.f),
+	glm::vec4(1.f, 0.5f, 0.f, 1.f),
+	glm::vec4(0.2f, 0.4f, 1.f, 1.f),
+	glm::vec4(1.f, 1.f, 1.f, 1.f),
+};
+
+gfx::RenderQueue renderQueue;
+gfx::CommandQueue commandQueue;
+
+// Instances of the current mesh, collected for a single DrawMeshInstanced call. Kept between frames to reuse the allocation.
+std::vector<gfx::InstanceData> instances;
+// Commands of the VAO being collected by render_multi_draw, reading from instances.
+std::vector<gfx::DrawElementsIndirectCommand> multiDrawCommands;
+
+Camera camera(glm::vec3(0, 1, 3));
+
+// Meshes are owned here, draw calls only reference them.
+std::vector<gfx::Mesh> meshes;
+// Level chains of the meshes that have a resolution, indexed by DrawCall::lod.
+std::vector<gfx::LodMesh> lodMeshes;
+std::vector<DrawCall> drawCalls;
+
+// World space bounds of drawCalls, same order.
+gfx::CullingSet drawCallBounds;
+// Indices of the draw calls that passed culling this frame.
+std::vector<uint32_t> visibleDrawCalls;
+
+// The LOD mesh of meshes[{index}], or -1 if it has a single level.
+int mesh_lod(size_t index)
+{
+	return lodMeshes[index].levelCount > 1 ? (int)index : -1;
+}
+
+void begin_game(int width, int height)
+{
+	// A new context starts from GL's defaults, not from whatever the state cache saw last.
+	gfx::ResetGLState();
+	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
+	gfx::SetCullFace(GL_BACK);
+	gfx::SetEnabled(GL_DEPTH_TEST, true);
+
+	shader = shaderVariants.Get(litVariant);
+	shaderVariants.Get(litInstancedVariant, shaderCompiler, 0);
+	uniformRing.Create(uniformRingSize);
+	GL_ERRORCHECK();
+	// The lit shader only needs positions and normals, so store them quantized (12 bytes per vertex).
+	// Pooled, so meshes with the same attributes share a VAO and buffers, and cached, so asking for the same primitive again is free.
+	// Generated in parallel, the scene needs them all before the first frame.
+	jobSystem.Start();
+	const gfx::PrimitiveDesc primitives[] =
+	{
+		gfx::primitive::DescribeQuad(1.0f, 1.0f),
+		gfx::primitive::DescribeBox(1.0f, 1.0f, 1.0f),
+		gfx::primitive::DescribeSphere(2, 0.5f),
+		gfx::primitive::DescribeCylinder(0.5f, 1.0f, 16),
+		gfx::primitive::DescribeCapsule(0.5f, 1.0f, 16, 16, 0),
+	};
+	std::vector<gfx::PrimitiveLoadTicket> tickets;
+	for (const auto& primitive : primitives)
+	{
+		tickets.push_back(primitiveLoader.Request(primitive, gfx::VertexFormat_Compact));
+	}
+	primitiveLoader.Finish();
+
+	meshes.clear();
+	for (auto ticket : tickets)
+	{
+		meshes.push_back(primitiveLoader.Take(ticket));
+	}
+
+	// The finest levels are the meshes loaded above, the coarser ones are small enough to generate here.
+	lodMeshes.clear();
+	for (const auto& primitive : primitives)
+	{
+		lodMeshes.push_back(gfx::CreateLodMesh(primitive, gfx::MaxLodLevels, gfx::VertexFormat_Compact));
+	}
+
+	drawCalls.clear();
+	// Signed, since it also places the meshes left of the origin.
+	const int meshCount = static_cast<int>(meshes.size());
+	for (int index = 0; index < meshCount; ++index)
+	{
+		drawCalls.push_back({ meshes[index], glm::translate(glm::identity<glm::mat4>(), glm::vec3(-3 + index * 2, 0, 0)), 0, mesh_lod(index) });
+		//* glm::rotate(glm::identity<glm::mat4>(), (float)((SDL_GetTicks() / 100) % 360), glm::vec3(0.f, 1.f, 0.f));
+	}
+	update_draw_call_bounds();
+
+	projection = glm::perspective(	glm::radians(fieldOfView),			// The vertical Field of View in radians (the amount of "zoom").
+									(float) width / (float) height,		// Aspect Ratio.
+									nearPlane,							// Near clipping plane. Keep as big as possible, or you'll get precision issues.
+									farPlane);							// Far clipping plane. Keep as little as possible.
+
+	//view = glm::translate(glm::identity<glm::mat4>(), glm::vec3(0, 0, -5));
+	glm::vec3 cameraPosition = glm::vec3(0, 1, -3);
+	view = glm::translate(glm::identity<glm::mat4>(), cameraPosition) *
+			glm::lookAt(cameraPosition, glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+	auto attribs = gfx::GetShaderVertexAttributes(shader);
+
+	for (const auto& attrib : attribs)
+	{
+		std::cout << attrib.name << ": size=" << attrib.size << ", type=" << attrib.type << ", location=" << attrib.location << std::endl;
+	}
+
+	GL_ERRORCHECK();
+}
+
+void populate_grid(int count)
+{
+	const int columns = glm::max(1, (int)std::ceil(std::sqrt((float)count)));
+	for (int i = 0; i < count; ++i)
+	{
+		const glm::vec3 position(-columns + (i % columns) * 2, 0, -2 - (i / columns) * 2);
+		drawCalls.push_back({ meshes[i % meshes.size()], glm::translate(glm::identity<glm::mat4>(), position), (uint32_t)((i / meshes.size()) % materials.size()), mesh_lod(i % meshes.size()) });
+	}
+	update_draw_call_bounds();
+}
+
+void update_draw_call_bounds()
+{
+	drawCallBounds.Clear();
+	drawCallBounds.Reserve(drawCalls.size());
+	for (const auto& drawcall : drawCalls)
+	{
+		glm::vec3 min, max;
+		gfx::TransformBounds(drawcall.mesh.boundsMin, drawcall.mesh.boundsMax, drawcall.matrix, min, max);
+		drawCallBounds.Add(min, max);
+	}
+}
+
+void update_game(const GameInput& input, double deltaTime)
+{
+	if (input.up)		camera.ProcessKeyboard(Camera_Movement::FORWARD, deltaTime);
+	if (input.down)		camera.ProcessKeyboard(Camera_Movement::BACKWARD, deltaTime);
+	if (input.right)	camera.ProcessKeyboard(Camera_Movement::RIGHT, deltaTime);
+	if (input.left)		camera.ProcessKeyboard(Camera_Movement::LEFT, deltaTime);
+	if (input.rightMouse)
+	{
+		camera.ProcessMouseMovement(input.mouseDelta.x, -input.mouseDelta.y);
+	}
+}
+
+// The mesh to draw {drawcall} with this frame, updating its LOD level. {projectionScale} is projection[1][1], see gfx::ScreenSize.
+const gfx::Mesh& select_lod(DrawCall& drawcall, float projectionScale)
+{
+	const gfx::Mesh* mesh = &drawcall.mesh;
+	if (useLod && drawcall.lod >= 0)
+	{
+		const gfx::LodMesh& lod = lodMeshes[drawcall.lod];
+		const float scale = glm::sqrt(glm::max(glm::max(
+			glm::dot(glm::vec3(drawcall.matrix[0]), glm::vec3(drawcall.matrix[0])),
+			glm::dot(glm::vec3(drawcall.matrix[1]), glm::vec3(drawcall.matrix[1]))),
+			glm::dot(glm::vec3(drawcall.matrix[2]), glm::vec3(drawcall.matrix[2]))));
+		const glm::vec3 center = glm::vec3(drawcall.matrix * glm::vec4(lod.boundsCenter, 1.0f));
+
+		const float screenSize = gfx::ScreenSize(lod.boundsRadius * scale, glm::length(center - camera.Position), projectionScale);
+		drawcall.lodLevel = gfx::SelectLod(lod, screenSize, drawcall.lodLevel);
+		mesh = &lod.levels[drawcall.lodLevel];
+	}
+	return *mesh;
+}
+
+void submit_draw_call(gfx::ShaderHandle drawShader, DrawCall& drawcall, float projectionScale)
+{
+	const float distance = glm::length(glm::vec3(drawcall.matrix[3]) - camera.Position);
+	const gfx::Mesh& mesh = select_lod(drawcall, projectionScale);
+	renderQueue.Submit(drawShader, mesh, drawcall.material, distance / farPlane, drawcall.matrix);
+}
+
+void submit_draw_calls(const glm::mat4& viewProjection, gfx::ShaderHandle drawShader)
+{
+	const float projectionScale = 1.0f / glm::tan(glm::radians(fieldOfView) * 0.5f);
+
+	renderQueue.Clear();
+	if (useCulling)
+	{
+		drawCallBounds.Cull(gfx::ExtractFrustum(viewProjection), visibleDrawCalls);
+		for (uint32_t index : visibleDrawCalls)
+		{
+			submit_draw_call(drawShader, drawCalls[index], projectionScale);
+		}
+	}
+	else
+	{
+		for (auto& drawcall : drawCalls)
+		{
+			submit_draw_call(drawShader, drawcall, projectionScale);
+		}
+	}
+	renderQueue.Sort();
+}
+
+gfx::ObjectUniforms object_uniforms(const glm::mat4& viewProjection, const gfx::Mesh& mesh, const glm::mat4& model, uint32_t material)
+{
+	gfx::ObjectUniforms block;
+	block.mvp = viewProjection * model;
+	if (mesh.hasQuantizedPositions())
+	{
+		// Dequantize positions in the vertex shader. Normals use the model matrix alone.
+		block.mvp = block.mvp * mesh.positionTransform();
+	}
+	block.model = model;
+	block.color = materials[material];
+	return block;
+}
+
+// Like submit_draw_calls followed by render_per_object, but the traversal, LOD selection and matrix math run on the job system:
+// every job records its share of the draw calls into its own command buffer, and only the replay runs on this (the GL) thread.
+// Jobs only read shared state; a draw call's LOD level is written by the one job that records it.
+void record_draw_calls(const glm::mat4& viewProjection, gfx::ShaderHandle drawShader)
+{
+	const float projectionScale = 1.0f / glm::tan(glm::radians(fieldOfView) * 0.5f);
+
+	if (useCulling)
+	{
+		drawCallBounds.Cull(gfx::ExtractFrustum(viewProjection), visibleDrawCalls);
+	}
+	const size_t count = useCulling ? visibleDrawCalls.size() : drawCalls.size();
+
+	const size_t bufferCount = jobSystem.ThreadCount() + 1;
+	commandQueue.Begin(bufferCount);
+	gfx::ParallelFor(&jobSystem, bufferCount, [&](size_t b)
+	{
+		gfx::CommandBuffer& buffer = commandQueue.Buffer(b);
+		for (size_t i = count * b / bufferCount; i < count * (b + 1) / bufferCount; ++i)
+		{
+			DrawCall& drawcall = useCulling ? drawCalls[visibleDrawCalls[i]] : drawCalls[i];
+			const float distance = glm::length(glm::vec3(drawcall.matrix[3]) - camera.Position);
+			const gfx::Mesh& mesh = select_lod(drawcall, projectionScale);
+			buffer.Draw(gfx::MakeSortKey(drawShader, mesh, drawcall.material, distance / farPlane), drawShader, mesh,
+				object_uniforms(viewProjection, mesh, drawcall.matrix, drawcall.material));
+		}
+	});
+
+	commandQueue.Submit(uniformRing, gfx::UniformBlock_Object);
+	gfx::BindMesh(gfx::Mesh());
+}
+
+void render_instanced()
+{
+	const auto& items = renderQueue.Items();
+	const auto& batches = renderQueue.Batches();
+
+	for (size_t b = 0; b < batches.size(); ++b)
+	{
+		const gfx::RenderBatch& batch = batches[b];
+		const gfx::RenderItem& first = items[batch.first];
+
+		if (batch.changes & gfx::RenderStateChange_Shader)
+		{
+			gfx::UseShader(first.shader);
+		}
+
+		if (batch.changes & (gfx::RenderStateChange_Shader | gfx::RenderStateChange_Mesh))
+		{
+			instances.clear();
+		}
+
+		// Color is per instance here, so runs that only differ in material still share a draw.
+		for (size_t i = batch.first; i < batch.first + batch.count; ++i)
+		{
+			instances.push_back(gfx::MakeInstanceData(items[i].mesh, items[i].model, materials[items[i].material]));
+		}
+
+		const bool lastRunOfMesh = b + 1 == batches.size() ||
+			(batches[b + 1].changes & (gfx::RenderStateChange_Shader | gfx::RenderStateChange_Mesh));
+		if (lastRunOfMesh)
+		{
+			gfx::DrawMeshInstanced(first.mesh, instances);
+		}
+	}
+}
+
+void flush_multi_draw(GLuint vao, GLenum indexType)
+{
+	gfx::MultiDrawMeshes(vao, indexType, multiDrawCommands, instances);
+	multiDrawCommands.clear();
+	instances.clear();
+}
+
+// Like render_instanced, but every mesh of a VAO (a mesh pool) goes into one multi-draw. Scene meshes are all indexed.
+void render_multi_draw()
+{
+	const auto& items = renderQueue.Items();
+	const auto& batches = renderQueue.Batches();
+
+	multiDrawCommands.clear();
+	instances.clear();
+	GLuint vao = 0;
+	GLenum indexType = GL_UNSIGNED_INT;
+
+	for (const gfx::RenderBatch& batch : batches)
+	{
+		const gfx::RenderItem& first = items[batch.first];
+
+		// Pools are split by index type, so a VAO change also covers an index type change.
+		if (batch.changes & (gfx::RenderStateChange_Shader | gfx::RenderStateChange_VertexArray))
+		{
+			flush_multi_draw(vao, indexType);
+			vao = first.mesh.vao;
+			indexType = first.mesh.indexType;
+		}
+
+		if (batch.changes & gfx::RenderStateChange_Shader)
+		{
+			gfx::UseShader(first.shader);
+		}
+
+		// A shader change flushed the commands, so the mesh needs a new one even if it is the same.
+		if (batch.changes & (gfx::RenderStateChange_Shader | gfx::RenderStateChange_Mesh))
+		{
+			multiDrawCommands.push_back({ (GLuint)first.mesh.indexCount, 0, (GLuint)first.mesh.firstIndex, first.mesh.baseVertex, (GLuint)instances.size() });
+		}
+
+		for (size_t i = batch.first; i < batch.first + batch.count; ++i)
+		{
+			instances.push_back(gfx::MakeInstanceData(items[i].mesh, items[i].model, materials[items[i].material]));
+		}
+		multiDrawCommands.back().instanceCount += batch.count;
+	}
+
+	flush_multi_draw(vao, indexType);
+}
+
+void render_per_object(const glm::mat4& viewProjection)
+{
+	const auto& items = renderQueue.Items();
+	if (items.empty())
+	{
+		return;
+	}
+
+	// Write every object's block for the frame with one mapping, then each draw only binds its range.
+	const size_t stride = uniformRing.AlignedSize(sizeof(gfx::ObjectUniforms));
+	size_t objectsOffset = 0;
+	char* objects = uniformRing.Map(items.size() * stride, objectsOffset);
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		const gfx::RenderItem& item = items[i];
+		const gfx::ObjectUniforms block = object_uniforms(viewProjection, item.mesh, item.model, item.material);
+		memcpy(objects + i * stride, &block, sizeof(block));
+	}
+	uniformRing.Unmap();
+
+	for (const gfx::RenderBatch& batch : renderQueue.Batches())
+	{
+		const gfx::RenderItem& first = items[batch.first];
+
+		if (batch.changes & gfx::RenderStateChange_Shader)
+		{
+			gfx::UseShader(first.shader);
+		}
+
+		if (batch.changes & gfx::RenderStateChange_VertexArray)
+		{
+			gfx::BindMesh(first.mesh);
+		}
+
+		for (size_t i = batch.first; i < batch.first + batch.count; ++i)
+		{
+			uniformRing.BindRange(gfx::UniformBlock_Object, objectsOffset + i * stride, sizeof(gfx::ObjectUniforms));
+			gfx::DrawBoundMesh(items[i].mesh);
+		}
+	}
+
+	gfx::BindMesh(gfx::Mesh());
+}
+
+void render_game(const GameInput& input)
+{
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	gfx::SetPolygonMode(input.wireframe ? GL_LINE : GL_FILL);
+
+	gfx::FrameUniforms frame;
+	frame.view = camera.GetViewMatrix();
+	frame.projection = projection;
+	frame.viewProjection = projection * frame.view;
+	frame.lightDir = glm::vec4(glm::normalize(glm::vec3(-1.5, 2, 1)), 0.0f);
+
+	// The Frame block stays bound for the whole frame, so the ring must not orphan after it is written: reserve it together
+	// with the most Object blocks the per-object paths can write, one per draw call.
+	uniformRing.Reserve(uniformRing.AlignedSize(sizeof(frame)) + drawCalls.size() * uniformRing.AlignedSize(sizeof(gfx::ObjectUniforms)));
+	const size_t frameOffset = uniformRing.Write(&frame, sizeof(frame));
+	uniformRing.BindRange(gfx::UniformBlock_Frame, frameOffset, sizeof(frame));
+
+	primitiveLoader.Upload(meshUploadBudget);
+
+	shaderCompiler.Poll();
+	const gfx::ShaderHandle instancedShader = shaderVariants.Get(litInstancedVariant, shaderCompiler, 0);
+	const bool instancing = useInstancing && instancedShader != 0;
+
+	if (!instancing && useCommandBuffers)
+	{
+		renderQueue.Clear();
+		record_draw_calls(frame.viewProjection, shader);
+		return;
+	}
+
+	commandQueue.Clear();
+	submit_draw_calls(frame.viewProjection, instancing ? instancedShader : shader);
+
+	if (instancing && useMultiDraw)		render_multi_draw();
+	else if (instancing)				render_instanced();
+	else								render_per_object(frame.viewProjection);
+}
+
+void end_game()
+{
+	shaderVariants.Clear();
+	shaderCompiler.Clear();
+	uniformRing.Destroy();
+	renderQueue.Clear();
+	commandQueue.Clear();
+	instances.clear();
+	multiDrawCommands.clear();
+	primitiveLoader.Clear();
+	jobSystem.Stop();
+	for (auto& lod : lodMeshes)
+	{
+		gfx::DeleteLodMesh(lod);
+	}
+	lodMeshes.clear();
+	for (auto& mesh : meshes)
+	{
+		gfx::DeleteMesh(mesh);
+	}
+	meshes.clear();
+	gfx::DeleteMeshCache();
+	gfx::DeleteMeshPools();
+	drawCalls.clear();
+	drawCallBounds.Clear();
+}
@@ -0,0 +1,70 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "CommandBuffer.h"
+#include "Mesh.h"
+#include "RenderQueue.h"
+#include "Camera.h"
+
+// Window-system independent game state and per-frame logic.
+// main.cpp feeds it SDL input and swaps buffers; the headless benchmark drives it with scripted input.
+
+struct DrawCall
+{
+	gfx::Mesh mesh;
+	glm::mat4 matrix;
+	// Index into the game's material (color) table.
+	uint32_t material;
+	// Index into the game's LOD mesh table, or -1. With a LOD mesh, {mesh} is its finest level and the level drawn
+	// is picked every frame from the projected size, {lodLevel} being the one picked last.
+	int lod = -1;
+	int lodLevel = 0;
+};
+
+struct GameInput
+{
+	bool up;
+	bool down;
+	bool right;
+	bool left;
+	bool rightMouse;
+	bool wireframe;
+	glm::vec2 mouseDelta;
+};
+
+extern float nearPlane;
+extern float farPlane;
+extern float fieldOfView;
+// Draw calls that share a mesh are drawn with one instanced draw call.
+extern bool useInstancing;
+// Draw calls outside the camera frustum are skipped.
+extern bool useCulling;
+// With instancing, all meshes sharing a VAO are drawn with one multi-draw (see gfx::MultiDrawMeshes).
+extern bool useMultiDraw;
+// Distant draw calls with a LOD mesh use coarser levels.
+extern bool useLod;
+// Without instancing, draws are recorded into command buffers on the job system's workers and replayed on the GL thread.
+extern bool useCommandBuffers;
+// Bytes of vertex and index data render_game may upload per frame for primitives generated in the background.
+extern size_t meshUploadBudget;
+// Initial size in bytes of the ring the Frame and Object uniform blocks stream through. It orphans when full and grows when a
+// single frame doesn't fit.
+extern size_t uniformRingSize;
+
+extern Camera camera;
+extern std::vector<DrawCall> drawCalls;
+// Rebuilt from drawCalls every frame by render_game.
+extern gfx::RenderQueue renderQueue;
+// Filled instead of renderQueue when draws are recorded (see useCommandBuffers).
+extern gfx::CommandQueue commandQueue;
+
+void begin_game(int width, int height);
+// Appends {count} extra draw calls on a grid behind the default scene, reusing the scene meshes.
+void populate_grid(int count);
+// Recomputes the world space bounds used for frustum culling. Call after adding, moving or removing draw calls.
+void update_draw_call_bounds();
+void update_game(const GameInput& input, double deltaTime);
+void render_game(const GameInput& input);
+void end_game();
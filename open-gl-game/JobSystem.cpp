@@ -0,0 +1,164 @@
+#include "JobSystem.h"
+
+namespace gfx
+{
+	// The pool and deque the current thread works for, so nested submissions stay local.
+	thread_local const JobSystem* currentJobSystem = nullptr;
+	thread_local size_t currentQueue = 0;
+
+	JobSystem::~JobSystem()
+	{
+		Stop();
+	}
+
+	void JobSystem::Start(unsigned int threadCount)
+	{
+		if (!threads.empty())
+		{
+			return;
+		}
+
+		if (threadCount == 0)
+		{
+			const unsigned int hardwareThreads = std::thread::hardware_concurrency();
+			threadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		stopping = false;
+		queues.clear();
+		for (unsigned int i = 0; i < threadCount; ++i)
+		{
+			queues.push_back(std::make_unique<WorkQueue>());
+		}
+		for (unsigned int i = 0; i < threadCount; ++i)
+		{
+			threads.emplace_back(&JobSystem::workerLoop, this, i);
+		}
+	}
+
+	void JobSystem::Stop()
+	{
+		if (threads.empty())
+		{
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			stopping = true;
+		}
+		wake.notify_all();
+
+		for (auto& thread : threads)
+		{
+			thread.join();
+		}
+		threads.clear();
+	}
+
+	void JobSystem::Submit(Job job)
+	{
+		// Without workers the job runs right away, so callers don't need a separate serial path.
+		if (threads.empty())
+		{
+			job();
+			return;
+		}
+
+		const size_t queueIndex = currentJobSystem == this ? currentQueue : nextQueue++ % queues.size();
+
+		++unfinished;
+
+		// Counted before it is pushed, so a thief can never take the job before it is counted.
+		// Taking the sleep lock orders the increment with a worker checking for work before it sleeps, so no wake up is lost.
+		{
+			std::lock_guard<std::mutex> lock(sleepMutex);
+			++queued;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(queues[queueIndex]->mutex);
+			queues[queueIndex]->jobs.push_back(std::move(job));
+		}
+		wake.notify_one();
+	}
+
+	bool JobSystem::tryRun(size_t queueIndex)
+	{
+		Job job;
+
+		// Own deque first, newest job (its data is most likely still in cache).
+		{
+			WorkQueue& own = *queues[queueIndex];
+			std::lock_guard<std::mutex> lock(own.mutex);
+			if (!own.jobs.empty())
+			{
+				job = std::move(own.jobs.back());
+				own.jobs.pop_back();
+			}
+		}
+
+		// Then steal the oldest job of another deque.
+		for (size_t i = 1; !job && i < queues.size(); ++i)
+		{
+			WorkQueue& victim = *queues[(queueIndex + i) % queues.size()];
+			std::lock_guard<std::mutex> lock(victim.mutex);
+			if (!victim.jobs.empty())
+			{
+				job = std::move(victim.jobs.front());
+				victim.jobs.pop_front();
+			}
+		}
+
+		if (!job)
+		{
+			return false;
+		}
+
+		--queued;
+		job();
+		--unfinished;
+		return true;
+	}
+
+	bool JobSystem::RunPendingJob()
+	{
+		if (queues.empty() || queued == 0)
+		{
+			return false;
+		}
+		return tryRun(currentJobSystem == this ? currentQueue : nextQueue++ % queues.size());
+	}
+
+	void JobSystem::Wait()
+	{
+		while (unfinished > 0)
+		{
+			if (!RunPendingJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void JobSystem::workerLoop(size_t queueIndex)
+	{
+		currentJobSystem = this;
+		currentQueue = queueIndex;
+
+		for (;;)
+		{
+			if (tryRun(queueIndex))
+			{
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(sleepMutex);
+			wake.wait(lock, [this] { return stopping || queued > 0; });
+			if (stopping && queued == 0)
+			{
+				return;
+			}
+		}
+	}
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace gfx
+{
+	// Work stealing thread pool. Every worker owns a deque: it runs its own jobs newest first, and when it runs dry
+	// steals the oldest job of another worker, so one burst of submissions spreads over all threads.
+	// The deques are locked individually, contention only happens while stealing.
+	class JobSystem
+	{
+	public:
+		using Job = std::function<void()>;
+
+		JobSystem() = default;
+		JobSystem(const JobSystem&) = delete;
+		JobSystem& operator=(const JobSystem&) = delete;
+		~JobSystem();
+
+		// Starts {threadCount} workers, or one less than the hardware threads (at least one) if 0.
+		void Start(unsigned int threadCount = 0);
+		// Runs the jobs still queued, then joins the workers.
+		void Stop();
+
+		// Thread safe. Jobs submitted from a worker go to that worker's deque, others are spread round robin.
+		void Submit(Job job);
+		// Runs one queued job on the calling thread. Returns false if none was queued.
+		bool RunPendingJob();
+		// Helps running jobs until every submitted job has finished.
+		void Wait();
+
+		inline unsigned int ThreadCount() const { return static_cast<unsigned int>(threads.size()); }
+
+	private:
+		struct WorkQueue
+		{
+			std::mutex		mutex;
+			std::deque<Job>	jobs;
+		};
+
+		bool tryRun(size_t queueIndex);
+		void workerLoop(size_t queueIndex);
+
+		std::vector<std::unique_ptr<WorkQueue>>	queues;
+		std::vector<std::thread>				threads;
+		// Jobs sitting in a deque, and jobs submitted but not finished.
+		std::atomic<size_t>						queued{ 0 };
+		std::atomic<size_t>						unfinished{ 0 };
+		std::atomic<size_t>						nextQueue{ 0 };
+		std::atomic<bool>						stopping{ false };
+		// Idle workers sleep here until a job is submitted.
+		std::mutex								sleepMutex;
+		std::condition_variable					wake;
+	};
+
+	// Runs body(i) for every i below {count}, spread over {jobs} if given. Returns when all of them have finished;
+	// the calling thread runs queued jobs meanwhile, so this also works from inside a job. Unlike Wait, it doesn't wait
+	// for unrelated jobs.
+	template<typename Body>
+	void ParallelFor(JobSystem* jobs, size_t count, const Body& body)
+	{
+		if (!jobs || count <= 1)
+		{
+			for (size_t i = 0; i < count; ++i)
+			{
+				body(i);
+			}
+			return;
+		}
+
+		std::atomic<size_t> pending{ count };
+		for (size_t i = 0; i < count; ++i)
+		{
+			jobs->Submit([&body, &pending, i]
+			{
+				body(i);
+				pending.fetch_sub(1, std::memory_order_release);
+			});
+		}
+
+		while (pending.load(std::memory_order_acquire) != 0)
+		{
+			if (!jobs->RunPendingJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+}
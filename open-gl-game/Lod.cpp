@@ -0,0 +1,106 @@
+#include "Lod.h"
+#include "MeshCache.h"
+
+namespace gfx
+{
+	PrimitiveDesc ReduceDetail(const PrimitiveDesc& primitive, int level)
+	{
+		PrimitiveDesc reduced = primitive;
+		int* segments = reduced.segments;
+		switch (primitive.type)
+		{
+		case PrimitiveType_Sphere:
+			segments[0] = glm::max(segments[0] - level, 0);
+			break;
+		case PrimitiveType_Cylinder:
+			segments[0] = glm::max(segments[0] >> level, 3);
+			break;
+		case PrimitiveType_Capsule:
+			// Latitudes round up to even in Capsule, keep at least 2 rings per hemisphere.
+			segments[0] = glm::max(segments[0] >> level, 4);
+			segments[1] = glm::max(segments[1] >> level, 3);
+			break;
+		default:
+			break;
+		}
+		return reduced;
+	}
+
+	// Lets the coarsest level be drawn at any size, and measures the bounds from the finest.
+	void finishLodMesh(LodMesh& lod)
+	{
+		lod.minScreenSize[lod.levelCount - 1] = 0.0f;
+
+		const Mesh& finest = lod.levels[0];
+		lod.boundsCenter = (finest.boundsMin + finest.boundsMax) * 0.5f;
+		lod.boundsRadius = glm::length(finest.boundsMax - finest.boundsMin) * 0.5f;
+	}
+
+	LodMesh CreateLodMesh(const PrimitiveDesc& primitive, int levelCount, const VertexFormat& format, float screenSize)
+	{
+		LodMesh lod;
+		levelCount = glm::clamp(levelCount, 1, MaxLodLevels);
+
+		for (int level = 0; level < levelCount; ++level)
+		{
+			const PrimitiveDesc levelPrimitive = ReduceDetail(primitive, level);
+			if (level > 0 && levelPrimitive == ReduceDetail(primitive, level - 1))
+			{
+				break;
+			}
+
+			lod.levels[level] = CreateCachedMesh(levelPrimitive, format);
+			lod.minScreenSize[level] = screenSize / float(1 << level);
+			++lod.levelCount;
+		}
+
+		finishLodMesh(lod);
+		return lod;
+	}
+
+	LodMesh CreateLodMesh(const MeshFile& file, bool pooled, float screenSize)
+	{
+		LodMesh lod;
+		const int levelCount = glm::min(file.LevelCount(), MaxLodLevels);
+		for (int level = 0; level < levelCount; ++level)
+		{
+			const PackedMeshData packed = file.Level(level);
+			lod.levels[level] = pooled ? CreatePooledMesh(packed) : CreateMesh(packed);
+			lod.minScreenSize[level] = screenSize / float(1 << level);
+			++lod.levelCount;
+		}
+
+		if (lod.isValid())
+		{
+			finishLodMesh(lod);
+		}
+		return lod;
+	}
+
+	void DeleteLodMesh(LodMesh& lod)
+	{
+		for (int level = 0; level < lod.levelCount; ++level)
+		{
+			DeleteMesh(lod.levels[level]);
+		}
+		lod.levelCount = 0;
+	}
+
+	int SelectLod(const LodMesh& lod, float screenSize, int currentLevel, float hysteresis)
+	{
+		int level = glm::clamp(currentLevel, 0, lod.levelCount - 1);
+
+		// Coarser while clearly too small for the current level.
+		while (level + 1 < lod.levelCount && screenSize < lod.minScreenSize[level] * (1.0f - hysteresis))
+		{
+			++level;
+		}
+
+		// Finer while clearly large enough for the next finer level.
+		while (level > 0 && screenSize > lod.minScreenSize[level - 1] * (1.0f + hysteresis))
+		{
+			--level;
+		}
+		return level;
+	}
+}
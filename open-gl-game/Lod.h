@@ -0,0 +1,49 @@
+#pragma once
+#include <glm/glm.hpp>
+#include "Mesh.h"
+#include "MeshFile.h"
+#include "Primitives.h"
+
+namespace gfx
+{
+	const int MaxLodLevels = 4;
+
+	// A mesh at decreasing resolutions, level 0 being the finest.
+	// Chains of primitives use cached meshes (see CreateCachedMesh), so chains of the same primitive share them.
+	struct LodMesh
+	{
+		Mesh	levels[MaxLodLevels];
+		// Smallest screen size (see ScreenSize) each level is drawn at. The coarsest level's is 0.
+		float	minScreenSize[MaxLodLevels];
+		int		levelCount = 0;
+		// Mesh space bounding sphere of level 0, the one screen size is measured with.
+		glm::vec3	boundsCenter = glm::vec3(0.0f);
+		float		boundsRadius = 0.0f;
+
+		inline bool isValid() const { return levelCount > 0; }
+	};
+
+	// {primitive} with its resolution lowered {level} times. Each step halves the segment counts, or removes a sphere subdivision.
+	// Primitives without a resolution (quads, boxes) come back unchanged.
+	PrimitiveDesc ReduceDetail(const PrimitiveDesc& primitive, int level);
+
+	// Creates up to {levelCount} levels of {primitive}, fewer if the resolution bottoms out first.
+	// Level 0 is drawn down to {screenSize}, every following level down to half the size of the one before, as it has about half the edge resolution.
+	LodMesh CreateLodMesh(const PrimitiveDesc& primitive, int levelCount, const VertexFormat& format = VertexFormat_Float, float screenSize = 0.25f);
+	// Uploads the levels stored in {file}, with thresholds as above. The chain owns its meshes.
+	LodMesh CreateLodMesh(const MeshFile& file, bool pooled = true, float screenSize = 0.25f);
+	// Releases the levels (see DeleteMesh).
+	void DeleteLodMesh(LodMesh& lod);
+
+	// Projected diameter of a sphere of {radius} at {distance} from the eye, as a fraction of the viewport height.
+	// {projectionScale} is 1 / tan(verticalFieldOfView / 2), ie. projection[1][1] of a perspective projection.
+	inline float ScreenSize(float radius, float distance, float projectionScale)
+	{
+		return radius * projectionScale / glm::max(distance, 1e-4f);
+	}
+
+	// Level to draw at {screenSize}, given the one drawn last time.
+	// A level is only left once the size is more than {hysteresis} (relative) past its threshold, so objects sitting
+	// at a threshold don't switch back and forth every frame.
+	int SelectLod(const LodMesh& lod, float screenSize, int currentLevel, float hysteresis = 0.1f);
+}
@@ -0,0 +1,112 @@
+#include <utility>
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace gfx
+{
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	MappedFile::MappedFile(MappedFile&& other) noexcept :
+		data(std::exchange(other.data, nullptr)),
+		size(std::exchange(other.size, 0))
+	{}
+
+	MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+	{
+		if (this != &other)
+		{
+			Close();
+			data = std::exchange(other.data, nullptr);
+			size = std::exchange(other.size, 0);
+		}
+		return *this;
+	}
+
+	// The file handle is closed right away, the mapping keeps the file alive.
+	bool MappedFile::Open(const char* path)
+	{
+		Close();
+
+#if defined(_WIN32)
+		HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE)
+		{
+			return false;
+		}
+
+		LARGE_INTEGER fileSize{};
+		const void* view = nullptr;
+		if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+		{
+			if (HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr))
+			{
+				view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+				CloseHandle(mapping);
+			}
+		}
+		CloseHandle(file);
+
+		if (!view)
+		{
+			return false;
+		}
+
+		data = static_cast<const std::byte*>(view);
+		size = static_cast<size_t>(fileSize.QuadPart);
+		return true;
+#else
+		const int file = open(path, O_RDONLY);
+		if (file < 0)
+		{
+			return false;
+		}
+
+		struct stat status{};
+		void* view = MAP_FAILED;
+		if (fstat(file, &status) == 0 && status.st_size > 0)
+		{
+			view = mmap(nullptr, status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+		}
+		close(file);
+
+		if (view == MAP_FAILED)
+		{
+			return false;
+		}
+
+		madvise(view, status.st_size, MADV_WILLNEED);
+		data = static_cast<const std::byte*>(view);
+		size = static_cast<size_t>(status.st_size);
+		return true;
+#endif
+	}
+
+	void MappedFile::Close()
+	{
+		if (!data)
+		{
+			return;
+		}
+
+#if defined(_WIN32)
+		UnmapViewOfFile(data);
+#else
+		munmap(const_cast<std::byte*>(data), size);
+#endif
+		data = nullptr;
+		size = 0;
+	}
+}
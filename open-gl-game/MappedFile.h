@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+
+namespace gfx
+{
+	// Read-only memory mapping of a whole file. Move-only, unmaps on destruction.
+	class MappedFile
+	{
+	public:
+		MappedFile() = default;
+		~MappedFile();
+		MappedFile(MappedFile&& other) noexcept;
+		MappedFile& operator=(MappedFile&& other) noexcept;
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		// Maps all of {path}. Returns false, leaving the file closed, if it can't be opened or is empty.
+		// The pages are prefetched, callers are expected to read all of it.
+		bool Open(const char* path);
+		void Close();
+
+		inline bool IsOpen() const { return data != nullptr; }
+		inline const std::byte* Data() const { return data; }
+		inline size_t Size() const { return size; }
+
+	private:
+		const std::byte*	data = nullptr;
+		size_t				size = 0;
+	};
+}
@@ -1,168 +1,513 @@
-#include "mesh.h"
+#include <cstddef>
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+#include <glm/gtc/packing.hpp>
+#include "GLState.h"
+#include "Mesh.h"
+#include "MeshCache.h"
+#include "RangeAllocator.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFX_MESH_SSE
+#include <emmintrin.h>
+#endif
 
 namespace gfx
 {
-	// Stores vertices in a single VBO, Interleaved.
-	// P = position
-	// N = normal
-	// U = uv
-	// [P,N,U,P,N,U,P,N,U]
-	void bufferVertices_Interleaved(const MeshData& meshData)
+	// Streams start on 16 byte boundaries of the arena.
+	size_t alignStream(size_t offset)
 	{
-		const auto vertexSize = meshData.vertexSize();
-		const auto vertexCount = meshData.vertexCount();
-
-		// Size of the vertex buffer
-		const size_t bufferSize = vertexSize * vertexCount;
-
-		char* vertexData = new char[bufferSize];
+		return (offset + 15) & ~size_t(15);
+	}
 
-		int offset = 0;
-		if (meshData.vertices.has_value())
+	MeshData::MeshData(unsigned int attributeMask, size_t vertexCount, size_t indexCount) :
+		mask(attributeMask),
+		numVertices(vertexCount),
+		numIndices(indexCount)
+	{
+		// Lay the streams out first, then carve them out of a single allocation.
+		size_t offsets[VertexAttribute_Count + 1] = {};
+		const size_t elementSizes[VertexAttribute_Count] = { sizeof(glm::vec3), sizeof(glm::vec3), sizeof(glm::vec2), sizeof(glm::vec4) };
+		size_t size = 0;
+		for (unsigned int attribute = 0; attribute < VertexAttribute_Count; ++attribute)
 		{
-			const std::vector<glm::vec3>& vertices = meshData.vertices.value();
-			for (int i = 0; i < vertices.size(); ++i)
+			if (mask & (1u << attribute))
 			{
-				memcpy(&vertexData[i * vertexSize + offset], &vertices[i], sizeof(glm::vec3));
+				offsets[attribute] = size;
+				size = alignStream(size + elementSizes[attribute] * vertexCount);
 			}
+		}
+		offsets[VertexAttribute_Count] = size;
+		size += sizeof(GLuint) * indexCount;
+
+		if (size == 0)
+		{
+			return;
+		}
 
-			// Position attribute pointer
-			glEnableVertexAttribArray(0);
-			// Point to a 3 component vector of type Float with an offset of {offset} bytes.
-			glVertexAttribPointer(0, 3, GL_FLOAT, false, vertexSize, (const void*)offset);
+		arena.reset(new std::byte[size]);
+		std::byte* base = arena.get();
+		if (mask & VertexAttribute_Position)	positionStream = reinterpret_cast<glm::vec3*>(base + offsets[0]);
+		if (mask & VertexAttribute_Normal)		normalStream = reinterpret_cast<glm::vec3*>(base + offsets[1]);
+		if (mask & VertexAttribute_UV)			uvStream = reinterpret_cast<glm::vec2*>(base + offsets[2]);
+		if (mask & VertexAttribute_Color)		colorStream = reinterpret_cast<glm::vec4*>(base + offsets[3]);
+		if (indexCount > 0)						indexStream = reinterpret_cast<GLuint*>(base + offsets[VertexAttribute_Count]);
+	}
 
-			offset += sizeof(glm::vec3);
+	MeshData::MeshData(MeshData&& other) noexcept
+	{
+		*this = std::move(other);
+	}
+
+	MeshData& MeshData::operator=(MeshData&& other) noexcept
+	{
+		arena = std::move(other.arena);
+		mask = std::exchange(other.mask, 0);
+		numVertices = std::exchange(other.numVertices, 0);
+		numIndices = std::exchange(other.numIndices, 0);
+		positionStream = std::exchange(other.positionStream, nullptr);
+		normalStream = std::exchange(other.normalStream, nullptr);
+		uvStream = std::exchange(other.uvStream, nullptr);
+		colorStream = std::exchange(other.colorStream, nullptr);
+		indexStream = std::exchange(other.indexStream, nullptr);
+		return *this;
+	}
+
+	MeshData MeshData::Clone() const
+	{
+		// Stream by stream: after Shrink the streams are laid out for the original counts.
+		MeshData clone(mask, numVertices, numIndices);
+		std::copy(vertices().begin(), vertices().end(), clone.vertices().begin());
+		std::copy(normals().begin(), normals().end(), clone.normals().begin());
+		std::copy(uvs().begin(), uvs().end(), clone.uvs().begin());
+		std::copy(colors().begin(), colors().end(), clone.colors().begin());
+		std::copy(indices().begin(), indices().end(), clone.indices().begin());
+		return clone;
+	}
+
+	void MeshData::Shrink(size_t vertexCount, size_t indexCount)
+	{
+		numVertices = std::min(numVertices, vertexCount);
+		numIndices = std::min(numIndices, indexCount);
+	}
+
+	// How an attribute is stored in the vertex buffer, as passed to glVertexAttribPointer.
+	struct VertexAttributeLayout
+	{
+		GLint		components;
+		GLenum		type;
+		GLboolean	normalized;
+		// Size of one element, in bytes.
+		unsigned int size;
+	};
+
+	// Per-upload conversion state shared by the packing kernels.
+	struct VertexEncoding
+	{
+		VertexFormat	format;
+		// Maps mesh space positions into [-1, 1] for PositionFormat_SNorm16.
+		glm::vec3		positionOffset;
+		glm::vec3		positionInverseScale;
+	};
+
+	// Writes {vertexCount} packed vertices of {meshData} to {out}.
+	typedef void (*PackVerticesFunction)(const MeshData& meshData, const VertexEncoding& encoding, size_t vertexCount, char* out);
+
+	// Staging memory used when the vertex buffer can't be mapped. Grows to the largest mesh uploaded and is reused.
+	std::vector<char> stagingArena;
+
+	// Attribute location of the first InstanceData column. The model matrix takes 4 locations, the other members one each.
+	const GLuint instanceAttributeLocation = 4;
+
+	// Shared stream buffer for DrawMeshInstanced and MultiDrawMeshes. Its capacity only grows, so every VAO pointing at it stays valid.
+	GLuint instanceBuffer = 0;
+	size_t instanceBufferCapacity = 0;
+
+	// Stream buffer of MultiDrawMeshes' commands.
+	GLuint indirectBuffer = 0;
+	size_t indirectBufferCapacity = 0;
+
+	// VAOs that already have their instance attributes pointed at instanceBuffer.
+	std::unordered_set<GLuint> instancedVaos;
+
+	// Storage shared by the pooled meshes of one attribute mask and vertex format.
+	// Vertices are interleaved, so one set of attribute pointers (and one VAO) serves every mesh, each offset by its base vertex.
+	struct MeshPool
+	{
+		unsigned int	mask = 0;
+		VertexFormat	format = VertexFormat_Float;
+		unsigned int	vertexSize = 0;
+		GLenum			indexType = GL_UNSIGNED_INT;
+		unsigned int	indexSize = sizeof(GLuint);
+		GLuint			vao = 0;
+		GLuint			vbo = 0;
+		GLuint			ibo = 0;
+		// In vertices and indices respectively.
+		RangeAllocator	vertices;
+		RangeAllocator	indices;
+	};
+
+	// Capacity of a pool's buffers when first used. They double when full.
+	const size_t poolVertexCapacity = 1 << 16;
+	const size_t poolIndexCapacity = 3 << 16;
+
+	// Keyed by poolKey().
+	std::unordered_map<unsigned int, MeshPool> meshPools;
+
+	unsigned int poolKey(unsigned int mask, const VertexFormat& format, GLenum indexType)
+	{
+		return mask | (format.position << 4) | (format.normal << 5) | (format.uv << 6) | (format.color << 7) | ((indexType == GL_UNSIGNED_SHORT) << 8);
+	}
+
+	// {attribute} is the bit index of a VertexAttributeFlags value.
+	VertexAttributeLayout attributeLayout(unsigned int attribute, const VertexFormat& format)
+	{
+		switch (attribute)
+		{
+		case 0:
+			if (format.position == PositionFormat_SNorm16)		return { 4, GL_SHORT, GL_TRUE, sizeof(glm::uint64) };
+			return { 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3) };
+		case 1:
+			if (format.normal == NormalFormat_Int2_10_10_10)	return { 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(glm::uint32) };
+			return { 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3) };
+		case 2:
+			if (format.uv == UVFormat_Half2)					return { 2, GL_HALF_FLOAT, GL_FALSE, sizeof(glm::uint32) };
+			return { 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2) };
+		default:
+			if (format.color == ColorFormat_UNorm8)				return { 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(glm::uint32) };
+			return { 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4) };
+		}
+	}
+
+	unsigned int PackedVertexSize(unsigned int mask, const VertexFormat& format)
+	{
+		unsigned int size = 0;
+		for (unsigned int attribute = 0; attribute < VertexAttribute_Count; ++attribute)
+		{
+			if (mask & (1 << attribute)) size += attributeLayout(attribute, format).size;
+		}
+		return size;
+	}
+
+	inline char* encodePosition(const VertexEncoding& encoding, const glm::vec3& position, char* out)
+	{
+		if (encoding.format.position == PositionFormat_SNorm16)
+		{
+			const glm::uint64 packed = glm::packSnorm4x16(glm::vec4((position - encoding.positionOffset) * encoding.positionInverseScale, 0.0f));
+			memcpy(out, &packed, sizeof(packed));
+			return out + sizeof(packed);
+		}
+		memcpy(out, &position, sizeof(glm::vec3));
+		return out + sizeof(glm::vec3);
+	}
+
+	inline char* encodeNormal(const VertexEncoding& encoding, const glm::vec3& normal, char* out)
+	{
+		if (encoding.format.normal == NormalFormat_Int2_10_10_10)
+		{
+			const glm::uint32 packed = glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f));
+			memcpy(out, &packed, sizeof(packed));
+			return out + sizeof(packed);
+		}
+		memcpy(out, &normal, sizeof(glm::vec3));
+		return out + sizeof(glm::vec3);
+	}
+
+	inline char* encodeUV(const VertexEncoding& encoding, const glm::vec2& uv, char* out)
+	{
+		if (encoding.format.uv == UVFormat_Half2)
+		{
+			const glm::uint32 packed = glm::packHalf2x16(uv);
+			memcpy(out, &packed, sizeof(packed));
+			return out + sizeof(packed);
+		}
+		memcpy(out, &uv, sizeof(glm::vec2));
+		return out + sizeof(glm::vec2);
+	}
+
+	inline char* encodeColor(const VertexEncoding& encoding, const glm::vec4& color, char* out)
+	{
+		if (encoding.format.color == ColorFormat_UNorm8)
+		{
+			const glm::uint32 packed = glm::packUnorm4x8(color);
+			memcpy(out, &packed, sizeof(packed));
+			return out + sizeof(packed);
+		}
+		memcpy(out, &color, sizeof(glm::vec4));
+		return out + sizeof(glm::vec4);
+	}
+
+	// Fused packing kernel for the interleaved layout, specialised per attribute mask so the
+	// per-vertex loop writes each present attribute once with no per-attribute branching.
+	template<unsigned int Mask>
+	void packVertices_Interleaved(const MeshData& meshData, const VertexEncoding& encoding, size_t vertexCount, char* out)
+	{
+		const glm::vec3* positions	= meshData.vertices().data();
+		const glm::vec3* normals	= meshData.normals().data();
+		const glm::vec2* uvs		= meshData.uvs().data();
+		const glm::vec4* colors		= meshData.colors().data();
+
+		for (size_t i = 0; i < vertexCount; ++i)
+		{
+			if constexpr ((Mask & VertexAttribute_Position) != 0)	out = encodePosition(encoding, positions[i], out);
+			if constexpr ((Mask & VertexAttribute_Normal) != 0)		out = encodeNormal(encoding, normals[i], out);
+			if constexpr ((Mask & VertexAttribute_UV) != 0)			out = encodeUV(encoding, uvs[i], out);
+			if constexpr ((Mask & VertexAttribute_Color) != 0)		out = encodeColor(encoding, colors[i], out);
 		}
-		if (meshData.normals.has_value())
+	}
+
+	const PackVerticesFunction interleavedPackers[1 << VertexAttribute_Count] =
+	{
+		&packVertices_Interleaved<0>,	&packVertices_Interleaved<1>,	&packVertices_Interleaved<2>,	&packVertices_Interleaved<3>,
+		&packVertices_Interleaved<4>,	&packVertices_Interleaved<5>,	&packVertices_Interleaved<6>,	&packVertices_Interleaved<7>,
+		&packVertices_Interleaved<8>,	&packVertices_Interleaved<9>,	&packVertices_Interleaved<10>,	&packVertices_Interleaved<11>,
+		&packVertices_Interleaved<12>,	&packVertices_Interleaved<13>,	&packVertices_Interleaved<14>,	&packVertices_Interleaved<15>,
+	};
+
+	// Non-interleaved layout: each attribute stream is contiguous, so full precision streams are one copy per attribute.
+	void packVertices_Seperate(const MeshData& meshData, const VertexEncoding& encoding, size_t vertexCount, char* out)
+	{
+		if (meshData.hasAttribute(VertexAttribute_Position))
 		{
-			const std::vector<glm::vec3>& normals = meshData.normals.value();
-			for (int i = 0; i < normals.size(); ++i)
+			const std::span<const glm::vec3> vertices = meshData.vertices();
+			if (encoding.format.position == PositionFormat_Float3)
 			{
-				memcpy(&vertexData[i * vertexSize + offset], &normals[i], sizeof(glm::vec3));
+				memcpy(out, vertices.data(), sizeof(glm::vec3) * vertexCount);
+				out += sizeof(glm::vec3) * vertexCount;
+			}
+			else
+			{
+				for (size_t i = 0; i < vertexCount; ++i) out = encodePosition(encoding, vertices[i], out);
 			}
-
-			// Normals attribute pointer
-			glEnableVertexAttribArray(1);
-			// Point to a 3 component vector of type Float with an offset of {offset} bytes.
-			glVertexAttribPointer(1, 3, GL_FLOAT, false, vertexSize, (const void*)offset);
-			offset += sizeof(glm::vec3);
 		}
-		if (meshData.uvs.has_value())
+		if (meshData.hasAttribute(VertexAttribute_Normal))
 		{
-			const std::vector<glm::vec2>& uvs = meshData.uvs.value();
-			for (int i = 0; i < uvs.size(); ++i)
+			const std::span<const glm::vec3> normals = meshData.normals();
+			if (encoding.format.normal == NormalFormat_Float3)
 			{
-				memcpy(&vertexData[i * vertexSize + offset], &uvs[i], sizeof(glm::vec2));
+				memcpy(out, normals.data(), sizeof(glm::vec3) * vertexCount);
+				out += sizeof(glm::vec3) * vertexCount;
+			}
+			else
+			{
+				for (size_t i = 0; i < vertexCount; ++i) out = encodeNormal(encoding, normals[i], out);
+			}
+		}
+		if (meshData.hasAttribute(VertexAttribute_UV))
+		{
+			const std::span<const glm::vec2> uvs = meshData.uvs();
+			if (encoding.format.uv == UVFormat_Float2)
+			{
+				memcpy(out, uvs.data(), sizeof(glm::vec2) * vertexCount);
+				out += sizeof(glm::vec2) * vertexCount;
+			}
+			else
+			{
+				for (size_t i = 0; i < vertexCount; ++i) out = encodeUV(encoding, uvs[i], out);
 			}
-
-			// UVs attribute pointer
-			glEnableVertexAttribArray(2);
-			// Point to a 2 component vector of type Float with an offset of {offset} bytes.
-			glVertexAttribPointer(2, 2, GL_FLOAT, false, vertexSize, (const void*)offset);
-			offset += sizeof(glm::vec2);
 		}
-		if (meshData.colors.has_value())
+		if (meshData.hasAttribute(VertexAttribute_Color))
 		{
-			const std::vector<glm::vec4>& colors = meshData.colors.value();
-			for (int i = 0; i < colors.size(); ++i)
+			const std::span<const glm::vec4> colors = meshData.colors();
+			if (encoding.format.color == ColorFormat_Float4)
 			{
-				memcpy(&vertexData[i * vertexSize + offset], &colors[i], sizeof(glm::vec4));
+				memcpy(out, colors.data(), sizeof(glm::vec4) * vertexCount);
+				out += sizeof(glm::vec4) * vertexCount;
 			}
+			else
+			{
+				for (size_t i = 0; i < vertexCount; ++i) out = encodeColor(encoding, colors[i], out);
+			}
+		}
+	}
+
+	// Packs the vertices straight into a write-only mapping of [offset, offset + size) of the bound GL_ARRAY_BUFFER.
+	// {invalidate} is GL_MAP_INVALIDATE_BUFFER_BIT when the range is the whole buffer, GL_MAP_INVALIDATE_RANGE_BIT otherwise.
+	// Falls back to packing into the staging arena when the buffer can't be mapped or the mapping was lost.
+	void writeVertices(const MeshData& meshData, const VertexEncoding& encoding, size_t vertexCount, size_t offset, size_t size, GLbitfield invalidate, PackVerticesFunction pack)
+	{
+		if (void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | invalidate))
+		{
+			pack(meshData, encoding, vertexCount, static_cast<char*>(mapped));
 
-			// Colors attribute pointer
-			glEnableVertexAttribArray(3);
-			// Point to a 4 component vector of type Float with an offset of {offset} bytes.
-			glVertexAttribPointer(3, 4, GL_FLOAT, false, vertexSize, (const void*)offset);
-			offset += sizeof(glm::vec4);
+			// Unmapping fails if the buffer contents were corrupted while mapped (eg. a display mode change).
+			if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_TRUE)
+			{
+				return;
+			}
 		}
 
-		// Write out vertex data to the buffer. Use STATIC_DRAW as we don't plan on updating the buffer.
-		glBufferData(GL_ARRAY_BUFFER, bufferSize, vertexData, GL_STATIC_DRAW);
+		if (stagingArena.size() < size)
+		{
+			stagingArena.resize(size);
+		}
 
-		delete[] vertexData;
+		pack(meshData, encoding, vertexCount, stagingArena.data());
+		glBufferSubData(GL_ARRAY_BUFFER, offset, size, stagingArena.data());
 	}
 
-	// Stores vertices in a single VBO, Non-Interleaved.
-	// P = position
-	// N = normal
-	// U = uv
-	// [P,P,P,N,N,N,U,U,U]
-	void bufferVertices_Seperate(const MeshData& meshData)
+	// Converts {count} indices to 16 bits. Every index must be below 65536.
+	void narrowIndices(const GLuint* indices, size_t count, GLushort* out)
 	{
-		const auto vertexSize = meshData.vertexSize();
-		const auto vertexCount = meshData.vertexCount();
-
-		// Size of the vertex buffer
-		const unsigned int bufferSize = vertexSize * vertexCount;
+		size_t i = 0;
+#if defined(GFX_MESH_SSE)
+		// SSE2 only packs with signed saturation: bias into the signed range, pack, then flip the bias back in 16 bits.
+		const __m128i bias32 = _mm_set1_epi32(0x8000);
+		const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+		for (; i + 8 <= count; i += 8)
+		{
+			const __m128i low = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i)), bias32);
+			const __m128i high = _mm_sub_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i + 4)), bias32);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_xor_si128(_mm_packs_epi32(low, high), bias16));
+		}
+#endif
+		for (; i < count; ++i)
+		{
+			out[i] = static_cast<GLushort>(indices[i]);
+		}
+	}
 
-		char* vertexData = new char[bufferSize];
+	// Writes {indices} as {indexType} to the bound GL_ELEMENT_ARRAY_BUFFER, starting {offset} bytes in.
+	// 16-bit indices are narrowed straight into a write-only mapping, like writeVertices.
+	void writeIndices(std::span<const GLuint> indices, GLenum indexType, size_t offset, GLbitfield invalidate)
+	{
+		if (indexType == GL_UNSIGNED_INT)
+		{
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, indices.size() * sizeof(GLuint), indices.data());
+			return;
+		}
 
-		size_t offset = 0;
-		if (meshData.vertices.has_value())
+		const size_t size = indices.size() * sizeof(GLushort);
+		if (void* mapped = glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, offset, size, GL_MAP_WRITE_BIT | invalidate))
 		{
-			memcpy(&vertexData[offset], &meshData.vertices.value()[0], sizeof(glm::vec3) * vertexCount);
+			narrowIndices(indices.data(), indices.size(), static_cast<GLushort*>(mapped));
+			if (glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER) == GL_TRUE)
+			{
+				return;
+			}
+		}
 
-			// Position attribute pointer
-			glEnableVertexAttribArray(0);
+		if (stagingArena.size() < size)
+		{
+			stagingArena.resize(size);
+		}
 
-			// Point to a 3 component vector of type Float with an offset of {offset} bytes.
-			glVertexAttribPointer(0, 3, GL_FLOAT, false, 0, (const void*)offset);
+		narrowIndices(indices.data(), indices.size(), reinterpret_cast<GLushort*>(stagingArena.data()));
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, offset, size, stagingArena.data());
+	}
 
-			offset += sizeof(glm::vec3) * vertexCount;
-		}
-		if (meshData.normals.has_value())
-		{
-			memcpy(&vertexData[offset], &meshData.normals.value()[0], sizeof(glm::vec3) * vertexCount);
+	// Allocates the bound GL_ARRAY_BUFFER and packs the vertices into it.
+	void uploadVertices(const MeshData& meshData, const VertexEncoding& encoding, size_t vertexCount, size_t bufferSize, PackVerticesFunction pack)
+	{
+		// Use STATIC_DRAW as we don't plan on updating the buffer.
+		glBufferData(GL_ARRAY_BUFFER, bufferSize, nullptr, GL_STATIC_DRAW);
+		writeVertices(meshData, encoding, vertexCount, 0, bufferSize, GL_MAP_INVALIDATE_BUFFER_BIT, pack);
+	}
 
-			// Position attribute pointer
-			glEnableVertexAttribArray(1);
+	// Points each present attribute at its data in the bound GL_ARRAY_BUFFER.
+	// Attribute locations follow the VertexAttributeFlags bit index: 0 = position, 1 = normal, 2 = uv, 3 = color.
+	void setVertexAttributePointers(unsigned int mask, const VertexFormat& format, size_t vertexCount, bool interleaved)
+	{
+		const unsigned int vertexSize = PackedVertexSize(mask, format);
 
-			// Point to a 3 component vector of type Float with an offset of {offset} bytes.
-			glVertexAttribPointer(1, 3, GL_FLOAT, false, 0, (const void*)offset);
+		size_t offset = 0;
+		for (unsigned int attribute = 0; attribute < VertexAttribute_Count; ++attribute)
+		{
+			if (!(mask & (1 << attribute))) continue;
 
-			offset += sizeof(glm::vec3) * vertexCount;
+			const VertexAttributeLayout layout = attributeLayout(attribute, format);
+			glEnableVertexAttribArray(attribute);
+			// Interleaved attributes are {vertexSize} apart, separate streams are tightly packed (stride 0).
+			glVertexAttribPointer(attribute, layout.components, layout.type, layout.normalized, interleaved ? vertexSize : 0, (const void*)offset);
+			offset += interleaved ? layout.size : layout.size * vertexCount;
 		}
-		if (meshData.uvs.has_value())
-		{
-			memcpy(&vertexData[offset], &meshData.uvs.value()[0], sizeof(glm::vec2) * vertexCount);
+	}
+
+	// Stores vertices in a single VBO, Interleaved.
+	// P = position
+	// N = normal
+	// U = uv
+	// [P,N,U,P,N,U,P,N,U]
+	void bufferVertices_Interleaved(const MeshData& meshData, const VertexEncoding& encoding)
+	{
+		const auto mask = meshData.attributeMask();
+		const auto vertexCount = meshData.vertexCount();
 
-			// Position attribute pointer
-			glEnableVertexAttribArray(2);
+		// Size of the vertex buffer
+		const size_t bufferSize = PackedVertexSize(mask, encoding.format) * vertexCount;
 
-			// Point to a 3 component vector of type Float with an offset of {offset} bytes.
-			glVertexAttribPointer(2, 2, GL_FLOAT, false, 0, (const void*)offset);
+		uploadVertices(meshData, encoding, vertexCount, bufferSize, interleavedPackers[mask]);
+		setVertexAttributePointers(mask, encoding.format, vertexCount, true);
+	}
 
-			offset += sizeof(glm::vec2) * vertexCount;
-		}
-		if (meshData.colors.has_value())
-		{
-			memcpy(&vertexData[offset], &meshData.colors.value()[0], sizeof(glm::vec4) * vertexCount);
+	// Stores vertices in a single VBO, Non-Interleaved.
+	// P = position
+	// N = normal
+	// U = uv
+	// [P,P,P,N,N,N,U,U,U]
+	void bufferVertices_Seperate(const MeshData& meshData, const VertexEncoding& encoding)
+	{
+		const auto mask = meshData.attributeMask();
+		const auto vertexCount = meshData.vertexCount();
 
-			// Position attribute pointer
-			glEnableVertexAttribArray(3);
+		// Size of the vertex buffer
+		const size_t bufferSize = PackedVertexSize(mask, encoding.format) * vertexCount;
 
-			// Point to a 3 component vector of type Float with an offset of {offset} bytes.
-			glVertexAttribPointer(3, 4, GL_FLOAT, false, 0, (const void*)offset);
+		uploadVertices(meshData, encoding, vertexCount, bufferSize, &packVertices_Seperate);
+		setVertexAttributePointers(mask, encoding.format, vertexCount, false);
+	}
 
-			offset += sizeof(glm::vec4) * vertexCount;
+	// Computes {mesh}'s bounds (and quantization transform, if positions are quantized) and the encoding to pack its vertices with.
+	VertexEncoding prepareEncoding(const MeshData& meshData, const VertexFormat& format, Mesh& mesh)
+	{
+		// Bounds of the positions, used for culling and for quantization.
+		glm::vec3 boundsMin(0.0f);
+		glm::vec3 boundsMax(0.0f);
+		if (!meshData.vertices().empty())
+		{
+			boundsMin = meshData.vertices()[0];
+			boundsMax = boundsMin;
+			for (const glm::vec3& vertex : meshData.vertices())
+			{
+				boundsMin = glm::min(boundsMin, vertex);
+				boundsMax = glm::max(boundsMax, vertex);
+			}
 		}
+		mesh.boundsMin = boundsMin;
+		mesh.boundsMax = boundsMax;
 
-		// Write out vertex data to the buffer. Use STATIC_DRAW as we don't plan on updating the buffer.
-		glBufferData(GL_ARRAY_BUFFER, bufferSize, vertexData, GL_STATIC_DRAW);
-
-		delete[] vertexData;
+		VertexEncoding encoding{ format, glm::vec3(0.0f), glm::vec3(1.0f) };
+		if (format.position == PositionFormat_SNorm16 && meshData.hasAttribute(VertexAttribute_Position))
+		{
+			// Quantize to the mesh bounds. Flat axes (eg. a Quad's z) keep a non-zero scale.
+			const glm::vec3 positionScale = glm::max((boundsMax - boundsMin) * 0.5f, glm::vec3(1e-6f));
+			encoding.positionOffset = (boundsMin + boundsMax) * 0.5f;
+			encoding.positionInverseScale = 1.0f / positionScale;
+
+			mesh.positionScale = positionScale;
+			mesh.positionOffset = encoding.positionOffset;
+			mesh.quantizedPositions = true;
+		}
+		return encoding;
 	}
 
-	Mesh CreateMesh(const MeshData& meshData, bool interleaved)
+	Mesh CreateMesh(const MeshData& meshData, bool interleaved, const VertexFormat& format)
 	{
-		// Check that vertices are > 0 in size and that all attributes match in length. (eg. same amount of vertex positions and normals).
+		// Check that there are attributes and vertices. Every stream of a MeshData has vertexCount() elements.
 		const auto vertexSize = meshData.vertexSize();
 		const auto vertexCount = meshData.vertexCount();
-		if (vertexSize == 0 || !meshData.validAttributeCount())
+		if (vertexSize == 0 || vertexCount == 0)
 		{
 			return Mesh();
 		}
 
+		Mesh mesh;
+		const VertexEncoding encoding = prepareEncoding(meshData, format, mesh);
+
 		GLuint vao = 0;
 		GLuint vbo = 0;
 		GLuint ibo = 0;
@@ -174,68 +519,442 @@ namespace gfx
 		// Generate a buffer for the vertices
 		glGenBuffers(1, &vbo);
 
-		// Generate a buffer for the indices
-		glGenBuffers(1, &ibo);
-
 		// Bind the vao to capture our mesh attribtues
-		glBindVertexArray(vao);
+		BindVertexArray(vao);
 
 		// Bind the vertex buffer so we can modify it
-		glBindBuffer(GL_ARRAY_BUFFER, vbo);
+		BindBuffer(GL_ARRAY_BUFFER, vbo);
 
 		if (interleaved)
 		{
-			bufferVertices_Interleaved(meshData);
+			bufferVertices_Interleaved(meshData, encoding);
 		}
 		else
 		{
-			bufferVertices_Seperate(meshData);
+			bufferVertices_Seperate(meshData, encoding);
 		}
 
-		if (meshData.indices.has_value())
+		mesh.indexType = meshData.indexType();
+		if (meshData.hasIndices())
 		{
-			// Bind index buffer and upload index data
-			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
-			glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(GLuint) * meshData.indices.value().size(), meshData.indices.value().data(), GL_STATIC_DRAW);
+			// Generate a buffer for the indices, bind it and upload index data
+			glGenBuffers(1, &ibo);
+			BindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indexSize() * meshData.indexCount(), nullptr, GL_STATIC_DRAW);
+			writeIndices(meshData.indices(), mesh.indexType, 0, GL_MAP_INVALIDATE_BUFFER_BIT);
 		}
 
-		// Cleanup opengl state
-		// Unbind VAO first so the IBO doesn't get removed from the VAO state vector.
-		glBindVertexArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
-		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+		// The VAO and buffers stay bound: whatever binds next goes through the state cache, which skips the rebind if it's us.
+		mesh.vao = vao;
+		mesh.vbo = vbo;
+		mesh.ibo = ibo;
+		mesh.vertexCount = vertexCount;
+		mesh.indexCount = meshData.indexCount();
+		return mesh;
+	}
 
-		if (meshData.indices.has_value())
+	// Copies the first {size} bytes of {buffer} into a new buffer of {capacity} bytes and deletes {buffer}. Returns the new buffer.
+	GLuint growBuffer(GLuint buffer, size_t size, size_t capacity)
+	{
+		GLuint grown = 0;
+		glGenBuffers(1, &grown);
+		BindBuffer(GL_COPY_WRITE_BUFFER, grown);
+		glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_STATIC_DRAW);
+
+		if (buffer)
 		{
-			return Mesh(vao, vbo, ibo, vertexCount, meshData.indices.value().size());
+			BindBuffer(GL_COPY_READ_BUFFER, buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, size);
+			DeleteBuffer(buffer);
+		}
+
+		return grown;
+	}
+
+	// Allocates {count} units of {allocator}. When no free range fits, {buffer} ({unitSize} bytes per unit) is grown
+	// to at least double its size and {grown} is set, so the caller can rebind it.
+	size_t allocatePoolRange(RangeAllocator& allocator, GLuint& buffer, size_t unitSize, size_t initialCapacity, size_t count, bool& grown)
+	{
+		grown = false;
+		if (const auto offset = allocator.Allocate(count))
+		{
+			return offset.value();
+		}
+
+		// The free tail of the old range merges with the new space, so capacity + count always fits.
+		size_t capacity = std::max(allocator.Capacity() * 2, initialCapacity);
+		while (capacity < allocator.Capacity() + count)
+		{
+			capacity *= 2;
+		}
+
+		buffer = growBuffer(buffer, allocator.Capacity() * unitSize, capacity * unitSize);
+		allocator.Grow(capacity);
+		grown = true;
+		return allocator.Allocate(count).value();
+	}
+
+	// The pool of meshes with {mask}, {format} and {indexType}, created on first use.
+	MeshPool& findPool(unsigned int mask, const VertexFormat& format, GLenum indexType)
+	{
+		MeshPool& pool = meshPools[poolKey(mask, format, indexType)];
+		if (pool.vao == 0)
+		{
+			pool.mask = mask;
+			pool.format = format;
+			pool.vertexSize = PackedVertexSize(mask, format);
+			pool.indexType = indexType;
+			pool.indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+			glGenVertexArrays(1, &pool.vao);
+		}
+		return pool;
+	}
+
+	// Allocates {mesh}'s vertices (and indices) out of {pool} and fills in its pooled fields. Leaves the pool's VAO and VBO bound
+	// for writing the data; the pool's IBO is bound to its VAO, so index uploads go through the VAO binding.
+	void allocatePooledMesh(MeshPool& pool, size_t vertexCount, size_t indexCount, Mesh& mesh)
+	{
+		BindVertexArray(pool.vao);
+
+		bool grown = false;
+		const size_t baseVertex = allocatePoolRange(pool.vertices, pool.vbo, pool.vertexSize, poolVertexCapacity, vertexCount, grown);
+		BindBuffer(GL_ARRAY_BUFFER, pool.vbo);
+		if (grown)
+		{
+			setVertexAttributePointers(pool.mask, pool.format, 0, true);
+		}
+
+		size_t firstIndex = 0;
+		if (indexCount > 0)
+		{
+			firstIndex = allocatePoolRange(pool.indices, pool.ibo, pool.indexSize, poolIndexCapacity, indexCount, grown);
+			if (grown)
+			{
+				BindBuffer(GL_ELEMENT_ARRAY_BUFFER, pool.ibo);
+			}
+		}
+
+		mesh.vao = pool.vao;
+		mesh.vertexCount = vertexCount;
+		mesh.indexCount = indexCount;
+		mesh.indexType = pool.indexType;
+		mesh.baseVertex = static_cast<GLint>(baseVertex);
+		mesh.firstIndex = firstIndex;
+		mesh.pooled = true;
+	}
+
+	Mesh CreatePooledMesh(const MeshData& meshData, const VertexFormat& format)
+	{
+		const auto vertexCount = meshData.vertexCount();
+		if (meshData.vertexSize() == 0 || vertexCount == 0)
+		{
+			return Mesh();
+		}
+
+		Mesh mesh;
+		const VertexEncoding encoding = prepareEncoding(meshData, format, mesh);
+
+		const unsigned int mask = meshData.attributeMask();
+		// Indices are relative to the mesh's base vertex, so only the mesh's own vertex count decides the index type.
+		MeshPool& pool = findPool(mask, format, meshData.indexType());
+		allocatePooledMesh(pool, vertexCount, meshData.indexCount(), mesh);
+
+		writeVertices(meshData, encoding, vertexCount, mesh.baseVertex * pool.vertexSize, vertexCount * pool.vertexSize, GL_MAP_INVALIDATE_RANGE_BIT, interleavedPackers[mask]);
+		if (mesh.hasIndices())
+		{
+			writeIndices(meshData.indices(), pool.indexType, mesh.firstIndex * pool.indexSize, GL_MAP_INVALIDATE_RANGE_BIT);
+		}
+		return mesh;
+	}
+
+	// Copies the bounds and quantization transform of {packed} to {mesh}.
+	void applyPackedTransform(const PackedMeshData& packed, Mesh& mesh)
+	{
+		mesh.positionScale = packed.positionScale;
+		mesh.positionOffset = packed.positionOffset;
+		mesh.quantizedPositions = packed.quantizedPositions;
+		mesh.boundsMin = packed.boundsMin;
+		mesh.boundsMax = packed.boundsMax;
+	}
+
+	PackedMeshData PackMeshData(const MeshData& meshData, const VertexFormat& format, std::vector<char>& vertices, std::vector<char>& indices)
+	{
+		Mesh mesh;
+		const VertexEncoding encoding = prepareEncoding(meshData, format, mesh);
+
+		PackedMeshData packed;
+		packed.attributeMask = meshData.attributeMask();
+		packed.format = format;
+		packed.vertexCount = meshData.vertexCount();
+		packed.indexCount = meshData.indexCount();
+		packed.indexType = meshData.indexType();
+		packed.positionScale = mesh.positionScale;
+		packed.positionOffset = mesh.positionOffset;
+		packed.quantizedPositions = mesh.quantizedPositions;
+		packed.boundsMin = mesh.boundsMin;
+		packed.boundsMax = mesh.boundsMax;
+
+		vertices.resize(PackedVertexSize(packed.attributeMask, format) * packed.vertexCount);
+		interleavedPackers[packed.attributeMask](meshData, encoding, packed.vertexCount, vertices.data());
+
+		if (packed.indexType == GL_UNSIGNED_SHORT)
+		{
+			indices.resize(packed.indexCount * sizeof(GLushort));
+			narrowIndices(meshData.indices().data(), packed.indexCount, reinterpret_cast<GLushort*>(indices.data()));
 		}
 		else
 		{
-			return Mesh(vao, vbo, vertexCount);
+			indices.resize(packed.indexCount * sizeof(GLuint));
+			memcpy(indices.data(), meshData.indices().data(), indices.size());
 		}
+
+		packed.vertices = vertices.data();
+		packed.indices = indices.data();
+		return packed;
 	}
 
-	void DeleteMesh(Mesh& mesh)
+	Mesh CreateMesh(const PackedMeshData& packed)
+	{
+		if (packed.attributeMask == 0 || packed.vertexCount == 0)
+		{
+			return Mesh();
+		}
+
+		Mesh mesh;
+		applyPackedTransform(packed, mesh);
+
+		glGenVertexArrays(1, &mesh.vao);
+		glGenBuffers(1, &mesh.vbo);
+		BindVertexArray(mesh.vao);
+		BindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+		glBufferData(GL_ARRAY_BUFFER, PackedVertexSize(packed.attributeMask, packed.format) * packed.vertexCount, packed.vertices, GL_STATIC_DRAW);
+		setVertexAttributePointers(packed.attributeMask, packed.format, packed.vertexCount, true);
+
+		mesh.indexType = packed.indexType;
+		if (packed.indexCount > 0)
+		{
+			glGenBuffers(1, &mesh.ibo);
+			BindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ibo);
+			glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.indexSize() * packed.indexCount, packed.indices, GL_STATIC_DRAW);
+		}
+
+		mesh.vertexCount = packed.vertexCount;
+		mesh.indexCount = packed.indexCount;
+		return mesh;
+	}
+
+	Mesh CreatePooledMesh(const PackedMeshData& packed)
 	{
+		if (packed.attributeMask == 0 || packed.vertexCount == 0)
+		{
+			return Mesh();
+		}
+
+		Mesh mesh;
+		applyPackedTransform(packed, mesh);
+
+		MeshPool& pool = findPool(packed.attributeMask, packed.format, packed.indexType);
+		allocatePooledMesh(pool, packed.vertexCount, packed.indexCount, mesh);
+
+		glBufferSubData(GL_ARRAY_BUFFER, mesh.baseVertex * pool.vertexSize, packed.vertexCount * pool.vertexSize, packed.vertices);
 		if (mesh.hasIndices())
 		{
-			glDeleteBuffers(1, &mesh.ibo);
+			glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, mesh.firstIndex * pool.indexSize, packed.indexCount * pool.indexSize, packed.indices);
 		}
+		return mesh;
+	}
 
-		glDeleteBuffers(1, &mesh.vbo);
-		glDeleteVertexArrays(1, &mesh.vao);
+	void DeleteMesh(Mesh& mesh)
+	{
+		if (mesh.cacheSlot != 0)
+		{
+			ReleaseCachedMesh(mesh);
+			return;
+		}
+
+		if (mesh.pooled)
+		{
+			// Only the ranges are released, the pool keeps its buffers and VAO.
+			for (auto& [key, pool] : meshPools)
+			{
+				if (pool.vao == mesh.vao)
+				{
+					pool.vertices.Free(mesh.baseVertex, mesh.vertexCount);
+					pool.indices.Free(mesh.firstIndex, mesh.indexCount);
+					break;
+				}
+			}
+
+			mesh.vertexCount = 0;
+			mesh.indexCount = 0;
+			return;
+		}
+
+		// VAO names get reused, so forget this one's instance attribute setup.
+		instancedVaos.erase(mesh.vao);
+
+		DeleteBuffer(mesh.ibo);
+		DeleteBuffer(mesh.vbo);
+		DeleteVertexArray(mesh.vao);
 
 		mesh.vertexCount = 0;
 		mesh.indexCount = 0;
 	}
 
+	void DeleteMeshPools()
+	{
+		for (auto& [key, pool] : meshPools)
+		{
+			instancedVaos.erase(pool.vao);
+			DeleteBuffer(pool.ibo);
+			DeleteBuffer(pool.vbo);
+			DeleteVertexArray(pool.vao);
+		}
+		meshPools.clear();
+	}
+
+	MeshPoolStats GetMeshPoolStats()
+	{
+		MeshPoolStats stats{};
+		for (const auto& [key, pool] : meshPools)
+		{
+			++stats.pools;
+			stats.glObjects += 1 + (pool.vbo != 0) + (pool.ibo != 0);
+			stats.vertexBytes += pool.vertices.Capacity() * pool.vertexSize;
+			stats.vertexBytesUsed += pool.vertices.Used() * pool.vertexSize;
+			stats.indexBytes += pool.indices.Capacity() * pool.indexSize;
+			stats.indexBytesUsed += pool.indices.Used() * pool.indexSize;
+		}
+		return stats;
+	}
+
 	void DrawMesh(const Mesh& mesh)
 	{
-		glBindVertexArray(mesh.vao);
+		BindMesh(mesh);
+		DrawBoundMesh(mesh);
+	}
+
+	void BindMesh(const Mesh& mesh)
+	{
+		BindVertexArray(mesh.vao);
+	}
+
+	void DrawBoundMesh(const Mesh& mesh)
+	{
+		if (mesh.hasIndices())
+			glDrawElementsBaseVertex(GL_TRIANGLES, mesh.indexCount, mesh.indexType, mesh.indexOffset(), mesh.baseVertex);
+		else
+			glDrawArrays(GL_TRIANGLE_STRIP, mesh.baseVertex, mesh.vertexCount);
+	}
+
+	// Points the instance attributes of the bound VAO at the bound instance buffer, starting {offset} bytes in.
+	void pointInstanceAttributes(size_t offset)
+	{
+		for (GLuint column = 0; column < 4; ++column)
+		{
+			glVertexAttribPointer(instanceAttributeLocation + column, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const void*)(offset + offsetof(InstanceData, model) + sizeof(glm::vec4) * column));
+		}
+
+		glVertexAttribPointer(instanceAttributeLocation + 4, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const void*)(offset + offsetof(InstanceData, color)));
+		glVertexAttribPointer(instanceAttributeLocation + 5, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const void*)(offset + offsetof(InstanceData, positionScale)));
+		glVertexAttribPointer(instanceAttributeLocation + 6, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const void*)(offset + offsetof(InstanceData, positionOffset)));
+	}
+
+	// Enables the instance attributes of the bound VAO, advancing once per instance, and points them at the bound instance buffer.
+	void setInstanceAttributePointers()
+	{
+		for (GLuint location = instanceAttributeLocation; location < instanceAttributeLocation + 7; ++location)
+		{
+			glEnableVertexAttribArray(location);
+			glVertexAttribDivisor(location, 1);
+		}
+		pointInstanceAttributes(0);
+	}
+
+	// Binds {buffer} to {target} and replaces its contents with {size} bytes of {data}, orphaning the previous
+	// contents so we don't wait on draws still reading them. The capacity only grows.
+	void streamBuffer(GLenum target, GLuint& buffer, size_t& capacity, const void* data, size_t size)
+	{
+		if (buffer == 0)
+		{
+			glGenBuffers(1, &buffer);
+		}
+
+		BindBuffer(target, buffer);
+
+		if (size > capacity)
+		{
+			capacity = std::max(size, capacity * 2);
+		}
+		glBufferData(target, capacity, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(target, 0, size, data);
+	}
+
+	void DrawMeshInstanced(const Mesh& mesh, std::span<const InstanceData> instances)
+	{
+		if (instances.empty())
+		{
+			return;
+		}
+
+		streamBuffer(GL_ARRAY_BUFFER, instanceBuffer, instanceBufferCapacity, instances.data(), instances.size_bytes());
+
+		BindVertexArray(mesh.vao);
+
+		if (instancedVaos.insert(mesh.vao).second)
+		{
+			setInstanceAttributePointers();
+		}
+
 		if (mesh.hasIndices())
-			glDrawElements(GL_TRIANGLES, mesh.indexCount, GL_UNSIGNED_INT, (void*)0);
+			glDrawElementsInstancedBaseVertex(GL_TRIANGLES, mesh.indexCount, mesh.indexType, mesh.indexOffset(), instances.size(), mesh.baseVertex);
+		else
+			glDrawArraysInstanced(GL_TRIANGLE_STRIP, mesh.baseVertex, mesh.vertexCount, instances.size());
+	}
+
+	bool MultiDrawIndirectSupported()
+	{
+		return GLEW_ARB_multi_draw_indirect && GLEW_ARB_base_instance;
+	}
+
+	void MultiDrawMeshes(GLuint vao, GLenum indexType, std::span<const DrawElementsIndirectCommand> commands, std::span<const InstanceData> instances)
+	{
+		if (commands.empty() || instances.empty())
+		{
+			return;
+		}
+
+		streamBuffer(GL_ARRAY_BUFFER, instanceBuffer, instanceBufferCapacity, instances.data(), instances.size_bytes());
+
+		BindVertexArray(vao);
+
+		if (instancedVaos.insert(vao).second)
+		{
+			setInstanceAttributePointers();
+		}
+
+		if (MultiDrawIndirectSupported())
+		{
+			// baseInstance offsets the instance attributes, so every command finds its own instances.
+			streamBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer, indirectBufferCapacity, commands.data(), commands.size_bytes());
+			glMultiDrawElementsIndirect(GL_TRIANGLES, indexType, nullptr, commands.size(), 0);
+		}
 		else
-			glDrawArrays(GL_TRIANGLE_STRIP, 0, mesh.vertexCount);
-		glBindVertexArray(0);
+		{
+			// GL 3.3 has neither base instance nor gl_DrawID (so glMultiDrawElementsBaseVertex can't tell its draws apart):
+			// point the instance attributes at each command's instances in turn.
+			for (const DrawElementsIndirectCommand& command : commands)
+			{
+				pointInstanceAttributes(command.baseInstance * sizeof(InstanceData));
+				const size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+				glDrawElementsInstancedBaseVertex(GL_TRIANGLES, command.count, indexType, (void*)(command.firstIndex * indexSize), command.instanceCount, command.baseVertex);
+			}
+
+			// DrawMeshInstanced expects the attributes at the start of the buffer.
+			if (commands.back().baseInstance != 0)
+			{
+				pointInstanceAttributes(0);
+			}
+		}
 	}
-}
\ No newline at end of file
+}
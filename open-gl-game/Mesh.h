@@ -1,51 +1,133 @@
 #pragma once
-#include <optional>
+#include <cstddef>
+#include <memory>
+#include <span>
 #include <vector>
 #include <GL/glew.h>
 #include <glm/glm.hpp>
 
 namespace gfx
 {
+	// Bitmask of the vertex attributes present in a MeshData.
+	enum VertexAttributeFlags : unsigned int
+	{
+		VertexAttribute_Position	= 1 << 0,
+		VertexAttribute_Normal		= 1 << 1,
+		VertexAttribute_UV			= 1 << 2,
+		VertexAttribute_Color		= 1 << 3,
+		VertexAttribute_Count		= 4
+	};
+
+	// GPU storage formats, selected per attribute at CreateMesh time. MeshData always holds floats; CreateMesh converts while packing.
+	enum PositionFormat
+	{
+		// 3 x float, 12 bytes.
+		PositionFormat_Float3,
+		// 4 x normalized short, 8 bytes. Quantized to the mesh bounds, see Mesh::positionTransform().
+		PositionFormat_SNorm16
+	};
+
+	enum NormalFormat
+	{
+		// 3 x float, 12 bytes.
+		NormalFormat_Float3,
+		// GL_INT_2_10_10_10_REV, normalized. 4 bytes.
+		NormalFormat_Int2_10_10_10
+	};
+
+	enum UVFormat
+	{
+		// 2 x float, 8 bytes.
+		UVFormat_Float2,
+		// 2 x half float, 4 bytes.
+		UVFormat_Half2
+	};
+
+	enum ColorFormat
+	{
+		// 4 x float, 16 bytes.
+		ColorFormat_Float4,
+		// RGBA8 unorm, 4 bytes.
+		ColorFormat_UNorm8
+	};
+
+	struct VertexFormat
+	{
+		PositionFormat	position;
+		NormalFormat	normal;
+		UVFormat		uv;
+		ColorFormat		color;
+	};
+
+	// Full precision floats for every attribute.
+	constexpr VertexFormat VertexFormat_Float = { PositionFormat_Float3, NormalFormat_Float3, UVFormat_Float2, ColorFormat_Float4 };
+	// Smallest formats. A lit vertex (position + normal) is 12 bytes instead of 24.
+	constexpr VertexFormat VertexFormat_Compact = { PositionFormat_SNorm16, NormalFormat_Int2_10_10_10, UVFormat_Half2, ColorFormat_UNorm8 };
+
+	// Vertex and index data of a mesh: one arena allocation holding a stream per attribute present (structure of arrays)
+	// followed by the indices. Generators allocate it at its final size and write the streams in place, CreateMesh reads them
+	// as contiguous arrays. Move-only, deep copies go through Clone().
 	class MeshData
 	{
 	public:
-		std::optional<std::vector<glm::vec3>>	vertices;
-		std::optional<std::vector<glm::vec3>>	normals;
-		std::optional<std::vector<glm::vec2>>	uvs;
-		std::optional<std::vector<glm::vec4>>	colors;
-		std::optional<std::vector<GLuint>>		indices;
+		MeshData() = default;
+		// Room for {vertexCount} vertices with the attributes of {attributeMask} and {indexCount} indices. Contents are uninitialized.
+		MeshData(unsigned int attributeMask, size_t vertexCount, size_t indexCount = 0);
+		MeshData(MeshData&& other) noexcept;
+		MeshData& operator=(MeshData&& other) noexcept;
+		MeshData(const MeshData&) = delete;
+		MeshData& operator=(const MeshData&) = delete;
+
+		MeshData Clone() const;
+		// Drops trailing vertices and indices. The streams stay where they are, nothing is copied.
+		void Shrink(size_t vertexCount, size_t indexCount);
+
+		// Absent attributes are empty spans.
+		inline std::span<glm::vec3> vertices()				{ return { positionStream, positionStream ? numVertices : 0 }; }
+		inline std::span<const glm::vec3> vertices() const	{ return { positionStream, positionStream ? numVertices : 0 }; }
+		inline std::span<glm::vec3> normals()				{ return { normalStream, normalStream ? numVertices : 0 }; }
+		inline std::span<const glm::vec3> normals() const	{ return { normalStream, normalStream ? numVertices : 0 }; }
+		inline std::span<glm::vec2> uvs()					{ return { uvStream, uvStream ? numVertices : 0 }; }
+		inline std::span<const glm::vec2> uvs() const		{ return { uvStream, uvStream ? numVertices : 0 }; }
+		inline std::span<glm::vec4> colors()				{ return { colorStream, colorStream ? numVertices : 0 }; }
+		inline std::span<const glm::vec4> colors() const	{ return { colorStream, colorStream ? numVertices : 0 }; }
+		inline std::span<GLuint> indices()					{ return { indexStream, numIndices }; }
+		inline std::span<const GLuint> indices() const		{ return { indexStream, numIndices }; }
+
+		inline unsigned int attributeMask() const { return mask; }
+		inline bool hasAttribute(VertexAttributeFlags attribute) const { return (mask & attribute) != 0; }
+		inline bool hasIndices() const { return numIndices != 0; }
+		inline size_t vertexCount() const { return numVertices; }
+		inline size_t indexCount() const { return numIndices; }
 
 		inline unsigned int vertexSize() const
 		{
 			unsigned int size = 0;
-			if (vertices.has_value())	size += sizeof(glm::vec3);
-			if (normals.has_value())	size += sizeof(glm::vec3);
-			if (colors.has_value())		size += sizeof(glm::vec4);
-			if (uvs.has_value())		size += sizeof(glm::vec2);
+			if (mask & VertexAttribute_Position)	size += sizeof(glm::vec3);
+			if (mask & VertexAttribute_Normal)		size += sizeof(glm::vec3);
+			if (mask & VertexAttribute_Color)		size += sizeof(glm::vec4);
+			if (mask & VertexAttribute_UV)			size += sizeof(glm::vec2);
 			return size;
 		}
 
-		inline size_t vertexCount() const
+		// Narrowest index type that addresses every vertex, the one CreateMesh stores the indices as.
+		// 16-bit indices stop at 65534 so 65535 stays free as the primitive restart index.
+		inline GLenum indexType() const
 		{
-			const size_t vertexCount = vertices.has_value() ? vertices.value().size() : 0;
-			const size_t normalsCount = normals.has_value() ? normals.value().size() : 0;
-			const size_t colorsCount = colors.has_value() ? colors.value().size() : 0;
-			const size_t uvCount = uvs.has_value() ? uvs.value().size() : 0;
-			return std::max({ vertexCount, normalsCount, colorsCount, uvCount });
+			return vertexCount() <= 65535 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 		}
 
-		inline bool validAttributeCount() const
-		{
-			const size_t vertexCount	= vertices.has_value() ? vertices.value().size() : 0;
-			const size_t normalsCount	= normals.has_value() ? normals.value().size() : 0;
-			const size_t colorsCount	= colors.has_value() ? colors.value().size() : 0;
-			const size_t uvCount		= uvs.has_value() ? uvs.value().size() : 0;
-			const size_t max			= std::max({ vertexCount, normalsCount, colorsCount, uvCount });
-			return	(vertexCount == 0 || vertexCount == max) &&
-					(normalsCount == 0 || normalsCount == max) &&
-					(colorsCount == 0 || colorsCount == max) &&
-					(uvCount == 0 || uvCount == max);
-		}
+	private:
+		std::unique_ptr<std::byte[]>	arena;
+		unsigned int					mask = 0;
+		size_t							numVertices = 0;
+		size_t							numIndices = 0;
+		// Point into {arena}, null for absent attributes.
+		glm::vec3*						positionStream = nullptr;
+		glm::vec3*						normalStream = nullptr;
+		glm::vec2*						uvStream = nullptr;
+		glm::vec4*						colorStream = nullptr;
+		GLuint*							indexStream = nullptr;
 	};
 
 	class Mesh
@@ -56,10 +138,27 @@ namespace gfx
 		GLuint ibo;
 		size_t vertexCount;
 		size_t indexCount;
+		// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT, see MeshData::indexType().
+		GLenum indexType = GL_UNSIGNED_INT;
+		// Maps quantized positions back to mesh space: position = stored * positionScale + positionOffset.
+		glm::vec3 positionScale = glm::vec3(1.0f);
+		glm::vec3 positionOffset = glm::vec3(0.0f);
+		bool quantizedPositions = false;
+		// Mesh space bounding box of the vertex positions.
+		glm::vec3 boundsMin = glm::vec3(0.0f);
+		glm::vec3 boundsMax = glm::vec3(0.0f);
+		// Where the mesh starts in its buffers. Only non-zero for meshes suballocated by CreatePooledMesh,
+		// which share their VAO and buffers (vbo and ibo are 0) with every pooled mesh of the same vertex format.
+		GLint baseVertex = 0;
+		size_t firstIndex = 0;
+		bool pooled = false;
+		// Non-zero for meshes shared through CreateCachedMesh. DeleteMesh then only releases a reference.
+		GLuint cacheSlot = 0;
 
 		Mesh() :
 			vao(0),
 			vbo(0),
+			ibo(0),
 			vertexCount(0),
 			indexCount(0)
 		{}
@@ -67,6 +166,7 @@ namespace gfx
 		Mesh(GLuint vao, GLuint vbo, size_t vertexCount) :
 			vao(vao),
 			vbo(vbo),
+			ibo(0),
 			vertexCount(vertexCount),
 			indexCount(0)
 		{}
@@ -80,10 +180,112 @@ namespace gfx
 		{}
 
 		inline bool isValid() const { return vao != 0; }
-		inline bool hasIndices() const { return ibo != 0; }
+		inline bool hasIndices() const { return indexCount != 0; }
+		inline bool hasQuantizedPositions() const { return quantizedPositions; }
+		inline size_t indexSize() const { return indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint); }
+		// Byte offset of the mesh's first index in its index buffer, as passed to glDrawElements*.
+		inline const void* indexOffset() const { return (const void*)(firstIndex * indexSize()); }
+
+		// Model space transform to apply to positions before the model matrix. Identity unless positions are quantized.
+		inline glm::mat4 positionTransform() const
+		{
+			glm::mat4 transform(positionScale.x, 0, 0, 0,
+								0, positionScale.y, 0, 0,
+								0, 0, positionScale.z, 0,
+								positionOffset.x, positionOffset.y, positionOffset.z, 1);
+			return transform;
+		}
 	};
 
-	Mesh CreateMesh(const MeshData& meshData, bool interleaved = true);
+	// Per-instance vertex data streamed by DrawMeshInstanced and MultiDrawMeshes.
+	// Instanced shaders read it from attribute locations 4-7 (model matrix columns), 8 (color) and 9-10 (position dequantization).
+	struct InstanceData
+	{
+		glm::mat4 model;
+		glm::vec4 color;
+		// The mesh's positionScale and positionOffset (w unused), per instance so meshes with different
+		// quantization can share a multi-draw.
+		glm::vec4 positionScale;
+		glm::vec4 positionOffset;
+	};
+
+	inline InstanceData MakeInstanceData(const Mesh& mesh, const glm::mat4& model, const glm::vec4& color)
+	{
+		return { model, color, glm::vec4(mesh.positionScale, 0.0f), glm::vec4(mesh.positionOffset, 0.0f) };
+	}
+
+	// Layout of one glMultiDrawElementsIndirect command.
+	struct DrawElementsIndirectCommand
+	{
+		GLuint	count;
+		GLuint	instanceCount;
+		GLuint	firstIndex;
+		GLint	baseVertex;
+		// First InstanceData of the command.
+		GLuint	baseInstance;
+	};
+
+	struct MeshPoolStats
+	{
+		// One pool per attribute mask, vertex format and index type.
+		size_t pools;
+		// VAOs plus buffer objects owned by the pools.
+		size_t glObjects;
+		size_t vertexBytes;
+		size_t vertexBytesUsed;
+		size_t indexBytes;
+		size_t indexBytesUsed;
+	};
+
+	// A mesh's vertices and indices already in the layout CreateMesh uploads: interleaved attributes of {format}, indices as {indexType}.
+	// Points at memory owned elsewhere, eg. a mapped MeshFile.
+	struct PackedMeshData
+	{
+		unsigned int	attributeMask = 0;
+		VertexFormat	format = VertexFormat_Float;
+		size_t			vertexCount = 0;
+		size_t			indexCount = 0;
+		GLenum			indexType = GL_UNSIGNED_INT;
+		const void*		vertices = nullptr;
+		const void*		indices = nullptr;
+		// Copied to the Mesh, see there.
+		glm::vec3		positionScale = glm::vec3(1.0f);
+		glm::vec3		positionOffset = glm::vec3(0.0f);
+		bool			quantizedPositions = false;
+		glm::vec3		boundsMin = glm::vec3(0.0f);
+		glm::vec3		boundsMax = glm::vec3(0.0f);
+	};
+
+	// Bytes per interleaved vertex with the attributes of {attributeMask} stored as {format}.
+	unsigned int PackedVertexSize(unsigned int attributeMask, const VertexFormat& format);
+	// Packs {meshData} the way CreateMesh uploads it (interleaved) into {vertices} and {indices}, which the result points into.
+	PackedMeshData PackMeshData(const MeshData& meshData, const VertexFormat& format, std::vector<char>& vertices, std::vector<char>& indices);
+
+	// Indices are uploaded as MeshData::indexType(), narrowed to 16 bits when the vertex count allows.
+	Mesh CreateMesh(const MeshData& meshData, bool interleaved = true, const VertexFormat& format = VertexFormat_Float);
+	// Like CreateMesh (interleaved), but suballocates the vertices and indices out of large buffers shared by every pooled mesh
+	// with the same attributes, format and index type, which also share one VAO. Drawing such meshes back to back needs no rebinding.
+	Mesh CreatePooledMesh(const MeshData& meshData, const VertexFormat& format = VertexFormat_Float);
+	// Upload already packed data as is, with no conversion or intermediate copy.
+	Mesh CreateMesh(const PackedMeshData& packed);
+	Mesh CreatePooledMesh(const PackedMeshData& packed);
+	// Frees the mesh's buffers, or its ranges of the pool buffers for a pooled mesh.
+	// A cached mesh (see CreateCachedMesh) is only freed once its last reference is deleted.
 	void DeleteMesh(Mesh& mesh);
+	// Deletes the pool buffers and VAOs. Pooled meshes still alive become invalid.
+	void DeleteMeshPools();
+	MeshPoolStats GetMeshPoolStats();
 	void DrawMesh(const Mesh& mesh);
+	// Binds {mesh}'s VAO so a run of draws of the same mesh can use DrawBoundMesh without rebinding.
+	void BindMesh(const Mesh& mesh);
+	// Draws {mesh}, which must already be bound with BindMesh.
+	void DrawBoundMesh(const Mesh& mesh);
+	// Draws {instances}.size() copies of {mesh} with a single draw call.
+	void DrawMeshInstanced(const Mesh& mesh, std::span<const InstanceData> instances);
+	// True when MultiDrawMeshes submits with a single glMultiDrawElementsIndirect (GL_ARB_multi_draw_indirect and GL_ARB_base_instance).
+	bool MultiDrawIndirectSupported();
+	// Draws {commands}, all of indexed meshes sharing {vao} (ie. pooled meshes of one vertex format) and its {indexType}.
+	// Each command's instances are read from {instances} starting at its baseInstance.
+	// Without indirect support, falls back to one instanced draw per command.
+	void MultiDrawMeshes(GLuint vao, GLenum indexType, std::span<const DrawElementsIndirectCommand> commands, std::span<const InstanceData> instances);
 }
\ No newline at end of file
@@ -0,0 +1,262 @@
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <unordered_map>
+#include <vector>
+#include "MeshCache.h"
+#include "MeshFile.h"
+#include "MeshOptimizer.h"
+
+namespace gfx
+{
+	struct CachedMeshKey
+	{
+		PrimitiveDesc	primitive;
+		VertexFormat	format;
+		bool			pooled;
+
+		bool operator==(const CachedMeshKey& other) const
+		{
+			return	primitive == other.primitive &&
+					format.position == other.format.position && format.normal == other.format.normal &&
+					format.uv == other.format.uv && format.color == other.format.color &&
+					pooled == other.pooled;
+		}
+	};
+
+	inline void hashCombine(size_t& seed, size_t value)
+	{
+		seed ^= value + 0x9E3779B97F4A7C15ull + (seed << 6) + (seed >> 2);
+	}
+
+	struct PrimitiveDescHash
+	{
+		size_t operator()(const PrimitiveDesc& primitive) const
+		{
+			size_t seed = std::hash<int>()(primitive.type);
+			for (int i = 0; i < 3; ++i)
+			{
+				hashCombine(seed, std::hash<float>()(primitive.size[i]));
+				hashCombine(seed, std::hash<int>()(primitive.segments[i]));
+			}
+			return seed;
+		}
+	};
+
+	struct CachedMeshKeyHash
+	{
+		size_t operator()(const CachedMeshKey& key) const
+		{
+			size_t seed = PrimitiveDescHash()(key.primitive);
+			hashCombine(seed, key.format.position | key.format.normal << 2 | key.format.uv << 4 | key.format.color << 6 | key.pooled << 8);
+			return seed;
+		}
+	};
+
+	struct CachedMesh
+	{
+		CachedMeshKey	key;
+		// The mesh as created, without its cache slot, so it can be passed straight to DeleteMesh.
+		Mesh			mesh;
+		size_t			references;
+	};
+
+	// Mesh::cacheSlot is the index in cachedMeshes plus one, 0 marks an uncached mesh.
+	// Slots of freed meshes are reused, so handed out slots stay stable.
+	std::vector<CachedMesh> cachedMeshes;
+	std::vector<GLuint> freeCacheSlots;
+	std::unordered_map<CachedMeshKey, GLuint, CachedMeshKeyHash> cachedMeshSlots;
+	// Nodes of an unordered_map don't move, so references returned by GetCachedMeshData stay valid across inserts.
+	std::unordered_map<PrimitiveDesc, MeshData, PrimitiveDescHash> cachedMeshData;
+	MeshCacheStats cacheStats{};
+
+	bool optimizeCachedMeshes = true;
+	std::string meshFileDirectory;
+
+	// Mesh file of {primitive} in {format} under meshFileDirectory, or empty without a directory.
+	// Named by an FNV-1a hash of everything that affects the file's contents, which unlike std::hash is the same on every run.
+	// Files of other versions just stay in the directory unused.
+	std::string cachedMeshFilePath(const PrimitiveDesc& primitive, const VertexFormat& format)
+	{
+		if (meshFileDirectory.empty())
+		{
+			return std::string();
+		}
+
+		uint64_t hash = 14695981039346656037ull;
+		auto hashBytes = [&](const void* value, size_t size)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(value);
+			for (size_t i = 0; i < size; ++i)
+			{
+				hash = (hash ^ bytes[i]) * 1099511628211ull;
+			}
+		};
+		const int formats[] = { format.position, format.normal, format.uv, format.color, optimizeCachedMeshes };
+		const int type = primitive.type;
+		hashBytes(&MeshGeometryVersion, sizeof(MeshGeometryVersion));
+		hashBytes(&type, sizeof(type));
+		hashBytes(primitive.size, sizeof(primitive.size));
+		hashBytes(primitive.segments, sizeof(primitive.segments));
+		hashBytes(formats, sizeof(formats));
+
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.mesh", static_cast<unsigned long long>(hash));
+		return (std::filesystem::path(meshFileDirectory) / name).string();
+	}
+
+	// Uploads {primitive}: straight from its mesh file if there is a valid one, else from generated MeshData,
+	// which is then written to a mesh file when a directory is set.
+	Mesh uploadCachedMesh(const PrimitiveDesc& primitive, const VertexFormat& format, bool pooled)
+	{
+		const std::string path = cachedMeshFilePath(primitive, format);
+		if (!path.empty())
+		{
+			MeshFile file;
+			if (file.Open(path.c_str()) && file.LevelCount() > 0)
+			{
+				++cacheStats.fileLoads;
+				return pooled ? CreatePooledMesh(file.Level(0)) : CreateMesh(file.Level(0));
+			}
+		}
+
+		const MeshData& meshData = GetCachedMeshData(primitive);
+		if (!path.empty())
+		{
+			std::error_code error;
+			std::filesystem::create_directories(meshFileDirectory, error);
+			cacheStats.fileWrites += WriteMeshFile(path.c_str(), std::span<const MeshData>(&meshData, 1), format);
+		}
+		return pooled ? CreatePooledMesh(meshData, format) : CreateMesh(meshData, true, format);
+	}
+
+	MeshData GenerateCachedMeshData(const PrimitiveDesc& primitive)
+	{
+		MeshData meshData = primitive::Generate(primitive);
+		if (optimizeCachedMeshes)
+		{
+			OptimizeMesh(meshData);
+		}
+		return meshData;
+	}
+
+	const MeshData& GetCachedMeshData(const PrimitiveDesc& primitive)
+	{
+		auto it = cachedMeshData.find(primitive);
+		if (it == cachedMeshData.end())
+		{
+			++cacheStats.generated;
+			it = cachedMeshData.emplace(primitive, GenerateCachedMeshData(primitive)).first;
+		}
+		return it->second;
+	}
+
+	bool HasCachedMeshData(const PrimitiveDesc& primitive)
+	{
+		return cachedMeshData.contains(primitive);
+	}
+
+	size_t CachedMeshFileSize(const PrimitiveDesc& primitive, const VertexFormat& format)
+	{
+		const std::string path = cachedMeshFilePath(primitive, format);
+		std::error_code error;
+		const auto size = path.empty() ? 0 : std::filesystem::file_size(path, error);
+		return error ? 0 : static_cast<size_t>(size);
+	}
+
+	void AddCachedMeshData(const PrimitiveDesc& primitive, MeshData&& meshData)
+	{
+		if (cachedMeshData.try_emplace(primitive, std::move(meshData)).second)
+		{
+			++cacheStats.generated;
+		}
+	}
+
+	Mesh CreateCachedMesh(const PrimitiveDesc& primitive, const VertexFormat& format, bool pooled)
+	{
+		const CachedMeshKey key = { primitive, format, pooled };
+
+		auto it = cachedMeshSlots.find(key);
+		if (it == cachedMeshSlots.end())
+		{
+			++cacheStats.misses;
+
+			const Mesh mesh = uploadCachedMesh(primitive, format, pooled);
+
+			GLuint slot;
+			if (!freeCacheSlots.empty())
+			{
+				slot = freeCacheSlots.back();
+				freeCacheSlots.pop_back();
+				cachedMeshes[slot - 1] = { key, mesh, 0 };
+			}
+			else
+			{
+				cachedMeshes.push_back({ key, mesh, 0 });
+				slot = static_cast<GLuint>(cachedMeshes.size());
+			}
+			it = cachedMeshSlots.emplace(key, slot).first;
+		}
+		else
+		{
+			++cacheStats.hits;
+		}
+
+		CachedMesh& cached = cachedMeshes[it->second - 1];
+		++cached.references;
+
+		Mesh mesh = cached.mesh;
+		mesh.cacheSlot = it->second;
+		return mesh;
+	}
+
+	void ReleaseCachedMesh(Mesh& mesh)
+	{
+		const GLuint slot = mesh.cacheSlot;
+		mesh = Mesh();
+
+		if (slot == 0 || slot > cachedMeshes.size() || cachedMeshes[slot - 1].references == 0)
+		{
+			return;
+		}
+
+		CachedMesh& cached = cachedMeshes[slot - 1];
+		if (--cached.references > 0)
+		{
+			return;
+		}
+
+		DeleteMesh(cached.mesh);
+		cachedMeshSlots.erase(cached.key);
+		freeCacheSlots.push_back(slot);
+	}
+
+	void DeleteMeshCache()
+	{
+		for (auto& cached : cachedMeshes)
+		{
+			if (cached.references > 0)
+			{
+				DeleteMesh(cached.mesh);
+			}
+		}
+		cachedMeshes.clear();
+		freeCacheSlots.clear();
+		cachedMeshSlots.clear();
+		cachedMeshData.clear();
+		cacheStats = {};
+	}
+
+	MeshCacheStats GetMeshCacheStats()
+	{
+		MeshCacheStats stats = cacheStats;
+		stats.meshes = cachedMeshSlots.size();
+		stats.references = 0;
+		for (const auto& cached : cachedMeshes)
+		{
+			stats.references += cached.references;
+		}
+		stats.meshData = cachedMeshData.size();
+		return stats;
+	}
+}
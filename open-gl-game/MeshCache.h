@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include "Mesh.h"
+#include "Primitives.h"
+
+namespace gfx
+{
+	struct MeshCacheStats
+	{
+		// GPU meshes alive in the cache, and the references held to them.
+		size_t meshes;
+		size_t references;
+		// Generated MeshData kept by the cache.
+		size_t meshData;
+		// CreateCachedMesh calls served by an existing mesh, and those that had to upload one.
+		size_t hits;
+		size_t misses;
+		// Generator runs. Lower than misses when the same primitive is uploaded in several formats.
+		size_t generated;
+		// Misses uploaded from a mesh file, and mesh files written (see meshFileDirectory).
+		size_t fileLoads;
+		size_t fileWrites;
+	};
+
+	// Run OptimizeMesh on primitives generated for the cache. On by default.
+	extern bool optimizeCachedMeshes;
+	// When not empty, CreateCachedMesh uploads meshes straight from mesh files (see MeshFile) in this directory, and bakes the file
+	// of every mesh it has to generate, so only the first run pays for generation. Empty (off) by default.
+	extern std::string meshFileDirectory;
+	// Part of every mesh file name, so files baked from older geometry are never loaded. Bump whenever a primitive generator
+	// (Primitives.cpp) or the optimizer (MeshOptimizer.cpp) changes its output, even for the same PrimitiveDesc.
+	const uint32_t MeshGeometryVersion = 1;
+
+	// Generates {primitive} the way the cache stores it. Thread safe, PrimitiveLoader calls it on worker threads.
+	MeshData GenerateCachedMeshData(const PrimitiveDesc& primitive);
+
+	// Returns the mesh of {primitive} in {format}, pooled (see CreatePooledMesh) or not.
+	// The primitive is generated and uploaded on first use only, later calls with the same arguments share that mesh.
+	// Every returned mesh is a reference: DeleteMesh releases it, and the mesh is freed when its last reference is deleted.
+	Mesh CreateCachedMesh(const PrimitiveDesc& primitive, const VertexFormat& format = VertexFormat_Float, bool pooled = true);
+	// The generated geometry of {primitive}, shared with CreateCachedMesh. Kept until DeleteMeshCache.
+	const MeshData& GetCachedMeshData(const PrimitiveDesc& primitive);
+	bool HasCachedMeshData(const PrimitiveDesc& primitive);
+	// Size of the mesh file of {primitive} in {format}, 0 if there is none (or no meshFileDirectory).
+	size_t CachedMeshFileSize(const PrimitiveDesc& primitive, const VertexFormat& format);
+	// Stores {meshData} generated elsewhere (eg. on a worker thread, see PrimitiveLoader) as the geometry of {primitive}, unless the cache already has some.
+	void AddCachedMeshData(const PrimitiveDesc& primitive, MeshData&& meshData);
+	// Drops the reference held by {mesh}, which must come from CreateCachedMesh. Called by DeleteMesh.
+	void ReleaseCachedMesh(Mesh& mesh);
+	// Frees every cached mesh and MeshData. References still alive become invalid.
+	void DeleteMeshCache();
+	MeshCacheStats GetMeshCacheStats();
+}
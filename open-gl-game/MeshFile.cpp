@@ -0,0 +1,204 @@
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "MeshFile.h"
+
+namespace gfx
+{
+	size_t alignFileOffset(size_t offset)
+	{
+		return (offset + 15) & ~size_t(15);
+	}
+
+	bool WriteMeshFile(const char* path, std::span<const MeshData> levels, const VertexFormat& format)
+	{
+		if (levels.empty())
+		{
+			return false;
+		}
+
+		MeshFileHeader header{};
+		header.magic = MeshFileMagic;
+		header.version = MeshFileVersion;
+		header.attributeMask = levels[0].attributeMask();
+		header.format[0] = static_cast<uint8_t>(format.position);
+		header.format[1] = static_cast<uint8_t>(format.normal);
+		header.format[2] = static_cast<uint8_t>(format.uv);
+		header.format[3] = static_cast<uint8_t>(format.color);
+		header.levelCount = static_cast<uint32_t>(levels.size());
+
+		// Pack every level first, so the table can be written with final offsets.
+		std::vector<std::vector<char>> vertices(levels.size());
+		std::vector<std::vector<char>> indices(levels.size());
+		std::vector<MeshFileLevel> table(levels.size());
+		size_t offset = sizeof(MeshFileHeader) + sizeof(MeshFileLevel) * levels.size();
+		for (size_t i = 0; i < levels.size(); ++i)
+		{
+			if (levels[i].attributeMask() != header.attributeMask)
+			{
+				return false;
+			}
+
+			const PackedMeshData packed = PackMeshData(levels[i], format, vertices[i], indices[i]);
+			MeshFileLevel& level = table[i];
+			level.vertexOffset = alignFileOffset(offset);
+			level.vertexCount = packed.vertexCount;
+			level.indexOffset = alignFileOffset(level.vertexOffset + vertices[i].size());
+			level.indexCount = packed.indexCount;
+			level.indexType = packed.indexType;
+			level.quantizedPositions = packed.quantizedPositions;
+			memcpy(level.positionScale, &packed.positionScale, sizeof(level.positionScale));
+			memcpy(level.positionOffset, &packed.positionOffset, sizeof(level.positionOffset));
+			memcpy(level.boundsMin, &packed.boundsMin, sizeof(level.boundsMin));
+			memcpy(level.boundsMax, &packed.boundsMax, sizeof(level.boundsMax));
+			offset = level.indexOffset + indices[i].size();
+		}
+
+		const std::string temporaryPath = std::string(path) + ".tmp";
+		FILE* file = fopen(temporaryPath.c_str(), "wb");
+		if (!file)
+		{
+			return false;
+		}
+
+		size_t written = 0;
+		bool ok = true;
+		auto write = [&](const void* bytes, size_t count)
+		{
+			ok = ok && fwrite(bytes, 1, count, file) == count;
+			written += count;
+		};
+		auto padTo = [&](size_t target)
+		{
+			const char zeros[16] = {};
+			write(zeros, target - written);
+		};
+
+		write(&header, sizeof(header));
+		write(table.data(), sizeof(MeshFileLevel) * table.size());
+		for (size_t i = 0; i < levels.size(); ++i)
+		{
+			padTo(table[i].vertexOffset);
+			write(vertices[i].data(), vertices[i].size());
+			padTo(table[i].indexOffset);
+			write(indices[i].data(), indices[i].size());
+		}
+
+		ok = fclose(file) == 0 && ok;
+
+		std::error_code error;
+		if (ok)
+		{
+			std::filesystem::rename(temporaryPath, path, error);
+		}
+		if (!ok || error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+			return false;
+		}
+		return true;
+	}
+
+	// Checks that the header is ours and every level's data lies inside the file.
+	bool validMeshFile(const std::byte* data, size_t size)
+	{
+		if (size < sizeof(MeshFileHeader))
+		{
+			return false;
+		}
+
+		MeshFileHeader header;
+		memcpy(&header, data, sizeof(header));
+		if (header.magic != MeshFileMagic || header.version != MeshFileVersion || header.attributeMask == 0 ||
+			header.attributeMask >= (1u << VertexAttribute_Count) || header.levelCount > (size - sizeof(header)) / sizeof(MeshFileLevel) ||
+			header.format[0] > PositionFormat_SNorm16 || header.format[1] > NormalFormat_Int2_10_10_10 ||
+			header.format[2] > UVFormat_Half2 || header.format[3] > ColorFormat_UNorm8)
+		{
+			return false;
+		}
+
+		const VertexFormat format =
+		{
+			static_cast<PositionFormat>(header.format[0]), static_cast<NormalFormat>(header.format[1]),
+			static_cast<UVFormat>(header.format[2]), static_cast<ColorFormat>(header.format[3])
+		};
+		const uint64_t vertexSize = PackedVertexSize(header.attributeMask, format);
+
+		for (uint32_t i = 0; i < header.levelCount; ++i)
+		{
+			MeshFileLevel level;
+			memcpy(&level, data + sizeof(header) + sizeof(MeshFileLevel) * i, sizeof(level));
+			if (level.indexType != GL_UNSIGNED_SHORT && level.indexType != GL_UNSIGNED_INT)
+			{
+				return false;
+			}
+
+			const uint64_t indexSize = level.indexType == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+			if (level.vertexOffset > size || level.vertexCount > (size - level.vertexOffset) / vertexSize ||
+				level.indexOffset > size || level.indexCount > (size - level.indexOffset) / indexSize)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool MeshFile::Open(const char* path)
+	{
+		if (!file.Open(path))
+		{
+			return false;
+		}
+
+		if (!validMeshFile(file.Data(), file.Size()))
+		{
+			file.Close();
+			return false;
+		}
+		return true;
+	}
+
+	void MeshFile::Close()
+	{
+		file.Close();
+	}
+
+	int MeshFile::LevelCount() const
+	{
+		return file.IsOpen() ? static_cast<int>(reinterpret_cast<const MeshFileHeader*>(file.Data())->levelCount) : 0;
+	}
+
+	PackedMeshData MeshFile::Level(int level) const
+	{
+		PackedMeshData packed;
+		if (level < 0 || level >= LevelCount())
+		{
+			return packed;
+		}
+
+		// The mapping is page aligned and the table follows the 8 byte aligned header, so both can be read in place.
+		const std::byte* data = file.Data();
+		const MeshFileHeader& header = *reinterpret_cast<const MeshFileHeader*>(data);
+		const MeshFileLevel& entry = reinterpret_cast<const MeshFileLevel*>(data + sizeof(MeshFileHeader))[level];
+
+		packed.attributeMask = header.attributeMask;
+		packed.format =
+		{
+			static_cast<PositionFormat>(header.format[0]), static_cast<NormalFormat>(header.format[1]),
+			static_cast<UVFormat>(header.format[2]), static_cast<ColorFormat>(header.format[3])
+		};
+		packed.vertexCount = entry.vertexCount;
+		packed.indexCount = entry.indexCount;
+		packed.indexType = entry.indexType;
+		packed.vertices = data + entry.vertexOffset;
+		packed.indices = data + entry.indexOffset;
+		packed.quantizedPositions = entry.quantizedPositions != 0;
+		packed.positionScale = glm::vec3(entry.positionScale[0], entry.positionScale[1], entry.positionScale[2]);
+		packed.positionOffset = glm::vec3(entry.positionOffset[0], entry.positionOffset[1], entry.positionOffset[2]);
+		packed.boundsMin = glm::vec3(entry.boundsMin[0], entry.boundsMin[1], entry.boundsMin[2]);
+		packed.boundsMax = glm::vec3(entry.boundsMax[0], entry.boundsMax[1], entry.boundsMax[2]);
+		return packed;
+	}
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include "MappedFile.h"
+#include "Mesh.h"
+
+namespace gfx
+{
+	// Binary mesh container holding vertices and indices exactly as CreateMesh uploads them (interleaved in the file's VertexFormat,
+	// indices as their index type), one entry per LOD level. Loading maps the file and uploads straight from the mapping.
+	// Layout: MeshFileHeader, MeshFileLevel[levelCount], then the vertex and index data of every level at 16 byte aligned offsets.
+	// Stored in native byte order: a baked cache for this build, not an interchange format.
+	const uint32_t MeshFileMagic = 0x4853454D; // "MESH"
+	// Bump whenever the layout, or the packing of any vertex format, changes. Changes to the generated geometry itself are
+	// covered by MeshGeometryVersion, which names the files.
+	const uint32_t MeshFileVersion = 1;
+
+	struct MeshFileHeader
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		uint32_t	attributeMask;
+		// PositionFormat, NormalFormat, UVFormat and ColorFormat.
+		uint8_t		format[4];
+		uint32_t	levelCount;
+		uint32_t	reserved;
+	};
+
+	struct MeshFileLevel
+	{
+		// Offsets in bytes from the start of the file.
+		uint64_t	vertexOffset;
+		uint64_t	vertexCount;
+		uint64_t	indexOffset;
+		uint64_t	indexCount;
+		uint32_t	indexType;
+		uint32_t	quantizedPositions;
+		float		positionScale[3];
+		float		positionOffset[3];
+		float		boundsMin[3];
+		float		boundsMax[3];
+	};
+
+	static_assert(sizeof(MeshFileHeader) % 8 == 0 && sizeof(MeshFileLevel) % 8 == 0, "mesh file tables are read in place");
+
+	// Writes {levels} (finest first, all with the same attributes) packed as {format} to {path}.
+	// The file is written next to {path} and renamed over it, so readers never see a partial file. Returns false on failure.
+	bool WriteMeshFile(const char* path, std::span<const MeshData> levels, const VertexFormat& format);
+
+	// Read-only mapping of a mesh file. Move-only, unmaps on destruction.
+	class MeshFile
+	{
+	public:
+		// Maps {path}. Returns false, leaving the file closed, if it can't be mapped or isn't a mesh file of this version.
+		bool Open(const char* path);
+		void Close();
+
+		inline bool IsOpen() const { return file.IsOpen(); }
+		inline size_t Size() const { return file.Size(); }
+		int LevelCount() const;
+		// Level {level}, pointing into the mapping. Valid while the file is open; pass it to CreateMesh or CreatePooledMesh.
+		PackedMeshData Level(int level) const;
+
+	private:
+		MappedFile	file;
+	};
+}
@@ -0,0 +1,1159 @@
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+#include "MappedFile.h"
+#include "MeshImporter.h"
+
+namespace gfx
+{
+	// --- Wavefront OBJ ---
+
+	// The text is cut into chunks of about this size at line ends, one parse job each.
+	const size_t ObjChunkSize = 1 << 20;
+	// Index of a face corner without uv or normal.
+	const int32_t ObjMissing = std::numeric_limits<int32_t>::min();
+
+	struct ObjCorner
+	{
+		// Position, uv and normal, 0-based.
+		int32_t	index[3];
+	};
+
+	struct ObjChunk
+	{
+		std::vector<glm::vec3>	positions;
+		std::vector<glm::vec2>	uvs;
+		std::vector<glm::vec3>	normals;
+		// Three per triangle.
+		std::vector<ObjCorner>	corners;
+		// Corner indices written as negative (relative) indices, stored relative to the chunk's first v, vt or vn
+		// until the chunk offsets are known. Entry = corner * 3 + component.
+		std::vector<uint32_t>	relative;
+		bool					hasUVs = false;
+		bool					hasNormals = false;
+		bool					failed = false;
+	};
+
+	inline const char* skipSpaces(const char* p, const char* end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+		{
+			++p;
+		}
+		return p;
+	}
+
+	bool parseFloat(const char*& p, const char* end, float& value)
+	{
+		p = skipSpaces(p, end);
+		// from_chars rejects the leading '+' some exporters write.
+		if (p < end && *p == '+')
+		{
+			++p;
+		}
+
+		const auto result = std::from_chars(p, end, value);
+		if (result.ec == std::errc::invalid_argument)
+		{
+			return false;
+		}
+		// Out of range is almost always a denormal.
+		if (result.ec == std::errc::result_out_of_range)
+		{
+			value = 0.0f;
+		}
+		p = result.ptr;
+		return true;
+	}
+
+	// Parses one OBJ index and makes it 0-based. Returns false for 0 or garbage.
+	bool parseIndex(const char*& p, const char* end, size_t count, int32_t& index, bool& relative)
+	{
+		int32_t value = 0;
+		const auto result = std::from_chars(p, end, value);
+		if (result.ec != std::errc() || value == 0)
+		{
+			return false;
+		}
+		p = result.ptr;
+
+		relative = value < 0;
+		index = relative ? static_cast<int32_t>(count) + value : value - 1;
+		return true;
+	}
+
+	void parseObjChunk(const char* begin, const char* end, ObjChunk& chunk)
+	{
+		struct FaceCorner
+		{
+			ObjCorner	corner;
+			unsigned	relative;
+		};
+
+		auto emit = [&chunk](const FaceCorner& faceCorner)
+		{
+			for (unsigned component = 0; component < 3; ++component)
+			{
+				if (faceCorner.relative & (1u << component))
+				{
+					chunk.relative.push_back(static_cast<uint32_t>(chunk.corners.size() * 3 + component));
+				}
+			}
+			chunk.corners.push_back(faceCorner.corner);
+		};
+
+		const char* p = begin;
+		while (p < end && !chunk.failed)
+		{
+			const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+			if (!lineEnd)
+			{
+				lineEnd = end;
+			}
+
+			p = skipSpaces(p, lineEnd);
+			const char* keyword = p;
+			while (p < lineEnd && *p != ' ' && *p != '\t')
+			{
+				++p;
+			}
+			const std::string_view statement(keyword, p - keyword);
+
+			bool ok = true;
+			if (statement == "v")
+			{
+				// Extra components (w, or the vertex colors some tools append) are ignored.
+				glm::vec3 position;
+				ok = parseFloat(p, lineEnd, position.x) && parseFloat(p, lineEnd, position.y) && parseFloat(p, lineEnd, position.z);
+				chunk.positions.push_back(position);
+			}
+			else if (statement == "vt")
+			{
+				glm::vec2 uv(0.0f);
+				ok = parseFloat(p, lineEnd, uv.x);
+				if (ok && skipSpaces(p, lineEnd) != lineEnd)
+				{
+					ok = parseFloat(p, lineEnd, uv.y);
+				}
+				chunk.uvs.push_back(uv);
+			}
+			else if (statement == "vn")
+			{
+				glm::vec3 normal;
+				ok = parseFloat(p, lineEnd, normal.x) && parseFloat(p, lineEnd, normal.y) && parseFloat(p, lineEnd, normal.z);
+				chunk.normals.push_back(normal);
+			}
+			else if (statement == "f")
+			{
+				// Polygons are triangulated as a fan around the first corner.
+				FaceCorner first{}, previous{};
+				int cornerCount = 0;
+				while (ok && (p = skipSpaces(p, lineEnd)) != lineEnd)
+				{
+					FaceCorner faceCorner = { { { ObjMissing, ObjMissing, ObjMissing } }, 0 };
+					bool relative = false;
+					ok = parseIndex(p, lineEnd, chunk.positions.size(), faceCorner.corner.index[0], relative);
+					faceCorner.relative |= relative ? 1u : 0u;
+					if (ok && p < lineEnd && *p == '/')
+					{
+						++p;
+						if (p < lineEnd && *p != '/')
+						{
+							ok = parseIndex(p, lineEnd, chunk.uvs.size(), faceCorner.corner.index[1], relative);
+							faceCorner.relative |= relative ? 2u : 0u;
+							chunk.hasUVs = true;
+						}
+						if (ok && p < lineEnd && *p == '/')
+						{
+							++p;
+							ok = parseIndex(p, lineEnd, chunk.normals.size(), faceCorner.corner.index[2], relative);
+							faceCorner.relative |= relative ? 4u : 0u;
+							chunk.hasNormals = true;
+						}
+					}
+					if (!ok)
+					{
+						break;
+					}
+
+					if (cornerCount == 0)
+					{
+						first = faceCorner;
+					}
+					else if (cornerCount >= 2)
+					{
+						emit(first);
+						emit(previous);
+						emit(faceCorner);
+					}
+					previous = faceCorner;
+					++cornerCount;
+				}
+				ok = ok && cornerCount >= 3;
+			}
+
+			chunk.failed = !ok;
+			p = lineEnd < end ? lineEnd + 1 : end;
+		}
+	}
+
+	inline uint32_t hashCorner(const ObjCorner& corner, unsigned int bits)
+	{
+		const uint64_t key = static_cast<uint32_t>(corner.index[0]) * 0x9E3779B97F4A7C15ull ^
+							 static_cast<uint32_t>(corner.index[1]) * 0xC2B2AE3D27D4EB4Full ^
+							 static_cast<uint32_t>(corner.index[2]) * 0x165667B19E3779F9ull;
+		// Fibonacci hashing: the high bits of a multiplicative hash are the well mixed ones.
+		return static_cast<uint32_t>((key * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+	}
+
+	MeshData ParseObj(std::string_view text, JobSystem* jobs)
+	{
+		const char* end = text.data() + text.size();
+		std::vector<const char*> bounds = { text.data() };
+		while (bounds.back() != end)
+		{
+			const char* split = bounds.back() + std::min(ObjChunkSize, static_cast<size_t>(end - bounds.back()));
+			if (split != end)
+			{
+				const char* lineEnd = static_cast<const char*>(memchr(split, '\n', end - split));
+				split = lineEnd ? lineEnd + 1 : end;
+			}
+			bounds.push_back(split);
+		}
+
+		const size_t chunkCount = bounds.size() - 1;
+		std::vector<ObjChunk> chunks(chunkCount);
+		ParallelFor(jobs, chunkCount, [&](size_t i) { parseObjChunk(bounds[i], bounds[i + 1], chunks[i]); });
+
+		// Where every chunk's attributes and corners land in the whole file.
+		struct ChunkOffsets
+		{
+			size_t	attribute[3];
+			size_t	corner;
+		};
+		std::vector<ChunkOffsets> offsets(chunkCount);
+		size_t counts[3] = {};
+		size_t cornerCount = 0;
+		bool hasUVs = false;
+		bool hasNormals = false;
+		for (size_t i = 0; i < chunkCount; ++i)
+		{
+			const ObjChunk& chunk = chunks[i];
+			if (chunk.failed)
+			{
+				return {};
+			}
+
+			offsets[i] = { { counts[0], counts[1], counts[2] }, cornerCount };
+			counts[0] += chunk.positions.size();
+			counts[1] += chunk.uvs.size();
+			counts[2] += chunk.normals.size();
+			cornerCount += chunk.corners.size();
+			hasUVs = hasUVs || chunk.hasUVs;
+			hasNormals = hasNormals || chunk.hasNormals;
+		}
+
+		const size_t maxCount = static_cast<size_t>(std::numeric_limits<int32_t>::max());
+		if (cornerCount == 0 || counts[0] > maxCount || counts[1] > maxCount || counts[2] > maxCount || cornerCount > maxCount)
+		{
+			return {};
+		}
+
+		// Resolve relative indices and range check everything.
+		std::atomic<bool> valid{ true };
+		ParallelFor(jobs, chunkCount, [&](size_t i)
+		{
+			ObjChunk& chunk = chunks[i];
+			for (uint32_t entry : chunk.relative)
+			{
+				int32_t& index = chunk.corners[entry / 3].index[entry % 3];
+				index = static_cast<int32_t>(std::max<int64_t>(int64_t(index) + int64_t(offsets[i].attribute[entry % 3]), -1));
+			}
+
+			for (const ObjCorner& corner : chunk.corners)
+			{
+				for (int component = 0; component < 3; ++component)
+				{
+					const int32_t index = corner.index[component];
+					if ((index < 0 || static_cast<size_t>(index) >= counts[component]) && (component == 0 || index != ObjMissing))
+					{
+						valid = false;
+						return;
+					}
+				}
+			}
+		});
+		if (!valid)
+		{
+			return {};
+		}
+
+		// Without uvs and normals every position is a vertex and the position indices are the indices.
+		if (!hasUVs && !hasNormals)
+		{
+			MeshData meshData(VertexAttribute_Position, counts[0], cornerCount);
+			ParallelFor(jobs, chunkCount, [&](size_t i)
+			{
+				const ObjChunk& chunk = chunks[i];
+				std::copy(chunk.positions.begin(), chunk.positions.end(), meshData.vertices().begin() + offsets[i].attribute[0]);
+				GLuint* indices = meshData.indices().data() + offsets[i].corner;
+				for (size_t corner = 0; corner < chunk.corners.size(); ++corner)
+				{
+					indices[corner] = static_cast<GLuint>(chunk.corners[corner].index[0]);
+				}
+			});
+			return meshData;
+		}
+
+		// Every distinct (position, uv, normal) triplet becomes a vertex, numbered in order of first use.
+		// Open addressing table of vertex + 1 (0 is empty), kept at most half full.
+		std::vector<ObjCorner> vertexKeys;
+		vertexKeys.reserve(counts[0]);
+		std::vector<GLuint> indices(cornerCount);
+		unsigned int bits = 10;
+		while ((size_t(1) << bits) < counts[0] * 2)
+		{
+			++bits;
+		}
+		std::vector<uint32_t> table(size_t(1) << bits);
+
+		size_t cornerIndex = 0;
+		for (const ObjChunk& chunk : chunks)
+		{
+			for (const ObjCorner& corner : chunk.corners)
+			{
+				const uint32_t mask = static_cast<uint32_t>(table.size() - 1);
+				uint32_t slot = hashCorner(corner, bits);
+				for (;;)
+				{
+					const uint32_t entry = table[slot];
+					if (entry == 0)
+					{
+						table[slot] = static_cast<uint32_t>(vertexKeys.size() + 1);
+						indices[cornerIndex] = static_cast<GLuint>(vertexKeys.size());
+						vertexKeys.push_back(corner);
+						break;
+					}
+					if (memcmp(&vertexKeys[entry - 1], &corner, sizeof(ObjCorner)) == 0)
+					{
+						indices[cornerIndex] = entry - 1;
+						break;
+					}
+					slot = (slot + 1) & mask;
+				}
+				++cornerIndex;
+
+				if (vertexKeys.size() * 2 > table.size())
+				{
+					++bits;
+					table.assign(size_t(1) << bits, 0);
+					for (size_t vertex = 0; vertex < vertexKeys.size(); ++vertex)
+					{
+						uint32_t rehashed = hashCorner(vertexKeys[vertex], bits);
+						while (table[rehashed] != 0)
+						{
+							rehashed = (rehashed + 1) & static_cast<uint32_t>(table.size() - 1);
+						}
+						table[rehashed] = static_cast<uint32_t>(vertex + 1);
+					}
+				}
+			}
+		}
+		table = {};
+
+		// Gather the attributes, concatenated first so vertices can look them up by file index.
+		std::vector<glm::vec3> positions(counts[0]);
+		std::vector<glm::vec2> uvs(hasUVs ? counts[1] : 0);
+		std::vector<glm::vec3> normals(hasNormals ? counts[2] : 0);
+		ParallelFor(jobs, chunkCount, [&](size_t i)
+		{
+			const ObjChunk& chunk = chunks[i];
+			std::copy(chunk.positions.begin(), chunk.positions.end(), positions.begin() + offsets[i].attribute[0]);
+			if (hasUVs)
+			{
+				std::copy(chunk.uvs.begin(), chunk.uvs.end(), uvs.begin() + offsets[i].attribute[1]);
+			}
+			if (hasNormals)
+			{
+				std::copy(chunk.normals.begin(), chunk.normals.end(), normals.begin() + offsets[i].attribute[2]);
+			}
+		});
+		chunks = {};
+
+		const unsigned int attributeMask = VertexAttribute_Position | (hasUVs ? static_cast<unsigned int>(VertexAttribute_UV) : 0u) |
+			(hasNormals ? static_cast<unsigned int>(VertexAttribute_Normal) : 0u);
+		MeshData meshData(attributeMask, vertexKeys.size(), cornerCount);
+		std::copy(indices.begin(), indices.end(), meshData.indices().begin());
+
+		const size_t vertexBatch = 1 << 16;
+		ParallelFor(jobs, (vertexKeys.size() + vertexBatch - 1) / vertexBatch, [&](size_t batch)
+		{
+			const size_t first = batch * vertexBatch;
+			const size_t last = std::min(first + vertexBatch, vertexKeys.size());
+			const std::span<glm::vec3> vertexPositions = meshData.vertices();
+			const std::span<glm::vec2> vertexUVs = meshData.uvs();
+			const std::span<glm::vec3> vertexNormals = meshData.normals();
+			for (size_t vertex = first; vertex < last; ++vertex)
+			{
+				const ObjCorner& key = vertexKeys[vertex];
+				vertexPositions[vertex] = positions[key.index[0]];
+				if (hasUVs)
+				{
+					vertexUVs[vertex] = key.index[1] != ObjMissing ? uvs[key.index[1]] : glm::vec2(0.0f);
+				}
+				if (hasNormals)
+				{
+					vertexNormals[vertex] = key.index[2] != ObjMissing ? normals[key.index[2]] : glm::vec3(0.0f);
+				}
+			}
+		});
+		return meshData;
+	}
+
+	// --- glTF 2.0 binary ---
+
+	const uint32_t GlbMagic = 0x46546C67; // "glTF"
+	const uint32_t GlbChunkJson = 0x4E4F534A;
+	const uint32_t GlbChunkBin = 0x004E4942;
+	// Guards the recursive JSON parser and node traversal against hostile nesting.
+	const int GlbMaxDepth = 64;
+
+	enum JsonType
+	{
+		JsonType_Null,
+		JsonType_Bool,
+		JsonType_Number,
+		JsonType_String,
+		JsonType_Array,
+		JsonType_Object
+	};
+
+	// Just enough JSON for the glTF chunk. Strings keep their escapes: no glTF key, or value compared here, has any.
+	struct JsonValue
+	{
+		JsonType						type = JsonType_Null;
+		double							number = 0.0;
+		bool							boolean = false;
+		std::string_view				string;
+		// Array elements, or object members named by {keys}.
+		std::vector<JsonValue>			elements;
+		std::vector<std::string_view>	keys;
+
+		const JsonValue* find(std::string_view key) const
+		{
+			if (type != JsonType_Object)
+			{
+				return nullptr;
+			}
+			for (size_t i = 0; i < keys.size(); ++i)
+			{
+				if (keys[i] == key)
+				{
+					return &elements[i];
+				}
+			}
+			return nullptr;
+		}
+
+		const JsonValue* at(size_t index) const
+		{
+			return type == JsonType_Array && index < elements.size() ? &elements[index] : nullptr;
+		}
+	};
+
+	class JsonParser
+	{
+	public:
+		JsonParser(std::string_view text) : p(text.data()), end(text.data() + text.size()) {}
+
+		bool Parse(JsonValue& value)
+		{
+			return parseValue(value, 0) && skipSpaces() == end;
+		}
+
+	private:
+		const char* skipSpaces()
+		{
+			while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+			{
+				++p;
+			}
+			return p;
+		}
+
+		bool parseString(std::string_view& string)
+		{
+			if (skipSpaces() == end || *p != '"')
+			{
+				return false;
+			}
+			const char* begin = ++p;
+			while (p < end && *p != '"')
+			{
+				p += *p == '\\' ? 2 : 1;
+			}
+			if (p >= end)
+			{
+				return false;
+			}
+			string = std::string_view(begin, p++ - begin);
+			return true;
+		}
+
+		bool parseLiteral(std::string_view literal)
+		{
+			if (static_cast<size_t>(end - p) < literal.size() || std::string_view(p, literal.size()) != literal)
+			{
+				return false;
+			}
+			p += literal.size();
+			return true;
+		}
+
+		bool parseValue(JsonValue& value, int depth)
+		{
+			if (depth > GlbMaxDepth || skipSpaces() == end)
+			{
+				return false;
+			}
+
+			switch (*p)
+			{
+			case '{':
+			case '[':
+			{
+				const bool object = *p == '{';
+				const char close = object ? '}' : ']';
+				value.type = object ? JsonType_Object : JsonType_Array;
+				++p;
+				if (skipSpaces() != end && *p == close)
+				{
+					++p;
+					return true;
+				}
+				for (;;)
+				{
+					if (object)
+					{
+						std::string_view key;
+						if (!parseString(key) || skipSpaces() == end || *p++ != ':')
+						{
+							return false;
+						}
+						value.keys.push_back(key);
+					}
+					value.elements.emplace_back();
+					if (!parseValue(value.elements.back(), depth + 1) || skipSpaces() == end)
+					{
+						return false;
+					}
+					if (*p == close)
+					{
+						++p;
+						return true;
+					}
+					if (*p++ != ',')
+					{
+						return false;
+					}
+				}
+			}
+			case '"':
+				value.type = JsonType_String;
+				return parseString(value.string);
+			case 't':
+			case 'f':
+				value.type = JsonType_Bool;
+				value.boolean = *p == 't';
+				return parseLiteral(value.boolean ? "true" : "false");
+			case 'n':
+				return parseLiteral("null");
+			default:
+			{
+				value.type = JsonType_Number;
+				const auto result = std::from_chars(p, end, value.number);
+				p = result.ptr;
+				return result.ec == std::errc();
+			}
+			}
+		}
+
+		const char*	p;
+		const char*	end;
+	};
+
+	// {value} as an array index, or SIZE_MAX if it isn't a non-negative integer.
+	size_t jsonIndex(const JsonValue* value)
+	{
+		if (!value || value->type != JsonType_Number || value->number < 0.0 || value->number > 4294967295.0 ||
+			value->number != std::floor(value->number))
+		{
+			return SIZE_MAX;
+		}
+		return static_cast<size_t>(value->number);
+	}
+
+	size_t jsonIndex(const JsonValue* value, size_t fallback)
+	{
+		return value ? jsonIndex(value) : fallback;
+	}
+
+	// Reads an array of exactly {count} numbers into {out}. Leaves {out} alone and returns false otherwise.
+	bool jsonFloats(const JsonValue* value, float* out, size_t count)
+	{
+		if (!value || value->type != JsonType_Array || value->elements.size() != count)
+		{
+			return false;
+		}
+		for (const JsonValue& element : value->elements)
+		{
+			if (element.type != JsonType_Number)
+			{
+				return false;
+			}
+		}
+		for (size_t i = 0; i < count; ++i)
+		{
+			out[i] = static_cast<float>(value->elements[i].number);
+		}
+		return true;
+	}
+
+	enum GlbComponentType
+	{
+		GlbComponent_Byte			= 5120,
+		GlbComponent_UnsignedByte	= 5121,
+		GlbComponent_Short			= 5122,
+		GlbComponent_UnsignedShort	= 5123,
+		GlbComponent_UnsignedInt	= 5125,
+		GlbComponent_Float			= 5126
+	};
+
+	struct GlbAccessor
+	{
+		// Null for an attribute the primitive doesn't have.
+		const std::byte*	data = nullptr;
+		size_t				count = 0;
+		size_t				stride = 0;
+		int					componentType = 0;
+		int					components = 0;
+		bool				normalized = false;
+	};
+
+	size_t componentSize(int componentType)
+	{
+		switch (componentType)
+		{
+		case GlbComponent_Byte:
+		case GlbComponent_UnsignedByte:		return 1;
+		case GlbComponent_Short:
+		case GlbComponent_UnsignedShort:	return 2;
+		case GlbComponent_UnsignedInt:
+		case GlbComponent_Float:			return 4;
+		default:							return 0;
+		}
+	}
+
+	// Resolves accessor {index} to a range of the BIN chunk, checking it lies inside.
+	bool readAccessor(const JsonValue& gltf, std::span<const std::byte> bin, size_t index, GlbAccessor& accessor)
+	{
+		const JsonValue* accessors = gltf.find("accessors");
+		const JsonValue* json = accessors ? accessors->at(index) : nullptr;
+		if (!json || json->find("sparse"))
+		{
+			return false;
+		}
+
+		const JsonValue* views = gltf.find("bufferViews");
+		const JsonValue* view = views ? views->at(jsonIndex(json->find("bufferView"))) : nullptr;
+		const JsonValue* buffers = gltf.find("buffers");
+		const JsonValue* buffer = buffers && view ? buffers->at(jsonIndex(view->find("buffer"))) : nullptr;
+		// Only the GLB's own BIN chunk: buffer 0 without a uri.
+		if (!view || !buffer || jsonIndex(view->find("buffer")) != 0 || buffer->find("uri"))
+		{
+			return false;
+		}
+
+		const JsonValue* type = json->find("type");
+		const std::string_view typeName = type && type->type == JsonType_String ? type->string : std::string_view();
+		accessor.components = typeName == "SCALAR" ? 1 : typeName == "VEC2" ? 2 : typeName == "VEC3" ? 3 : typeName == "VEC4" ? 4 : 0;
+		accessor.componentType = static_cast<int>(jsonIndex(json->find("componentType"), 0));
+		const JsonValue* normalized = json->find("normalized");
+		accessor.normalized = normalized && normalized->type == JsonType_Bool && normalized->boolean;
+		accessor.count = jsonIndex(json->find("count"));
+
+		const size_t elementSize = componentSize(accessor.componentType) * accessor.components;
+		const size_t viewOffset = jsonIndex(view->find("byteOffset"), 0);
+		const size_t viewLength = jsonIndex(view->find("byteLength"));
+		const size_t offset = jsonIndex(json->find("byteOffset"), 0);
+		accessor.stride = jsonIndex(view->find("byteStride"), elementSize);
+		if (elementSize == 0 || accessor.count == SIZE_MAX || viewOffset == SIZE_MAX || viewLength == SIZE_MAX || offset == SIZE_MAX ||
+			accessor.stride < elementSize || viewOffset > bin.size() || viewLength > bin.size() - viewOffset || offset > viewLength)
+		{
+			return false;
+		}
+
+		// The last element has to end inside the view.
+		const size_t available = viewLength - offset;
+		if (accessor.count != 0 && (elementSize > available || accessor.count - 1 > (available - elementSize) / accessor.stride))
+		{
+			return false;
+		}
+
+		accessor.data = bin.data() + viewOffset + offset;
+		return true;
+	}
+
+	inline float readComponent(const std::byte* data, int componentType, bool normalized)
+	{
+		switch (componentType)
+		{
+		case GlbComponent_Byte:
+		{
+			int8_t value;
+			memcpy(&value, data, sizeof(value));
+			return normalized ? std::max(value / 127.0f, -1.0f) : value;
+		}
+		case GlbComponent_UnsignedByte:
+		{
+			uint8_t value;
+			memcpy(&value, data, sizeof(value));
+			return normalized ? value / 255.0f : value;
+		}
+		case GlbComponent_Short:
+		{
+			int16_t value;
+			memcpy(&value, data, sizeof(value));
+			return normalized ? std::max(value / 32767.0f, -1.0f) : value;
+		}
+		case GlbComponent_UnsignedShort:
+		{
+			uint16_t value;
+			memcpy(&value, data, sizeof(value));
+			return normalized ? value / 65535.0f : value;
+		}
+		case GlbComponent_UnsignedInt:
+		{
+			uint32_t value;
+			memcpy(&value, data, sizeof(value));
+			return static_cast<float>(value);
+		}
+		default:
+		{
+			float value;
+			memcpy(&value, data, sizeof(value));
+			return value;
+		}
+		}
+	}
+
+	// Element {i} of {accessor}. Components the accessor doesn't have come from {fallback}.
+	inline glm::vec4 readElement(const GlbAccessor& accessor, size_t i, glm::vec4 fallback)
+	{
+		const std::byte* element = accessor.data + i * accessor.stride;
+		const int components = std::min(accessor.components, 4);
+		if (accessor.componentType == GlbComponent_Float)
+		{
+			memcpy(&fallback, element, components * sizeof(float));
+			return fallback;
+		}
+
+		const size_t size = componentSize(accessor.componentType);
+		for (int component = 0; component < components; ++component)
+		{
+			fallback[component] = readComponent(element + component * size, accessor.componentType, accessor.normalized);
+		}
+		return fallback;
+	}
+
+	inline uint32_t readIndex(const GlbAccessor& accessor, size_t i)
+	{
+		const std::byte* element = accessor.data + i * accessor.stride;
+		switch (accessor.componentType)
+		{
+		case GlbComponent_UnsignedByte:
+			return static_cast<uint32_t>(element[0]);
+		case GlbComponent_UnsignedShort:
+		{
+			uint16_t index;
+			memcpy(&index, element, sizeof(index));
+			return index;
+		}
+		default:
+		{
+			uint32_t index;
+			memcpy(&index, element, sizeof(index));
+			return index;
+		}
+		}
+	}
+
+	// One mesh primitive placed by one node.
+	struct GlbPrimitive
+	{
+		glm::mat4	transform;
+		GlbAccessor	position;
+		GlbAccessor	normal;
+		GlbAccessor	uv;
+		GlbAccessor	color;
+		GlbAccessor	indices;
+		size_t		indexCount;
+		// Where it lands in the MeshData.
+		size_t		firstVertex;
+		size_t		firstIndex;
+	};
+
+	glm::mat4 nodeTransform(const JsonValue& node)
+	{
+		float matrix[16];
+		if (jsonFloats(node.find("matrix"), matrix, 16))
+		{
+			return glm::mat4(matrix[0], matrix[1], matrix[2], matrix[3],
+							 matrix[4], matrix[5], matrix[6], matrix[7],
+							 matrix[8], matrix[9], matrix[10], matrix[11],
+							 matrix[12], matrix[13], matrix[14], matrix[15]);
+		}
+
+		float t[3] = { 0.0f, 0.0f, 0.0f };
+		float r[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+		float s[3] = { 1.0f, 1.0f, 1.0f };
+		jsonFloats(node.find("translation"), t, 3);
+		jsonFloats(node.find("rotation"), r, 4);
+		jsonFloats(node.find("scale"), s, 3);
+
+		// T * R * S, with R from the unit quaternion (x, y, z, w).
+		const float x = r[0], y = r[1], z = r[2], w = r[3];
+		return glm::mat4((1 - 2 * (y * y + z * z)) * s[0], 2 * (x * y + w * z) * s[0], 2 * (x * z - w * y) * s[0], 0,
+						 2 * (x * y - w * z) * s[1], (1 - 2 * (x * x + z * z)) * s[1], 2 * (y * z + w * x) * s[1], 0,
+						 2 * (x * z + w * y) * s[2], 2 * (y * z - w * x) * s[2], (1 - 2 * (x * x + y * y)) * s[2], 0,
+						 t[0], t[1], t[2], 1);
+	}
+
+	// Collects the triangle primitives under node {index}. Returns false on malformed or cyclic node trees and bad accessors.
+	bool collectPrimitives(const JsonValue& gltf, std::span<const std::byte> bin, size_t index, const glm::mat4& parent,
+						   std::vector<bool>& visiting, std::vector<GlbPrimitive>& primitives, int depth)
+	{
+		const JsonValue* nodes = gltf.find("nodes");
+		const JsonValue* node = nodes ? nodes->at(index) : nullptr;
+		if (!node || visiting[index] || depth > GlbMaxDepth)
+		{
+			return false;
+		}
+		visiting[index] = true;
+
+		const glm::mat4 transform = parent * nodeTransform(*node);
+		if (const JsonValue* meshIndex = node->find("mesh"))
+		{
+			const JsonValue* meshes = gltf.find("meshes");
+			const JsonValue* mesh = meshes ? meshes->at(jsonIndex(meshIndex)) : nullptr;
+			const JsonValue* meshPrimitives = mesh ? mesh->find("primitives") : nullptr;
+			if (!meshPrimitives || meshPrimitives->type != JsonType_Array)
+			{
+				return false;
+			}
+
+			for (const JsonValue& json : meshPrimitives->elements)
+			{
+				// Points, lines, strips and fans are skipped, MeshData holds triangle lists.
+				const JsonValue* attributes = json.find("attributes");
+				if (jsonIndex(json.find("mode"), 4) != 4 || !attributes)
+				{
+					continue;
+				}
+
+				GlbPrimitive primitive{};
+				primitive.transform = transform;
+				const JsonValue* normal = attributes->find("NORMAL");
+				const JsonValue* uv = attributes->find("TEXCOORD_0");
+				const JsonValue* color = attributes->find("COLOR_0");
+				const JsonValue* indices = json.find("indices");
+				if (!readAccessor(gltf, bin, jsonIndex(attributes->find("POSITION")), primitive.position) ||
+					(normal && !readAccessor(gltf, bin, jsonIndex(normal), primitive.normal)) ||
+					(uv && !readAccessor(gltf, bin, jsonIndex(uv), primitive.uv)) ||
+					(color && !readAccessor(gltf, bin, jsonIndex(color), primitive.color)) ||
+					(indices && !readAccessor(gltf, bin, jsonIndex(indices), primitive.indices)))
+				{
+					return false;
+				}
+
+				const size_t vertexCount = primitive.position.count;
+				primitive.indexCount = indices ? primitive.indices.count : vertexCount;
+				if (primitive.position.components != 3 || (normal && (primitive.normal.count != vertexCount || primitive.normal.components != 3)) ||
+					(uv && (primitive.uv.count != vertexCount || primitive.uv.components != 2)) ||
+					(color && (primitive.color.count != vertexCount || primitive.color.components < 3)) ||
+					(indices && (primitive.indices.components != 1 || primitive.indices.normalized ||
+								 (primitive.indices.componentType != GlbComponent_UnsignedByte &&
+								  primitive.indices.componentType != GlbComponent_UnsignedShort &&
+								  primitive.indices.componentType != GlbComponent_UnsignedInt))) ||
+					primitive.indexCount % 3 != 0)
+				{
+					return false;
+				}
+				primitives.push_back(primitive);
+			}
+		}
+
+		if (const JsonValue* children = node->find("children"))
+		{
+			if (children->type != JsonType_Array)
+			{
+				return false;
+			}
+			for (const JsonValue& child : children->elements)
+			{
+				if (!collectPrimitives(gltf, bin, jsonIndex(&child), transform, visiting, primitives, depth + 1))
+				{
+					return false;
+				}
+			}
+		}
+
+		visiting[index] = false;
+		return true;
+	}
+
+	MeshData ParseGlb(std::span<const std::byte> data, JobSystem* jobs)
+	{
+		auto readU32 = [&data](size_t offset)
+		{
+			uint32_t value;
+			memcpy(&value, data.data() + offset, sizeof(value));
+			return value;
+		};
+
+		// 12 byte header, then chunks of (length, type, data). JSON comes first, the optional BIN second.
+		if (data.size() < 20 || readU32(0) != GlbMagic || readU32(4) != 2 || readU32(8) > data.size())
+		{
+			return {};
+		}
+		data = data.first(readU32(8));
+
+		const size_t jsonLength = readU32(12);
+		if (readU32(16) != GlbChunkJson || jsonLength > data.size() - 20)
+		{
+			return {};
+		}
+		const std::string_view jsonText(reinterpret_cast<const char*>(data.data() + 20), jsonLength);
+
+		std::span<const std::byte> bin;
+		const size_t binOffset = 20 + ((jsonLength + 3) & ~size_t(3));
+		if (binOffset + 8 <= data.size() && readU32(binOffset + 4) == GlbChunkBin)
+		{
+			const size_t binLength = readU32(binOffset);
+			if (binLength > data.size() - binOffset - 8)
+			{
+				return {};
+			}
+			bin = data.subspan(binOffset + 8, binLength);
+		}
+
+		JsonValue gltf;
+		if (!JsonParser(jsonText).Parse(gltf))
+		{
+			return {};
+		}
+
+		// Roots: the default scene's nodes, or every node that isn't a child if the file has no scenes.
+		const JsonValue* nodes = gltf.find("nodes");
+		const size_t nodeCount = nodes && nodes->type == JsonType_Array ? nodes->elements.size() : 0;
+		std::vector<size_t> roots;
+		if (const JsonValue* scenes = gltf.find("scenes"))
+		{
+			const JsonValue* scene = scenes->at(jsonIndex(gltf.find("scene"), 0));
+			const JsonValue* sceneNodes = scene ? scene->find("nodes") : nullptr;
+			if (sceneNodes && sceneNodes->type == JsonType_Array)
+			{
+				for (const JsonValue& node : sceneNodes->elements)
+				{
+					roots.push_back(jsonIndex(&node));
+				}
+			}
+		}
+		else
+		{
+			std::vector<bool> isChild(nodeCount);
+			for (size_t node = 0; node < nodeCount; ++node)
+			{
+				const JsonValue* children = nodes->elements[node].find("children");
+				for (size_t child = 0; children && children->at(child); ++child)
+				{
+					if (jsonIndex(children->at(child)) < nodeCount)
+					{
+						isChild[jsonIndex(children->at(child))] = true;
+					}
+				}
+			}
+			for (size_t node = 0; node < nodeCount; ++node)
+			{
+				if (!isChild[node])
+				{
+					roots.push_back(node);
+				}
+			}
+		}
+
+		std::vector<GlbPrimitive> primitives;
+		std::vector<bool> visiting(nodeCount);
+		for (size_t root : roots)
+		{
+			if (!collectPrimitives(gltf, bin, root, glm::mat4(1.0f), visiting, primitives, 0))
+			{
+				return {};
+			}
+		}
+
+		unsigned int attributeMask = VertexAttribute_Position;
+		size_t vertexCount = 0;
+		size_t indexCount = 0;
+		for (GlbPrimitive& primitive : primitives)
+		{
+			attributeMask |= primitive.normal.data ? static_cast<unsigned int>(VertexAttribute_Normal) : 0u;
+			attributeMask |= primitive.uv.data ? static_cast<unsigned int>(VertexAttribute_UV) : 0u;
+			attributeMask |= primitive.color.data ? static_cast<unsigned int>(VertexAttribute_Color) : 0u;
+			primitive.firstVertex = vertexCount;
+			primitive.firstIndex = indexCount;
+			vertexCount += primitive.position.count;
+			indexCount += primitive.indexCount;
+		}
+		if (indexCount == 0 || vertexCount > std::numeric_limits<GLuint>::max())
+		{
+			return {};
+		}
+
+		// Batches of vertices or indices of one primitive, so a single large primitive still spreads over the workers.
+		struct Batch
+		{
+			size_t	primitive;
+			bool	indices;
+			size_t	first;
+			size_t	last;
+		};
+		const size_t batchSize = 1 << 16;
+		std::vector<Batch> batches;
+		for (size_t i = 0; i < primitives.size(); ++i)
+		{
+			for (size_t first = 0; first < primitives[i].position.count; first += batchSize)
+			{
+				batches.push_back({ i, false, first, std::min(first + batchSize, primitives[i].position.count) });
+			}
+			// Multiples of 3, so a batch never splits a triangle.
+			for (size_t first = 0; first < primitives[i].indexCount; first += batchSize * 3)
+			{
+				batches.push_back({ i, true, first, std::min(first + batchSize * 3, primitives[i].indexCount) });
+			}
+		}
+
+		MeshData meshData(attributeMask, vertexCount, indexCount);
+		std::atomic<bool> valid{ true };
+		ParallelFor(jobs, batches.size(), [&](size_t b)
+		{
+			const Batch& batch = batches[b];
+			const GlbPrimitive& primitive = primitives[batch.primitive];
+			const glm::mat3 linear(primitive.transform);
+			// Mirroring transforms flip the winding back, so front faces stay counter-clockwise.
+			const bool mirrored = glm::dot(glm::cross(linear[0], linear[1]), linear[2]) < 0.0f;
+
+			if (batch.indices)
+			{
+				const size_t vertexLimit = primitive.position.count;
+				GLuint* indices = meshData.indices().data() + primitive.firstIndex;
+				for (size_t i = batch.first; i < batch.last; ++i)
+				{
+					size_t corner = i;
+					if (mirrored && i % 3 != 0)
+					{
+						corner = i % 3 == 1 ? i + 1 : i - 1;
+					}
+					const uint32_t index = primitive.indices.data ? readIndex(primitive.indices, corner) : static_cast<uint32_t>(corner);
+					if (index >= vertexLimit)
+					{
+						valid = false;
+						return;
+					}
+					indices[i] = static_cast<GLuint>(primitive.firstVertex + index);
+				}
+				return;
+			}
+
+			const glm::mat3 normalMatrix = glm::transpose(glm::inverse(linear));
+			for (size_t i = batch.first; i < batch.last; ++i)
+			{
+				const size_t vertex = primitive.firstVertex + i;
+				const glm::vec4 position = readElement(primitive.position, i, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f));
+				meshData.vertices()[vertex] = glm::vec3(primitive.transform * position);
+				if (attributeMask & VertexAttribute_Normal)
+				{
+					glm::vec3 normal(0.0f);
+					if (primitive.normal.data)
+					{
+						normal = normalMatrix * glm::vec3(readElement(primitive.normal, i, glm::vec4(0.0f)));
+						const float length = glm::length(normal);
+						normal = length > 0.0f ? normal / length : normal;
+					}
+					meshData.normals()[vertex] = normal;
+				}
+				if (attributeMask & VertexAttribute_UV)
+				{
+					meshData.uvs()[vertex] = primitive.uv.data ? glm::vec2(readElement(primitive.uv, i, glm::vec4(0.0f))) : glm::vec2(0.0f);
+				}
+				if (attributeMask & VertexAttribute_Color)
+				{
+					meshData.colors()[vertex] = primitive.color.data ? readElement(primitive.color, i, glm::vec4(1.0f)) : glm::vec4(1.0f);
+				}
+			}
+		});
+
+		if (!valid)
+		{
+			return {};
+		}
+		return meshData;
+	}
+
+	MeshData ImportObj(const char* path, JobSystem* jobs)
+	{
+		MappedFile file;
+		if (!file.Open(path))
+		{
+			return {};
+		}
+		return ParseObj(std::string_view(reinterpret_cast<const char*>(file.Data()), file.Size()), jobs);
+	}
+
+	MeshData ImportGlb(const char* path, JobSystem* jobs)
+	{
+		MappedFile file;
+		if (!file.Open(path))
+		{
+			return {};
+		}
+		return ParseGlb(std::span<const std::byte>(file.Data(), file.Size()), jobs);
+	}
+
+	MeshData ImportMesh(const char* path, JobSystem* jobs)
+	{
+		const std::string_view name(path);
+		const size_t dot = name.rfind('.');
+		std::string_view extension = dot != std::string_view::npos ? name.substr(dot + 1) : std::string_view();
+		auto is = [extension](std::string_view candidate)
+		{
+			return extension.size() == candidate.size() &&
+				std::equal(extension.begin(), extension.end(), candidate.begin(), [](char a, char b) { return (a | 0x20) == b; });
+		};
+
+		if (is("obj"))
+		{
+			return ImportObj(path, jobs);
+		}
+		if (is("glb"))
+		{
+			return ImportGlb(path, jobs);
+		}
+		return {};
+	}
+}
@@ -0,0 +1,27 @@
+#pragma once
+#include <cstddef>
+#include <span>
+#include <string_view>
+#include "JobSystem.h"
+#include "Mesh.h"
+
+namespace gfx
+{
+	// Importers for Wavefront OBJ and binary glTF 2.0 (.glb) meshes. They flatten the whole file into one indexed MeshData,
+	// run WeldVertices/OptimizeMesh afterwards if needed. Failure (unreadable or malformed file, no triangles) returns an
+	// empty MeshData. With a JobSystem the parsing is spread over its workers, the calling thread helps while waiting.
+
+	// OBJ: v, vt, vn and f statements (any polygon, fan triangulated, negative indices allowed). Everything else is skipped.
+	// Each distinct position/uv/normal triplet becomes one vertex; the mesh has normals or uvs if any face references them,
+	// corners without one get zero.
+	MeshData ParseObj(std::string_view text, JobSystem* jobs = nullptr);
+	// glb: every triangle primitive of the default scene's node tree, transformed to world space, with POSITION, NORMAL,
+	// TEXCOORD_0 and COLOR_0. Embedded buffers only, sparse accessors and non triangle list primitives are not supported.
+	MeshData ParseGlb(std::span<const std::byte> data, JobSystem* jobs = nullptr);
+
+	// Map {path} and parse it.
+	MeshData ImportObj(const char* path, JobSystem* jobs = nullptr);
+	MeshData ImportGlb(const char* path, JobSystem* jobs = nullptr);
+	// Picks the importer from the extension of {path}, .obj or .glb.
+	MeshData ImportMesh(const char* path, JobSystem* jobs = nullptr);
+}
@@ -0,0 +1,300 @@
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+#include <utility>
+#include "MeshOptimizer.h"
+
+namespace gfx
+{
+	VertexCacheStats AnalyzeVertexCache(std::span<const GLuint> indices, size_t vertexCount, unsigned int cacheSize)
+	{
+		VertexCacheStats stats{};
+
+		// A vertex is in the cache while fewer than cacheSize misses happened since it was last loaded.
+		std::vector<size_t> loadedAt(vertexCount, 0);
+		std::vector<bool> referenced(vertexCount, false);
+		size_t referencedCount = 0;
+
+		for (GLuint index : indices)
+		{
+			if (!referenced[index])
+			{
+				referenced[index] = true;
+				++referencedCount;
+			}
+
+			if (loadedAt[index] == 0 || stats.transforms + 1 - loadedAt[index] > cacheSize)
+			{
+				++stats.transforms;
+				loadedAt[index] = stats.transforms;
+			}
+		}
+
+		const size_t triangles = indices.size() / 3;
+		stats.acmr = triangles ? float(stats.transforms) / triangles : 0.0f;
+		stats.atvr = referencedCount ? float(stats.transforms) / referencedCount : 0.0f;
+		return stats;
+	}
+
+	// Calls {function}(values) with the span of every attribute stream present in {meshData}.
+	template <typename Data, typename Function>
+	void forEachAttribute(Data& meshData, Function function)
+	{
+		if (meshData.hasAttribute(VertexAttribute_Position))	function(meshData.vertices());
+		if (meshData.hasAttribute(VertexAttribute_Normal))		function(meshData.normals());
+		if (meshData.hasAttribute(VertexAttribute_UV))			function(meshData.uvs());
+		if (meshData.hasAttribute(VertexAttribute_Color))		function(meshData.colors());
+	}
+
+	template <typename T>
+	void remapStream(std::span<const T> values, std::span<T> out, const std::vector<GLuint>& remap)
+	{
+		for (size_t i = 0; i < values.size(); ++i)
+		{
+			if (remap[i] != GLuint(~0u))
+			{
+				out[remap[i]] = values[i];
+			}
+		}
+	}
+
+	// Vertex of index {i} of the triangle list drawing the same as a triangle strip. Odd triangles of a strip are
+	// wound the other way, so their first two corners swap to keep the facing: (0, 1, 2), (2, 1, 3), (2, 3, 4), (4, 3, 5)...
+	size_t stripVertex(size_t i)
+	{
+		const size_t triangle = i / 3;
+		size_t corner = i % 3;
+		if ((triangle & 1) && corner < 2)
+		{
+			corner ^= 1;
+		}
+		return triangle + corner;
+	}
+
+	// Rebuilds {meshData} so vertex i becomes vertex remap[i], for remap[i] < newCount. Entries of ~0 are dropped.
+	// Indices are remapped too. A mesh without indices draws as a triangle strip (see DrawBoundMesh), so it gets the
+	// indices of the same triangles as a list; it must have at least 3 vertices.
+	void remapVertices(MeshData& meshData, const std::vector<GLuint>& remap, size_t newCount)
+	{
+		const MeshData& source = meshData;
+		const size_t indexCount = source.hasIndices() ? source.indexCount() : 3 * (source.vertexCount() - 2);
+		MeshData remapped(source.attributeMask(), newCount, indexCount);
+
+		const std::span<const GLuint> indices = source.indices();
+		const std::span<GLuint> remappedIndices = remapped.indices();
+		for (size_t i = 0; i < indexCount; ++i)
+		{
+			remappedIndices[i] = remap[source.hasIndices() ? indices[i] : stripVertex(i)];
+		}
+
+		// Absent attributes are empty spans on both sides.
+		remapStream(source.vertices(), remapped.vertices(), remap);
+		remapStream(source.normals(), remapped.normals(), remap);
+		remapStream(source.uvs(), remapped.uvs(), remap);
+		remapStream(source.colors(), remapped.colors(), remap);
+
+		meshData = std::move(remapped);
+	}
+
+	size_t WeldVertices(MeshData& meshData)
+	{
+		const size_t vertexCount = meshData.vertexCount();
+		if (!meshData.hasIndices() && vertexCount < 3)
+		{
+			// A strip without a single triangle; nothing to index.
+			return 0;
+		}
+
+		// Hash and compare the raw bytes of every attribute of a vertex.
+		auto hashVertex = [&](GLuint vertex)
+		{
+			uint64_t hash = 14695981039346656037ull;
+			forEachAttribute(std::as_const(meshData), [&](auto values)
+			{
+				const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&values[vertex]);
+				for (size_t b = 0; b < sizeof(values[vertex]); ++b)
+				{
+					hash = (hash ^ bytes[b]) * 1099511628211ull;
+				}
+			});
+			return static_cast<size_t>(hash);
+		};
+		auto equalVertices = [&](GLuint a, GLuint b)
+		{
+			bool equal = true;
+			forEachAttribute(std::as_const(meshData), [&](auto values)
+			{
+				equal = equal && memcmp(&values[a], &values[b], sizeof(values[a])) == 0;
+			});
+			return equal;
+		};
+
+		std::unordered_map<GLuint, GLuint, decltype(hashVertex), decltype(equalVertices)> unique(vertexCount, hashVertex, equalVertices);
+
+		std::vector<GLuint> remap(vertexCount);
+		GLuint uniqueCount = 0;
+		for (GLuint vertex = 0; vertex < vertexCount; ++vertex)
+		{
+			const auto [it, inserted] = unique.try_emplace(vertex, uniqueCount);
+			remap[vertex] = it->second;
+			uniqueCount += inserted;
+		}
+
+		// A strip gains its triangle list here even if no vertex merged.
+		if (uniqueCount != vertexCount || !meshData.hasIndices())
+		{
+			remapVertices(meshData, remap, uniqueCount);
+		}
+		return vertexCount - uniqueCount;
+	}
+
+	void OptimizeVertexCache(std::span<GLuint> indices, size_t vertexCount, unsigned int cacheSize)
+	{
+		const size_t triangleCount = indices.size() / 3;
+		if (triangleCount == 0)
+		{
+			return;
+		}
+		// Trailing indices of an incomplete triangle are no triangle: leave them where they are.
+		indices = indices.first(triangleCount * 3);
+
+		// Triangles using each vertex, as offsets into one flat list.
+		std::vector<GLuint> liveTriangles(vertexCount, 0);
+		for (GLuint index : indices)
+		{
+			++liveTriangles[index];
+		}
+
+		std::vector<GLuint> adjacencyOffsets(vertexCount + 1, 0);
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			adjacencyOffsets[v + 1] = adjacencyOffsets[v] + liveTriangles[v];
+		}
+
+		std::vector<GLuint> adjacency(indices.size());
+		{
+			std::vector<GLuint> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+			for (size_t i = 0; i < indices.size(); ++i)
+			{
+				adjacency[fill[indices[i]]++] = static_cast<GLuint>(i / 3);
+			}
+		}
+
+		std::vector<size_t> cacheTime(vertexCount, 0);
+		std::vector<bool> emitted(triangleCount, false);
+		std::vector<GLuint> deadEnds;
+		std::vector<GLuint> candidates;
+		std::vector<GLuint> output;
+		output.reserve(indices.size());
+
+		// Time stamps start past the cache size, so no vertex counts as cached before it is used.
+		size_t time = cacheSize + 1;
+		// Next vertex, in input order, to restart from when fanning runs into a dead end.
+		size_t cursor = 1;
+
+		auto inCache = [&](GLuint v) { return time - cacheTime[v] <= cacheSize; };
+
+		long long fanning = 0;
+		while (fanning >= 0)
+		{
+			candidates.clear();
+
+			// Emit every remaining triangle around the fanning vertex.
+			for (GLuint a = adjacencyOffsets[fanning]; a < adjacencyOffsets[fanning + 1]; ++a)
+			{
+				const GLuint triangle = adjacency[a];
+				if (emitted[triangle])
+				{
+					continue;
+				}
+				emitted[triangle] = true;
+
+				for (int corner = 0; corner < 3; ++corner)
+				{
+					const GLuint v = indices[triangle * 3 + corner];
+					output.push_back(v);
+					deadEnds.push_back(v);
+					candidates.push_back(v);
+					--liveTriangles[v];
+					if (!inCache(v))
+					{
+						cacheTime[v] = time++;
+					}
+				}
+			}
+
+			// Next fanning vertex: the candidate still in cache after its remaining triangles are emitted, oldest in cache first.
+			long long next = -1;
+			size_t bestPriority = 0;
+			for (GLuint v : candidates)
+			{
+				if (liveTriangles[v] == 0)
+				{
+					continue;
+				}
+
+				size_t priority = 0;
+				if (time - cacheTime[v] + 2 * liveTriangles[v] <= cacheSize)
+				{
+					priority = time - cacheTime[v];
+				}
+				if (next < 0 || priority > bestPriority)
+				{
+					bestPriority = priority;
+					next = v;
+				}
+			}
+
+			// Dead end: fall back to recently used vertices, then to the input order.
+			while (next < 0 && !deadEnds.empty())
+			{
+				const GLuint v = deadEnds.back();
+				deadEnds.pop_back();
+				if (liveTriangles[v] > 0)
+				{
+					next = v;
+				}
+			}
+			while (next < 0 && cursor < vertexCount)
+			{
+				if (liveTriangles[cursor] > 0)
+				{
+					next = static_cast<long long>(cursor);
+				}
+				++cursor;
+			}
+
+			fanning = next;
+		}
+
+		std::copy(output.begin(), output.end(), indices.begin());
+	}
+
+	void OptimizeVertexFetch(MeshData& meshData)
+	{
+		if (!meshData.hasIndices())
+		{
+			return;
+		}
+
+		const size_t vertexCount = meshData.vertexCount();
+		std::vector<GLuint> remap(vertexCount, GLuint(~0u));
+		GLuint next = 0;
+		for (GLuint index : meshData.indices())
+		{
+			if (remap[index] == GLuint(~0u))
+			{
+				remap[index] = next++;
+			}
+		}
+
+		remapVertices(meshData, remap, next);
+	}
+
+	void OptimizeMesh(MeshData& meshData, unsigned int cacheSize)
+	{
+		WeldVertices(meshData);
+		OptimizeVertexCache(meshData.indices(), meshData.vertexCount(), cacheSize);
+		OptimizeVertexFetch(meshData);
+	}
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <span>
+#include <vector>
+#include "Mesh.h"
+
+namespace gfx
+{
+	// Post-transform vertex cache size assumed by the optimizer and the analysis. Typical of hardware FIFO caches.
+	const unsigned int DefaultVertexCacheSize = 16;
+
+	struct VertexCacheStats
+	{
+		// Vertex shader invocations of a simulated FIFO cache.
+		size_t	transforms;
+		// Average cache miss ratio: transforms per triangle. 0.5 is the ideal for large regular meshes, 3 the worst case.
+		float	acmr;
+		// Average transform to vertex ratio: transforms per referenced vertex. 1 is the ideal.
+		float	atvr;
+	};
+
+	// Simulates drawing {indices} through a FIFO post-transform cache of {cacheSize} entries.
+	VertexCacheStats AnalyzeVertexCache(std::span<const GLuint> indices, size_t vertexCount, unsigned int cacheSize = DefaultVertexCacheSize);
+
+	// Merges vertices whose attributes are all bitwise equal and rewrites the indices. Meshes without indices draw as a
+	// triangle strip; they are turned into the indexed triangle list of the same triangles, with the same winding.
+	// Returns the number of vertices removed.
+	size_t WeldVertices(MeshData& meshData);
+	// Reorders triangles for vertex cache reuse (Tipsify, Sander et al. 2007). Linear in the triangle count.
+	// Indices past the last whole triangle are left untouched.
+	void OptimizeVertexCache(std::span<GLuint> indices, size_t vertexCount, unsigned int cacheSize = DefaultVertexCacheSize);
+	// Reorders vertices in the order the indices first use them, so vertex fetch walks memory forward. Drops unreferenced vertices.
+	void OptimizeVertexFetch(MeshData& meshData);
+
+	// WeldVertices, OptimizeVertexCache, then OptimizeVertexFetch. Run before CreateMesh; the mesh renders the same triangles,
+	// though a strip comes out as an indexed triangle list.
+	void OptimizeMesh(MeshData& meshData, unsigned int cacheSize = DefaultVertexCacheSize);
+}
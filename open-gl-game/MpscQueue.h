@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <utility>
+
+namespace gfx
+{
+	// Unbounded lock-free queue for many producer threads and a single consumer thread (Vyukov's MPSC node queue).
+	// Push is one atomic exchange. Pop may briefly miss an element whose Push is still in progress, it shows up on a later Pop.
+	template <typename T>
+	class MpscQueue
+	{
+	public:
+		MpscQueue() :
+			head(new Node()),
+			tail(head.load())
+		{}
+
+		MpscQueue(const MpscQueue&) = delete;
+		MpscQueue& operator=(const MpscQueue&) = delete;
+
+		~MpscQueue()
+		{
+			while (tail)
+			{
+				Node* next = tail->next.load();
+				delete tail;
+				tail = next;
+			}
+		}
+
+		// Any thread.
+		void Push(T value)
+		{
+			Node* node = new Node();
+			node->value = std::move(value);
+			Node* previous = head.exchange(node, std::memory_order_acq_rel);
+			previous->next.store(node, std::memory_order_release);
+		}
+
+		// Consumer thread only.
+		bool TryPop(T& value)
+		{
+			Node* next = tail->next.load(std::memory_order_acquire);
+			if (!next)
+			{
+				return false;
+			}
+
+			// {next} becomes the new stub node, its value is moved out.
+			value = std::move(next->value);
+			delete tail;
+			tail = next;
+			return true;
+		}
+
+	private:
+		struct Node
+		{
+			std::atomic<Node*>	next{ nullptr };
+			T					value{};
+		};
+
+		// Last pushed node. Producers swap themselves in here.
+		std::atomic<Node*>	head;
+		// Stub node preceding the oldest element.
+		Node*				tail;
+	};
+}
@@ -0,0 +1,99 @@
+#include <thread>
+#include "MeshCache.h"
+#include "PrimitiveLoader.h"
+
+namespace gfx
+{
+	size_t uploadSize(const MeshData& meshData)
+	{
+		const size_t indexSize = meshData.indexType() == GL_UNSIGNED_SHORT ? sizeof(GLushort) : sizeof(GLuint);
+		return meshData.vertexCount() * meshData.vertexSize() + meshData.indexCount() * indexSize;
+	}
+
+	PrimitiveLoadTicket PrimitiveLoader::Request(const PrimitiveDesc& primitive, const VertexFormat& format, bool pooled)
+	{
+		const PrimitiveLoadTicket ticket = static_cast<PrimitiveLoadTicket>(loads.size());
+		loads.push_back({ primitive, format, pooled, false, Mesh() });
+		++pending;
+
+		// Nothing to generate when the cache has the MeshData, or can upload from a mesh file.
+		if (HasCachedMeshData(primitive) || CachedMeshFileSize(primitive, format) != 0)
+		{
+			ready.push_back({ ticket, MeshData() });
+		}
+		else
+		{
+			jobs.Submit([this, ticket, primitive] { generated.Push({ ticket, GenerateCachedMeshData(primitive) }); });
+		}
+		return ticket;
+	}
+
+	size_t PrimitiveLoader::Upload(size_t byteBudget)
+	{
+		Generated item;
+		while (generated.TryPop(item))
+		{
+			ready.push_back(std::move(item));
+		}
+
+		size_t uploaded = 0;
+		size_t bytes = 0;
+		while (!ready.empty() && (uploaded == 0 || bytes < byteBudget))
+		{
+			Generated& next = ready.front();
+			Load& load = loads[next.ticket];
+
+			if (next.meshData.vertexCount() != 0)
+			{
+				AddCachedMeshData(load.primitive, std::move(next.meshData));
+			}
+			load.mesh = CreateCachedMesh(load.primitive, load.format, load.pooled);
+			// Also counted when the mesh was already uploaded, which only makes the budget conservative.
+			bytes += HasCachedMeshData(load.primitive) ? uploadSize(GetCachedMeshData(load.primitive)) : CachedMeshFileSize(load.primitive, load.format);
+
+			load.loaded = true;
+			--pending;
+			++uploaded;
+			ready.pop_front();
+		}
+		return uploaded;
+	}
+
+	void PrimitiveLoader::Finish()
+	{
+		while (pending > 0)
+		{
+			if (Upload(SIZE_MAX) == 0 && !jobs.RunPendingJob())
+			{
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	Mesh PrimitiveLoader::Take(PrimitiveLoadTicket ticket)
+	{
+		Mesh mesh = loads[ticket].mesh;
+		loads[ticket].mesh = Mesh();
+		return mesh;
+	}
+
+	void PrimitiveLoader::Clear()
+	{
+		// Jobs of this loader still running would push into the queue after it's drained.
+		jobs.Wait();
+
+		Generated item;
+		while (generated.TryPop(item)) {}
+		ready.clear();
+
+		for (auto& load : loads)
+		{
+			if (load.mesh.cacheSlot != 0)
+			{
+				DeleteMesh(load.mesh);
+			}
+		}
+		loads.clear();
+		pending = 0;
+	}
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <vector>
+#include "JobSystem.h"
+#include "Mesh.h"
+#include "MpscQueue.h"
+#include "Primitives.h"
+
+namespace gfx
+{
+	// Identifies a PrimitiveLoader request.
+	typedef uint32_t PrimitiveLoadTicket;
+
+	// Generates (and optimizes, see GenerateCachedMeshData) primitives on a JobSystem and uploads them (through the mesh cache, see CreateCachedMesh) on the GL thread.
+	// Workers hand finished MeshData back through a lock-free queue, Upload drains it under a per-frame byte budget.
+	// Everything but the generation itself runs on the GL thread.
+	class PrimitiveLoader
+	{
+	public:
+		explicit PrimitiveLoader(JobSystem& jobs) : jobs(jobs) {}
+
+		// Queues {primitive} for generation, or directly for upload if the cache already holds its MeshData or a mesh file.
+		PrimitiveLoadTicket Request(const PrimitiveDesc& primitive, const VertexFormat& format = VertexFormat_Float, bool pooled = true);
+		// Uploads generated primitives until about {byteBudget} bytes of vertex and index data went out, at least one if any is ready.
+		// Returns the number of meshes uploaded.
+		size_t Upload(size_t byteBudget);
+		// Blocks, helping with generation, until every request is uploaded.
+		void Finish();
+
+		inline bool IsLoaded(PrimitiveLoadTicket ticket) const { return loads[ticket].loaded; }
+		// Number of requests not uploaded yet.
+		inline size_t Pending() const { return pending; }
+		// Hands the loaded mesh's cache reference to the caller, who must DeleteMesh it. Only valid once, after IsLoaded.
+		Mesh Take(PrimitiveLoadTicket ticket);
+		// Waits for outstanding generation and releases every mesh not taken. Invalidates all tickets.
+		void Clear();
+
+	private:
+		struct Load
+		{
+			PrimitiveDesc	primitive;
+			VertexFormat	format;
+			bool			pooled;
+			bool			loaded;
+			Mesh			mesh;
+		};
+
+		// Handed from a worker to the GL thread. meshData is empty when the cache already had it.
+		struct Generated
+		{
+			PrimitiveLoadTicket	ticket;
+			MeshData			meshData;
+		};
+
+		JobSystem&				jobs;
+		std::vector<Load>		loads;
+		MpscQueue<Generated>	generated;
+		// Drained from generated but over the budget of an earlier Upload.
+		std::deque<Generated>	ready;
+		size_t					pending = 0;
+	};
+}
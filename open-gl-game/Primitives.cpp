@@ -1,10 +1,19 @@
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <span>
 #include <vector>
-#include <map>
 #include <algorithm>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include "Primitives.h"
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define GFX_PRIMITIVES_SSE
+#include <immintrin.h>
+#endif
+
 namespace gfx
 {
 	namespace primitive
@@ -12,9 +21,8 @@ namespace gfx
 		MeshData Quad(float width, float height)
 		{
 			const glm::vec2 size(width/2, height/2);
-			MeshData meshData{};
 
-			meshData.vertices =
+			const glm::vec3 vertices[] =
 			{
 				glm::vec3(-size.x,  -size.y,  0),
 				glm::vec3(-size.x,   size.y,  0),
@@ -22,7 +30,7 @@ namespace gfx
 				glm::vec3( size.x,  -size.y,  0)
 			};
 
-			meshData.normals =
+			const glm::vec3 normals[] =
 			{
 				glm::vec3(0, 0, 1),
 				glm::vec3(0, 0, 1),
@@ -30,7 +38,7 @@ namespace gfx
 				glm::vec3(0, 0, 1)
 			};
 
-			meshData.uvs =
+			const glm::vec2 uvs[] =
 			{
 				glm::vec2(0, 0),
 				glm::vec2(0, 1),
@@ -38,20 +46,24 @@ namespace gfx
 				glm::vec2(1, 0)
 			};
 
-			meshData.indices =
+			const GLuint indices[] =
 			{
 				0, 1, 2,
 				3, 0, 2
 			};
 
+			MeshData meshData(VertexAttribute_Position | VertexAttribute_Normal | VertexAttribute_UV, std::size(vertices), std::size(indices));
+			std::copy(std::begin(vertices), std::end(vertices), meshData.vertices().begin());
+			std::copy(std::begin(normals), std::end(normals), meshData.normals().begin());
+			std::copy(std::begin(uvs), std::end(uvs), meshData.uvs().begin());
+			std::copy(std::begin(indices), std::end(indices), meshData.indices().begin());
 			return meshData;
 		}
 
 		MeshData Box(float width, float height, float depth)
 		{
 			const glm::vec3 size(width/2, height/2, depth/2);
-			MeshData meshData{};
-			meshData.vertices =
+			const glm::vec3 vertices[] =
 			{  
 				// Back face
 				glm::vec3(-size.x, -size.y, -size.z),
@@ -90,7 +102,7 @@ namespace gfx
 				glm::vec3( size.x, -size.y, -size.z)
 			};
 
-			meshData.normals =
+			const glm::vec3 normals[] =
 			{
 				// Back face
 				glm::vec3(0, 0, -1),
@@ -129,7 +141,7 @@ namespace gfx
 				glm::vec3(0, -1, 0),
 			};
 
-			meshData.indices =
+			const GLuint indices[] =
 			{
 				// Top face
 				0, 2, 1,
@@ -156,54 +168,127 @@ namespace gfx
 				20, 23, 22,
 			};
 
+			MeshData meshData(VertexAttribute_Position | VertexAttribute_Normal, std::size(vertices), std::size(indices));
+			std::copy(std::begin(vertices), std::end(vertices), meshData.vertices().begin());
+			std::copy(std::begin(normals), std::end(normals), meshData.normals().begin());
+			std::copy(std::begin(indices), std::end(indices), meshData.indices().begin());
 			return meshData;
 		}
 	
-		void subdivide(std::vector<glm::vec3>& vertices, std::vector<GLuint>& indices) 
+		// Icosphere sizes after {subdivisions} levels. Each level splits every triangle in 4 and adds a vertex per edge:
+		// F = 20 * 4^n, E = 30 * 4^n and V = 10 * 4^n + 2.
+		size_t icosphereTriangleCount(int subdivisions)	{ return size_t(20) << (2 * subdivisions); }
+		size_t icosphereEdgeCount(int subdivisions)		{ return size_t(30) << (2 * subdivisions); }
+		size_t icosphereVertexCount(int subdivisions)	{ return (size_t(10) << (2 * subdivisions)) + 2; }
+
+		// Maps an undirected edge to the vertex at its midpoint. Open addressing with linear probing over flat arrays,
+		// so a lookup is a multiply and (usually) one probe, and clearing between levels never frees memory.
+		class EdgeMidpointTable
 		{
-			std::map<std::pair<GLuint, GLuint>, GLuint> midPointIndexCache;
-			auto getMidPointIndex = [&midPointIndexCache, &vertices](GLuint i1, GLuint i2) -> GLuint {
-				auto key = std::minmax(i1, i2);
-				if (midPointIndexCache.find(key) != midPointIndexCache.end()) {
-					return midPointIndexCache[key];
+		public:
+			// Makes room for {edgeCount} edges up front so later Resets don't allocate.
+			void Reserve(size_t edgeCount)
+			{
+				const size_t capacity = capacityFor(edgeCount);
+				keys.reserve(capacity);
+				values.reserve(capacity);
+			}
+
+			// Empties the table and sizes it for {edgeCount} edges, at a load factor of at most 1/2.
+			void Reset(size_t edgeCount)
+			{
+				const size_t capacity = capacityFor(edgeCount);
+				keys.assign(capacity, emptyKey);
+				values.resize(capacity);
+				mask = capacity - 1;
+				shift = 64 - std::countr_zero(capacity);
+			}
+
+			// Index of the midpoint of edge (a, b), appended to the {vertexCount} {vertices} (projected onto the sphere of {radius})
+			// the first time the edge is seen.
+			GLuint Midpoint(GLuint a, GLuint b, glm::vec3* vertices, size_t& vertexCount, float radius)
+			{
+				const uint64_t key = a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+
+				// Fibonacci hashing: the top bits of key * 2^64/phi spread consecutive indices over the table.
+				for (size_t slot = (key * 0x9E3779B97F4A7C15ull) >> shift;; slot = (slot + 1) & mask)
+				{
+					if (keys[slot] == key)
+					{
+						return values[slot];
+					}
+
+					if (keys[slot] == emptyKey)
+					{
+						const GLuint index = static_cast<GLuint>(vertexCount++);
+						vertices[index] = glm::normalize(vertices[a] + vertices[b]) * radius;
+						keys[slot] = key;
+						values[slot] = index;
+						return index;
+					}
 				}
-				glm::vec3 midPoint = glm::normalize(vertices[i1] + vertices[i2]) * 0.5f;
-				vertices.push_back(midPoint);
-				int newIndex = vertices.size() - 1;
-				midPointIndexCache[key] = newIndex;
-				return newIndex;
-			};
+			}
+
+		private:
+			static constexpr uint64_t emptyKey = ~uint64_t(0);
+
+			static size_t capacityFor(size_t edgeCount)
+			{
+				size_t capacity = 16;
+				while (capacity < edgeCount * 2)
+				{
+					capacity *= 2;
+				}
+				return capacity;
+			}
 
-			std::vector<GLuint> newIndices;
-			for (int i = 0; i < indices.size(); i += 3) {
-				GLuint v1 = indices[i];
-				GLuint v2 = indices[i + 1];
-				GLuint v3 = indices[i + 2];
+			std::vector<uint64_t>	keys;
+			std::vector<GLuint>		values;
+			size_t					mask = 0;
+			int						shift = 64;
+		};
 
-				GLuint a = getMidPointIndex(v1, v2);
-				GLuint b = getMidPointIndex(v2, v3);
-				GLuint c = getMidPointIndex(v3, v1);
+		// Splits the {indexCount} indices of {indices} into 4 triangles each, written to {out}. Midpoint vertices are appended to {vertices}.
+		void subdivide(glm::vec3* vertices, size_t& vertexCount, const GLuint* indices, size_t indexCount, GLuint* out, EdgeMidpointTable& midpoints, float radius)
+		{
+			// A closed mesh has 3/2 edges per triangle.
+			midpoints.Reset(indexCount / 2);
 
-				newIndices.insert(newIndices.end(), { v1, a, c });
-				newIndices.insert(newIndices.end(), { v2, b, a });
-				newIndices.insert(newIndices.end(), { v3, c, b });
-				newIndices.insert(newIndices.end(), { a, b, c });
+			for (size_t i = 0; i < indexCount; i += 3, out += 12)
+			{
+				const GLuint v1 = indices[i];
+				const GLuint v2 = indices[i + 1];
+				const GLuint v3 = indices[i + 2];
+
+				const GLuint a = midpoints.Midpoint(v1, v2, vertices, vertexCount, radius);
+				const GLuint b = midpoints.Midpoint(v2, v3, vertices, vertexCount, radius);
+				const GLuint c = midpoints.Midpoint(v3, v1, vertices, vertexCount, radius);
+
+				out[0] = v1;	out[1] = a;		out[2] = c;
+				out[3] = v2;	out[4] = b;		out[5] = a;
+				out[6] = v3;	out[7] = c;		out[8] = b;
+				out[9] = a;		out[10] = b;	out[11] = c;
 			}
-			indices = newIndices;
 		}
 
 		MeshData Sphere(int subdivisions, float radius)
 		{
+			subdivisions = glm::max(subdivisions, 0);
+
 			const float phi = (1.0 + std::sqrt(5.0)) / 2.0; // Golden ratio
 
-			std::vector<glm::vec3> vertices = 
+			// Sized for the final level up front, vertices and indices are written in place.
+			MeshData meshData(VertexAttribute_Position | VertexAttribute_Normal, icosphereVertexCount(subdivisions), icosphereTriangleCount(subdivisions) * 3);
+			glm::vec3* vertices = meshData.vertices().data();
+
+			const glm::vec3 icosahedronVertices[] =
 			{
 				{-1,  phi,  0}, { 1,  phi,  0}, {-1, -phi,  0}, { 1, -phi,  0},
 				{ 0, -1,  phi}, { 0,  1,  phi}, { 0, -1, -phi}, { 0,  1, -phi},
 				{ phi,  0, -1}, { phi,  0,  1}, {-phi,  0, -1}, {-phi,  0,  1}
 			};
 
-			std::vector<GLuint> indices = 
+			const GLuint icosahedronIndices[] =
 			{
 				0, 11, 5,  0, 5, 1,  0, 1, 7,  0, 7, 10,  0, 10, 11,
 				1, 5, 9,  5, 11, 4, 11, 10, 2, 10, 7, 6,  7, 1, 8,
@@ -211,58 +296,167 @@ namespace gfx
 				4, 9, 5,  2, 4, 11, 6, 2, 10, 8, 6, 7,  9, 8, 1
 			};
 
-			for (auto& vertex : vertices)
+			size_t vertexCount = std::size(icosahedronVertices);
+			for (size_t i = 0; i < vertexCount; ++i)
+			{
+				vertices[i] = glm::normalize(icosahedronVertices[i]) * radius;
+			}
+
+			// Levels ping-pong between the mesh's index stream and a scratch buffer sized for the second to last level,
+			// starting on whichever side makes the last level land in the mesh.
+			std::vector<GLuint> scratch(subdivisions > 0 ? icosphereTriangleCount(subdivisions - 1) * 3 : 0);
+			GLuint* buffers[2] = { meshData.indices().data(), scratch.data() };
+			int current = subdivisions % 2;
+			size_t indexCount = std::size(icosahedronIndices);
+			std::copy(std::begin(icosahedronIndices), std::end(icosahedronIndices), buffers[current]);
+
+			EdgeMidpointTable midpoints;
+			if (subdivisions > 0)
 			{
-				vertex = glm::normalize(vertex) * radius;
+				midpoints.Reserve(icosphereEdgeCount(subdivisions - 1));
 			}
 
 			for (int i = 0; i < subdivisions; ++i)
 			{
-				subdivide(vertices, indices);
+				subdivide(vertices, vertexCount, buffers[current], indexCount, buffers[1 - current], midpoints, radius);
+				current = 1 - current;
+				indexCount *= 4;
 			}
 
-			std::vector<glm::vec3> normals(vertices.size());
-			
-			for (int i = 0; i < vertices.size(); ++i) 
+			// Midpoints are already on the sphere, so the normals are just the directions.
+			glm::vec3* normals = meshData.normals().data();
+			for (size_t i = 0; i < vertexCount; ++i)
 			{
-				vertices[i] = glm::normalize(vertices[i]) * radius;
-				normals[i] = vertices[i];
+				normals[i] = glm::normalize(vertices[i]);
 			}
 
-			MeshData meshData;
-			meshData.vertices = vertices;
-			meshData.normals = normals;
-			meshData.indices = indices;
 			return meshData;
 		}
 
-		MeshData Cylinder(float radius, float height, int segments)
+		// Angles between exact re-seeds of the sinCosRing recurrence. Rounding error grows linearly with the number of rotations in between.
+		const int ringReseedInterval = 64;
+
+		// cos and sin of the {count} angles start + i * step.
+		// Four lanes at a time, each step rotates the lanes by 4 * step (angle addition), which costs 4 multiplies and 2 adds
+		// instead of two trig calls. The lanes are re-seeded with exact values every ringReseedInterval angles.
+		void sinCosRing(double start, double step, int count, float* cosines, float* sines)
 		{
-			segments = glm::max(segments, 3);
+			// The SIMD remainder below assumes count >= 0 (count & ~3 of a negative count is negative too).
+			if (count <= 0)
+			{
+				return;
+			}
 
-			const float halfHeight = height / 2;
+			int i = 0;
+#if defined(GFX_PRIMITIVES_SSE)
+			const __m128 rotateCos = _mm_set1_ps(static_cast<float>(std::cos(step * 4)));
+			const __m128 rotateSin = _mm_set1_ps(static_cast<float>(std::sin(step * 4)));
+
+			for (; i + 4 <= count; i += ringReseedInterval)
+			{
+				alignas(16) float seedCos[4];
+				alignas(16) float seedSin[4];
+				for (int lane = 0; lane < 4; ++lane)
+				{
+					const double angle = start + (i + lane) * step;
+					seedCos[lane] = static_cast<float>(std::cos(angle));
+					seedSin[lane] = static_cast<float>(std::sin(angle));
+				}
+
+				__m128 c = _mm_load_ps(seedCos);
+				__m128 s = _mm_load_ps(seedSin);
+				const int end = std::min(i + ringReseedInterval, count);
+				for (int j = i; j + 4 <= end; j += 4)
+				{
+					_mm_storeu_ps(cosines + j, c);
+					_mm_storeu_ps(sines + j, s);
+
+					const __m128 nextCos = _mm_sub_ps(_mm_mul_ps(c, rotateCos), _mm_mul_ps(s, rotateSin));
+					s = _mm_add_ps(_mm_mul_ps(s, rotateCos), _mm_mul_ps(c, rotateSin));
+					c = nextCos;
+				}
+			}
+			// The loop above covers whole groups of 4, the remainder is computed exactly below.
+			i = count & ~3;
+#endif
+			for (; i < count; ++i)
+			{
+				const double angle = start + i * step;
+				cosines[i] = static_cast<float>(std::cos(angle));
+				sines[i] = static_cast<float>(std::sin(angle));
+			}
+		}
 
-			std::vector<glm::vec3> vertices(segments * 4);
-			std::vector<glm::vec3> normals(segments * 4);
-			std::vector<GLuint> indices(segments * 6 + (segments - 2) * 6);
+		// Writes a ring of {count} vertices around the Y axis: positions (radius * cos, y, radius * sin)
+		// and normals (normalRadius * cos, normalY, normalRadius * sin), reading cos and sin from {cosines} and {sines}.
+		void writeRing(const float* cosines, const float* sines, int count, float radius, float y, float normalRadius, float normalY,
+					   glm::vec3* positions, glm::vec3* normals)
+		{
+			if (count <= 0)
+			{
+				return;
+			}
 
-			for (int i = 0; i < segments; ++i)
+			int i = 0;
+#if defined(GFX_PRIMITIVES_SSE)
+			// Computed as SoA 4 vertices at a time, then transposed into 3 registers of interleaved xyz.
+			auto storeVec3x4 = [](__m128 x, __m128 y, __m128 z, glm::vec3* out)
 			{
-				float t = i / (float)segments;
-				t *= glm::pi<float>() * 2;
-				float x = glm::cos(t) * radius;
-				float z = glm::sin(t) * radius;
+				const __m128 xy01 = _mm_unpacklo_ps(x, y);	// x0 y0 x1 y1
+				const __m128 xy23 = _mm_unpackhi_ps(x, y);	// x2 y2 x3 y3
+				const __m128 zx01 = _mm_unpacklo_ps(z, x);	// z0 x0 z1 x1
+				const __m128 zx23 = _mm_unpackhi_ps(z, x);	// z2 x2 z3 x3
+				const __m128 yz01 = _mm_unpacklo_ps(y, z);	// y0 z0 y1 z1
+				const __m128 yz23 = _mm_unpackhi_ps(y, z);	// y2 z2 y3 z3
+
+				float* floats = reinterpret_cast<float*>(out);
+				_mm_storeu_ps(floats + 0, _mm_shuffle_ps(xy01, zx01, _MM_SHUFFLE(3, 0, 1, 0)));	// x0 y0 z0 x1
+				_mm_storeu_ps(floats + 4, _mm_shuffle_ps(yz01, xy23, _MM_SHUFFLE(1, 0, 3, 2)));	// y1 z1 x2 y2
+				_mm_storeu_ps(floats + 8, _mm_shuffle_ps(zx23, yz23, _MM_SHUFFLE(3, 2, 3, 0)));	// z2 x3 y3 z3
+			};
+
+			static_assert(sizeof(glm::vec3) == 3 * sizeof(float), "writeRing stores vec3 as packed floats");
 
-				vertices[(segments * 0) + i]  = glm::vec3(x, halfHeight, z);
-				vertices[(segments * 1) + i] = glm::vec3(x, -halfHeight, z);
-				vertices[(segments * 2) + i] = glm::vec3(x, halfHeight, z);
-				vertices[(segments * 3) + i] = glm::vec3(x, -halfHeight, z);
+			const __m128 positionRadius = _mm_set1_ps(radius);
+			const __m128 positionY = _mm_set1_ps(y);
+			const __m128 normalScale = _mm_set1_ps(normalRadius);
+			const __m128 normalHeight = _mm_set1_ps(normalY);
 
-				normals[(segments * 0) + i] = glm::normalize(glm::vec3(x, 0, z));
-				normals[(segments * 1) + i] = glm::normalize(glm::vec3(x, 0, z));
-				normals[(segments * 2) + i] = glm::normalize(glm::vec3(0, 1, 0));
-				normals[(segments * 3) + i] = glm::normalize(glm::vec3(0, 1, 0));
+			for (; i + 4 <= count; i += 4)
+			{
+				const __m128 c = _mm_loadu_ps(cosines + i);
+				const __m128 s = _mm_loadu_ps(sines + i);
+				storeVec3x4(_mm_mul_ps(c, positionRadius), positionY, _mm_mul_ps(s, positionRadius), positions + i);
+				storeVec3x4(_mm_mul_ps(c, normalScale), normalHeight, _mm_mul_ps(s, normalScale), normals + i);
+			}
+#endif
+			for (; i < count; ++i)
+			{
+				positions[i] = glm::vec3(radius * cosines[i], y, radius * sines[i]);
+				normals[i] = glm::vec3(normalRadius * cosines[i], normalY, normalRadius * sines[i]);
 			}
+		}
+
+		MeshData Cylinder(float radius, float height, int segments)
+		{
+			segments = glm::max(segments, 3);
+
+			const float halfHeight = height / 2;
+
+			MeshData meshData(VertexAttribute_Position | VertexAttribute_Normal, segments * 4, segments * 6 + (segments - 2) * 6);
+			const std::span<glm::vec3> vertices = meshData.vertices();
+			const std::span<glm::vec3> normals = meshData.normals();
+			const std::span<GLuint> indices = meshData.indices();
+
+			std::vector<float> cosines(segments);
+			std::vector<float> sines(segments);
+			sinCosRing(0.0, glm::pi<double>() * 2 / segments, segments, cosines.data(), sines.data());
+
+			// Side rings, then the cap rings (separate vertices, as their normals point along the axis).
+			writeRing(cosines.data(), sines.data(), segments, radius,  halfHeight, 1.0f,  0.0f, &vertices[segments * 0], &normals[segments * 0]);
+			writeRing(cosines.data(), sines.data(), segments, radius, -halfHeight, 1.0f,  0.0f, &vertices[segments * 1], &normals[segments * 1]);
+			writeRing(cosines.data(), sines.data(), segments, radius,  halfHeight, 0.0f,  1.0f, &vertices[segments * 2], &normals[segments * 2]);
+			writeRing(cosines.data(), sines.data(), segments, radius, -halfHeight, 0.0f, -1.0f, &vertices[segments * 3], &normals[segments * 3]);
 
 			// Edge faces
 			for (int i = 0; i < segments - 1; ++i)
@@ -296,15 +490,15 @@ namespace gfx
 				indices[idx++] = segments * 3 + i + 1;
 			}
 
-			MeshData meshData;
-			meshData.vertices = vertices;
-			meshData.normals = normals;
-			meshData.indices = indices;
 			return meshData;
 		}
 
 		MeshData Capsule(float radius, float height, int latitudeSegments, int longitudeSegments, int rings)
 		{
+			// The vertex layout below needs at least the two equator rings, with the caps attached straight to them.
+			latitudeSegments = glm::max(latitudeSegments, 2);
+			longitudeSegments = glm::max(longitudeSegments, 3);
+			rings = glm::max(rings, 0);
 			latitudeSegments = latitudeSegments % 2 != 0 ? latitudeSegments + 1 : latitudeSegments;
 
 			const int halfLats = latitudeSegments / 2;
@@ -321,160 +515,83 @@ namespace gfx
 			int vOffsetSouthCap = vOffsetSouthPolar + (longitudeSegments + 1);
 
 			int vCount = vOffsetSouthCap + longitudeSegments;
-			std::vector<glm::vec3> vertices(vCount);
-			std::vector<glm::vec3> normals (vCount);
 
-			const float toTheta = 2.f * glm::pi<float>() / longitudeSegments;
-			const float toPhi = glm::pi<float>() / latitudeSegments;
-			const float toTexHorizontal = 1.f / longitudeSegments;
-			const float toTexVertical = 1.f / halfLats;
+			// Triangle index offsets
+			const int long3 = longitudeSegments * 3;
+			const int long6 = longitudeSegments * 6;
+			const int hemiLong = (halfLats - 1) * long6;
 
-			const float vtAspectRatio = 1.f / 3.f;
-			const float vtAspectNorth = 1.f - vtAspectRatio;
-			const float vtAspectSouth = vtAspectRatio;
+			const int tOffsetNorthHemi = long3;
+			const int tOffsetCylinder = tOffsetNorthHemi + hemiLong;
+			const int tOffsetSouthHemi = tOffsetCylinder + (rings + 1) * long6;
+			const int tOffsetSouthCap = tOffsetSouthHemi + hemiLong;
 
-			std::vector<glm::vec2> thetaCartesian(longitudeSegments);
-			std::vector<glm::vec2> rhoThetaCartesian(longitudeSegments);
-			std::vector<float> sTexCache(longitudeSegments + 1);
+			int triCount = tOffsetSouthCap + long3;
 
-			// Polar vertices
-			for (int lon = 0; lon < longitudeSegments; ++lon)
+			MeshData meshData(VertexAttribute_Position | VertexAttribute_Normal, vCount, triCount);
+			const std::span<glm::vec3> vertices = meshData.vertices();
+			const std::span<glm::vec3> normals = meshData.normals();
+			const std::span<GLuint> indices = meshData.indices();
+
+			// Every ring has longitudeSegments + 1 vertices, the last one duplicating the first at the seam.
+			const int ringSize = longitudeSegments + 1;
+
+			// Unit ring, z = -sin.
+			std::vector<float> cosTheta(ringSize);
+			std::vector<float> sinTheta(ringSize);
+			sinCosRing(0.0, 2.0 * glm::pi<double>() / longitudeSegments, longitudeSegments, cosTheta.data(), sinTheta.data());
+			cosTheta[longitudeSegments] = cosTheta[0];
+			sinTheta[longitudeSegments] = sinTheta[0];
+			for (auto& sin : sinTheta)
 			{
-				float lf = lon;
-				float sTexPolar = 1.f - ((lf + .5f) * toTexHorizontal);
-				float cosTheta = glm::cos(lf * toTheta);
-				float sinTheta = glm::sin(lf * toTheta);
-
-				thetaCartesian[lon] = glm::vec2(cosTheta, sinTheta);
-				rhoThetaCartesian[lon] = radius * glm::vec2(cosTheta, sinTheta);
-
-				// North
-				vertices[lon] = glm::vec3(0.f, height / 2.f + radius, 0.f);
-				normals[lon]  = glm::vec3(0.f, 1.f, 0.f);
-
-				// South
-				int i = vOffsetSouthCap + lon;
-				vertices[i] = glm::vec3(0.f, -(height / 2.f + radius), 0.f);
-				normals[i]  = glm::vec3(0.f, -1.f, 0.f);
+				sin = -sin;
 			}
 
-			// Equatorial vertices
-			for (int lon = 0; lon <= longitudeSegments; ++lon)
-			{
-				float sTex = 1.f - lon * toTexHorizontal;
-				sTexCache[lon] = sTex;
-
-				int ll = lon % longitudeSegments;
-				glm::vec2 tc = thetaCartesian[ll];
-				glm::vec2 rtc = rhoThetaCartesian[ll];
+			// Latitude angles of the hemisphere rings.
+			std::vector<float> cosPhi(glm::max(halfLats - 1, 0));
+			std::vector<float> sinPhi(glm::max(halfLats - 1, 0));
+			const double toPhi = glm::pi<double>() / latitudeSegments;
+			sinCosRing(toPhi, toPhi, halfLats - 1, cosPhi.data(), sinPhi.data());
 
-				// North equator
-				int idxn = vOffsetNorthEquator + lon;
-				vertices[idxn] = glm::vec3(rtc.x, height / 2.f, -rtc.y);
-				normals[idxn]  = glm::vec3(tc.x, 0.f, -tc.y);
+			// Polar vertices
+			std::fill_n(vertices.begin(), longitudeSegments, glm::vec3(0.f, height / 2.f + radius, 0.f));
+			std::fill_n(normals.begin(), longitudeSegments, glm::vec3(0.f, 1.f, 0.f));
+			std::fill_n(vertices.begin() + vOffsetSouthCap, longitudeSegments, glm::vec3(0.f, -(height / 2.f + radius), 0.f));
+			std::fill_n(normals.begin() + vOffsetSouthCap, longitudeSegments, glm::vec3(0.f, -1.f, 0.f));
 
-				// South equator
-				int idxs = vOffsetSouthEquator + lon;
-				vertices[idxs] = glm::vec3(rtc.x, -height / 2.f, -rtc.y);
-				normals[idxs]  = glm::vec3(tc.x, 0.f, -tc.y);
-			}
+			// Equatorial vertices
+			writeRing(cosTheta.data(), sinTheta.data(), ringSize, radius, height / 2.f, 1.f, 0.f, &vertices[vOffsetNorthEquator], &normals[vOffsetNorthEquator]);
+			writeRing(cosTheta.data(), sinTheta.data(), ringSize, radius, -height / 2.f, 1.f, 0.f, &vertices[vOffsetSouthEquator], &normals[vOffsetSouthEquator]);
 
 			// Hemisphere vertices
 			for (int lat = 0; lat < halfLats - 1; ++lat)
 			{
-				const float phi = (lat + 1.f) * toPhi;
-				const float cosPhiSouth = glm::cos(phi);
-				const float sinPhiSouth = glm::sin(phi);
+				const float cosPhiSouth = cosPhi[lat];
+				const float sinPhiSouth = sinPhi[lat];
 				const float cosPhiNorth = sinPhiSouth;
 				const float sinPhiNorth = -cosPhiSouth;
 
-				const float rhoCosPhiNorth = radius * cosPhiNorth;
-				const float rhoSinPhiNorth = radius * sinPhiNorth;
-				const float zOffsetNorth = height / 2.f - rhoSinPhiNorth;
-				const float rhoCosPhiSouth = radius * cosPhiSouth;
-				const float rhoSinPhiSouth = radius * sinPhiSouth;
-				const float zOffsetSouth = -height / 2.f - rhoSinPhiSouth;
-
-				const float tTexFac = (lat + 1.f) * toTexVertical;
-				const float cmplTexFac = 1.f - tTexFac;
-				const float tTexNorth = cmplTexFac + vtAspectNorth * tTexFac;
-				const float tTexSouth = cmplTexFac * vtAspectSouth;
+				const float zOffsetNorth = height / 2.f - radius * sinPhiNorth;
+				const float zOffsetSouth = -height / 2.f - radius * sinPhiSouth;
 
-				const int vCurrentLatNorth = vOffsetNorthHemi + (lat * (longitudeSegments + 1));
-				const int vCurrentLatSouth = vOffsetSouthHemi + (lat * (longitudeSegments + 1));
+				const int vCurrentLatNorth = vOffsetNorthHemi + (lat * ringSize);
+				const int vCurrentLatSouth = vOffsetSouthHemi + (lat * ringSize);
 
-				for (int lon = 0; lon <= longitudeSegments; ++lon)
-				{
-					float sTex = sTexCache[lon];
-					glm::vec2 tc = thetaCartesian[lon % longitudeSegments];
-
-					// North hemisphere
-					int idxn = vCurrentLatNorth + lon;
-					vertices[idxn] = glm::vec3(
-						rhoCosPhiNorth * tc.x,
-						zOffsetNorth,
-						-rhoCosPhiNorth * tc.y
-					);
-					normals[idxn] = glm::vec3(
-						cosPhiNorth * tc.x,
-						-sinPhiNorth,
-						-cosPhiNorth * tc.y
-					);
-
-					// South hemisphere
-					int idxs = vCurrentLatSouth + lon;
-					vertices[idxs] = glm::vec3(
-						rhoCosPhiSouth * tc.x,
-						zOffsetSouth,
-						-rhoCosPhiSouth * tc.y
-					);
-					normals[idxs] = glm::vec3(
-						cosPhiSouth * tc.x,
-						-sinPhiSouth,
-						-cosPhiSouth * tc.y
-					);
-				}
+				writeRing(cosTheta.data(), sinTheta.data(), ringSize, radius * cosPhiNorth, zOffsetNorth, cosPhiNorth, -sinPhiNorth,
+						  &vertices[vCurrentLatNorth], &normals[vCurrentLatNorth]);
+				writeRing(cosTheta.data(), sinTheta.data(), ringSize, radius * cosPhiSouth, zOffsetSouth, cosPhiSouth, -sinPhiSouth,
+						  &vertices[vCurrentLatSouth], &normals[vCurrentLatSouth]);
 			}
 
 			// Cylinder vertices
-			if (rings > 0)
+			for (int h = 1; h <= rings; ++h)
 			{
-				float toFac = 1.f / (rings + 1);
-				int index = vOffsetCylinder;
-
-				for (int h = 1; h <= rings; ++h)
-				{
-					float fac = h * toFac;
-					float cmplFac = 1.f - fac;
-					float tTex = cmplFac * vtAspectNorth + fac * vtAspectSouth;
-					float z = (height / 2.f) - height * fac;
-
-					for (int lon = 0; lon <= longitudeSegments; ++lon)
-					{
-						glm::vec2 tc = thetaCartesian[lon % longitudeSegments];
-						glm::vec2 rtc = rhoThetaCartesian[lon % longitudeSegments];
-						float sTex = sTexCache[lon];
-
-						vertices[index] = glm::vec3(rtc.x, z, -rtc.y);
-						normals[index]  = glm::vec3(tc.x, 0.f, -tc.y);
-						++index;
-					}
-				}
+				const float fac = h / (rings + 1.f);
+				const float z = (height / 2.f) - height * fac;
+				const int index = vOffsetCylinder + (h - 1) * ringSize;
+				writeRing(cosTheta.data(), sinTheta.data(), ringSize, radius, z, 1.f, 0.f, &vertices[index], &normals[index]);
 			}
 
-			// Triangle indices
-			const int long3 = longitudeSegments * 3;
-			const int long6 = longitudeSegments * 6;
-			const int hemiLong = (halfLats - 1) * long6;
-
-			const int tOffsetNorthHemi = long3;
-			const int tOffsetCylinder = tOffsetNorthHemi + hemiLong;
-			const int tOffsetSouthHemi = tOffsetCylinder + (rings + 1) * long6;
-			const int tOffsetSouthCap = tOffsetSouthHemi + hemiLong;
-
-			int triCount = tOffsetSouthCap + long3;
-			std::vector<GLuint> indices(triCount);
-
 			// Polar caps
 			for (int i = 0, k = 0, m = tOffsetSouthCap; i < longitudeSegments; ++i, k += 3, m += 3)
 			{
@@ -550,11 +667,47 @@ namespace gfx
 				}
 			}
 
-			MeshData meshData;
-			meshData.vertices = vertices;
-			meshData.normals = normals;
-			meshData.indices = indices;
 			return meshData;
 		}
+
+		PrimitiveDesc DescribeQuad(float width, float height)
+		{
+			return { PrimitiveType_Quad, { width, height, 0.0f }, { 0, 0, 0 } };
+		}
+
+		PrimitiveDesc DescribeBox(float width, float height, float depth)
+		{
+			return { PrimitiveType_Box, { width, height, depth }, { 0, 0, 0 } };
+		}
+
+		PrimitiveDesc DescribeSphere(int segments, float radius)
+		{
+			return { PrimitiveType_Sphere, { radius, 0.0f, 0.0f }, { segments, 0, 0 } };
+		}
+
+		PrimitiveDesc DescribeCylinder(float radius, float height, int segments)
+		{
+			return { PrimitiveType_Cylinder, { radius, height, 0.0f }, { segments, 0, 0 } };
+		}
+
+		PrimitiveDesc DescribeCapsule(float radius, float height, int latitudeSegments, int longitudeSegments, int rings)
+		{
+			return { PrimitiveType_Capsule, { radius, height, 0.0f }, { latitudeSegments, longitudeSegments, rings } };
+		}
+
+		MeshData Generate(const PrimitiveDesc& primitive)
+		{
+			const float* size = primitive.size;
+			const int* segments = primitive.segments;
+			switch (primitive.type)
+			{
+			case PrimitiveType_Quad:		return Quad(size[0], size[1]);
+			case PrimitiveType_Box:			return Box(size[0], size[1], size[2]);
+			case PrimitiveType_Sphere:		return Sphere(segments[0], size[0]);
+			case PrimitiveType_Cylinder:	return Cylinder(size[0], size[1], segments[0]);
+			case PrimitiveType_Capsule:		return Capsule(size[0], size[1], segments[0], segments[1], segments[2]);
+			}
+			return MeshData{};
+		}
 	}
 }
\ No newline at end of file
@@ -3,6 +3,26 @@
 
 namespace gfx
 {
+	enum PrimitiveType
+	{
+		PrimitiveType_Quad,
+		PrimitiveType_Box,
+		PrimitiveType_Sphere,
+		PrimitiveType_Cylinder,
+		PrimitiveType_Capsule
+	};
+
+	// A primitive generator and its parameters, identifying the geometry it generates (see CreateCachedMesh).
+	// Build with the primitive::Describe* functions, which leave unused parameters 0 so equal primitives compare equal.
+	struct PrimitiveDesc
+	{
+		PrimitiveType	type;
+		float			size[3];
+		int				segments[3];
+
+		bool operator==(const PrimitiveDesc&) const = default;
+	};
+
 	namespace primitive
 	{
 		MeshData Quad(float width, float height);
@@ -10,5 +30,14 @@ namespace gfx
 		MeshData Sphere(int segments, float radius);
 		MeshData Cylinder(float radius, float height, int segments);
 		MeshData Capsule(float radius, float height, int latitudeSegments, int longitudeSegments, int rings);
+
+		PrimitiveDesc DescribeQuad(float width, float height);
+		PrimitiveDesc DescribeBox(float width, float height, float depth);
+		PrimitiveDesc DescribeSphere(int segments, float radius);
+		PrimitiveDesc DescribeCylinder(float radius, float height, int segments);
+		PrimitiveDesc DescribeCapsule(float radius, float height, int latitudeSegments, int longitudeSegments, int rings);
+
+		// Runs the generator described by {primitive}.
+		MeshData Generate(const PrimitiveDesc& primitive);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include "RangeAllocator.h"
+
+namespace gfx
+{
+	std::optional<size_t> RangeAllocator::Allocate(size_t size)
+	{
+		if (size == 0)
+		{
+			return std::nullopt;
+		}
+
+		for (size_t i = 0; i < freeRanges.size(); ++i)
+		{
+			Range& range = freeRanges[i];
+			if (range.size < size)
+			{
+				continue;
+			}
+
+			const size_t offset = range.offset;
+			range.offset += size;
+			range.size -= size;
+			if (range.size == 0)
+			{
+				freeRanges.erase(freeRanges.begin() + i);
+			}
+
+			used += size;
+			return offset;
+		}
+
+		return std::nullopt;
+	}
+
+	void RangeAllocator::Free(size_t offset, size_t size)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+
+		used -= size;
+
+		// First free range after the freed one.
+		auto next = std::lower_bound(freeRanges.begin(), freeRanges.end(), offset,
+			[](const Range& range, size_t value) { return range.offset < value; });
+
+		const bool mergePrevious = next != freeRanges.begin() && std::prev(next)->offset + std::prev(next)->size == offset;
+		const bool mergeNext = next != freeRanges.end() && offset + size == next->offset;
+
+		if (mergePrevious && mergeNext)
+		{
+			std::prev(next)->size += size + next->size;
+			freeRanges.erase(next);
+		}
+		else if (mergePrevious)
+		{
+			std::prev(next)->size += size;
+		}
+		else if (mergeNext)
+		{
+			next->offset = offset;
+			next->size += size;
+		}
+		else
+		{
+			freeRanges.insert(next, { offset, size });
+		}
+	}
+
+	void RangeAllocator::Grow(size_t newCapacity)
+	{
+		if (newCapacity <= capacity)
+		{
+			return;
+		}
+
+		if (!freeRanges.empty() && freeRanges.back().offset + freeRanges.back().size == capacity)
+		{
+			freeRanges.back().size += newCapacity - capacity;
+		}
+		else
+		{
+			freeRanges.push_back({ capacity, newCapacity - capacity });
+		}
+		capacity = newCapacity;
+	}
+
+	void RangeAllocator::Reset()
+	{
+		freeRanges.clear();
+		capacity = 0;
+		used = 0;
+	}
+}
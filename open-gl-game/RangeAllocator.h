@@ -0,0 +1,35 @@
+#pragma once
+#include <optional>
+#include <vector>
+
+namespace gfx
+{
+	// Hands out ranges of [0, Capacity()) in arbitrary units (eg. vertices of a pooled vertex buffer).
+	// First fit over a free list kept sorted by offset. Freed ranges merge with free neighbours, so the list stays short.
+	class RangeAllocator
+	{
+	public:
+		// Returns the offset of {size} free units, or nothing if no free range is large enough.
+		std::optional<size_t> Allocate(size_t size);
+		// {offset} and {size} must be exactly what was allocated.
+		void Free(size_t offset, size_t size);
+		// Extends the range to [0, {capacity}). Existing allocations keep their offsets.
+		void Grow(size_t capacity);
+		void Reset();
+
+		inline size_t Capacity() const { return capacity; }
+		inline size_t Used() const { return used; }
+		inline size_t FreeRangeCount() const { return freeRanges.size(); }
+
+	private:
+		struct Range
+		{
+			size_t offset;
+			size_t size;
+		};
+
+		std::vector<Range>	freeRanges;
+		size_t				capacity = 0;
+		size_t				used = 0;
+	};
+}
@@ -0,0 +1,142 @@
+#include <algorithm>
+#include "RenderQueue.h"
+
+namespace gfx
+{
+	uint64_t MakeSortKey(ShaderHandle shader, const Mesh& mesh, uint32_t material, float depth01)
+	{
+		const uint64_t depth = static_cast<uint64_t>(glm::clamp(depth01, 0.0f, 1.0f) * 0xFFFF);
+		return	(static_cast<uint64_t>(shader & 0xFFF) << 52) |
+				(static_cast<uint64_t>(mesh.vao & 0xFF) << 44) |
+				(static_cast<uint64_t>(mesh.baseVertex & 0xFFFFF) << 24) |
+				(static_cast<uint64_t>(material & 0xFF) << 16) |
+				depth;
+	}
+
+	void RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch)
+	{
+		const size_t count = entries.size();
+		if (count == 0)
+		{
+			return;
+		}
+		scratch.resize(count);
+
+		// Byte histograms for all 8 passes, built in one pass over the keys.
+		size_t histograms[8][256] = {};
+		for (size_t i = 0; i < count; ++i)
+		{
+			const uint64_t key = entries[i].key;
+			for (int pass = 0; pass < 8; ++pass)
+			{
+				++histograms[pass][(key >> (pass * 8)) & 0xFF];
+			}
+		}
+
+		SortEntry* source = entries.data();
+		SortEntry* destination = scratch.data();
+		for (int pass = 0; pass < 8; ++pass)
+		{
+			const int shift = pass * 8;
+			size_t* histogram = histograms[pass];
+
+			// Every key has the same byte here (eg. a single shader), the pass wouldn't move anything.
+			if (histogram[(source[0].key >> shift) & 0xFF] == count)
+			{
+				continue;
+			}
+
+			size_t offset = 0;
+			for (int digit = 0; digit < 256; ++digit)
+			{
+				const size_t digitCount = histogram[digit];
+				histogram[digit] = offset;
+				offset += digitCount;
+			}
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				destination[histogram[(source[i].key >> shift) & 0xFF]++] = source[i];
+			}
+
+			std::swap(source, destination);
+		}
+
+		// An odd number of passes moved leaves the result in {scratch}.
+		if (source != entries.data())
+		{
+			entries.swap(scratch);
+		}
+	}
+
+	void RenderQueue::Clear()
+	{
+		items.clear();
+		sortedItems.clear();
+		batches.clear();
+		stats = RenderQueueStats{};
+	}
+
+	void RenderQueue::Submit(ShaderHandle shader, const Mesh& mesh, uint32_t material, float depth01, const glm::mat4& model)
+	{
+		items.push_back({ MakeSortKey(shader, mesh, material, depth01), shader, mesh, material, model });
+	}
+
+	void RenderQueue::Sort()
+	{
+		const size_t count = items.size();
+		sortedItems.clear();
+		batches.clear();
+		stats = RenderQueueStats{};
+		stats.items = count;
+
+		if (count == 0)
+		{
+			return;
+		}
+
+		sortEntries.resize(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			sortEntries[i] = { items[i].key, static_cast<uint32_t>(i) };
+		}
+		RadixSort(sortEntries, sortScratch);
+
+		sortedItems.reserve(count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			sortedItems.push_back(items[sortEntries[i].index]);
+		}
+
+		// Split into batches, comparing the real values rather than the (truncated) key fields.
+		const RenderItem* previous = nullptr;
+		for (size_t i = 0; i < count; ++i)
+		{
+			const RenderItem& item = sortedItems[i];
+
+			unsigned int changes = 0;
+			if (!previous || previous->shader != item.shader)		changes |= RenderStateChange_Shader | RenderStateChange_Material;
+			if (!previous || previous->mesh.vao != item.mesh.vao)	changes |= RenderStateChange_VertexArray | RenderStateChange_Mesh;
+			else if (previous->mesh.baseVertex != item.mesh.baseVertex || previous->mesh.firstIndex != item.mesh.firstIndex)
+				changes |= RenderStateChange_Mesh;
+			if (!previous || previous->material != item.material)	changes |= RenderStateChange_Material;
+
+			if (changes == 0)
+			{
+				++batches.back().count;
+			}
+			else
+			{
+				batches.push_back({ changes, i, 1 });
+				if (changes & RenderStateChange_Shader)		++stats.shaderChanges;
+				if (changes & RenderStateChange_Mesh)		++stats.meshChanges;
+				if (changes & RenderStateChange_VertexArray)	++stats.vertexArrayChanges;
+				if (changes & RenderStateChange_Material)	++stats.materialChanges;
+			}
+
+			previous = &item;
+		}
+
+		stats.batches = batches.size();
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include "Mesh.h"
+#include "Shader.h"
+
+namespace gfx
+{
+	// Sort key layout, most significant bits first, so items group by shader, then VAO, then mesh, then material and draw front to back:
+	// [63..52] shader | [51..44] VAO | [43..24] mesh (base vertex, pooled meshes share a VAO) | [23..16] material | [15..0] depth
+	// Fields are truncated to their width. Truncation can only cost extra state changes, batching compares the real values.
+	uint64_t MakeSortKey(ShaderHandle shader, const Mesh& mesh, uint32_t material, float depth01);
+
+	// A sort key and the index of what it sorts.
+	struct SortEntry
+	{
+		uint64_t key;
+		uint32_t index;
+	};
+
+	// LSD radix sort of {entries} by key, 8 bits per pass. Stable, so equal keys keep their order. {scratch} is resized as needed,
+	// pass the same one every time to reuse its allocation.
+	void RadixSort(std::vector<SortEntry>& entries, std::vector<SortEntry>& scratch);
+
+	struct RenderItem
+	{
+		uint64_t		key;
+		ShaderHandle	shader;
+		Mesh			mesh;
+		uint32_t		material;
+		glm::mat4		model;
+	};
+
+	// State that differs from the previous item in sorted order.
+	enum RenderStateChangeFlags : unsigned int
+	{
+		RenderStateChange_Shader		= 1 << 0,
+		// A different mesh. Its VAO may still be the same (see RenderStateChange_VertexArray).
+		RenderStateChange_Mesh			= 1 << 1,
+		RenderStateChange_Material		= 1 << 2,
+		// A different VAO, always comes with RenderStateChange_Mesh.
+		RenderStateChange_VertexArray	= 1 << 3
+	};
+
+	// A run of consecutive sorted items sharing shader, mesh and material.
+	struct RenderBatch
+	{
+		// RenderStateChangeFlags to apply before drawing the run. A shader change also flags the material, as uniforms are per program.
+		unsigned int	changes;
+		size_t			first;
+		size_t			count;
+	};
+
+	struct RenderQueueStats
+	{
+		size_t items;
+		size_t batches;
+		size_t shaderChanges;
+		size_t meshChanges;
+		size_t vertexArrayChanges;
+		size_t materialChanges;
+
+		// Mesh changes within a VAO only change draw parameters, they aren't counted.
+		inline size_t stateChanges() const { return shaderChanges + vertexArrayChanges + materialChanges; }
+	};
+
+	// Collects a frame's draws, radix sorts them by key and splits them into batches so only the state
+	// that actually differs between consecutive items needs to be set.
+	class RenderQueue
+	{
+	public:
+		void Clear();
+		// {depth01} is the normalized view distance, 0 = near plane, 1 = far plane.
+		void Submit(ShaderHandle shader, const Mesh& mesh, uint32_t material, float depth01, const glm::mat4& model);
+		void Sort();
+
+		// Items in sorted order. Valid after Sort().
+		inline const std::vector<RenderItem>& Items() const { return sortedItems; }
+		inline const std::vector<RenderBatch>& Batches() const { return batches; }
+		inline const RenderQueueStats& Stats() const { return stats; }
+
+	private:
+		std::vector<RenderItem> items;
+		std::vector<RenderItem> sortedItems;
+		std::vector<SortEntry> sortEntries;
+		std::vector<SortEntry> sortScratch;
+		std::vector<RenderBatch> batches;
+		RenderQueueStats stats{};
+	};
+}
@@ -1,24 +1,111 @@
 #include <GL/glew.h>
-#include <functional>
-#include "shader.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <unordered_map>
+#include <utility>
+#include "GLState.h"
+#include "MappedFile.h"
+#include "Shader.h"
 
 namespace gfx
 {
-	std::hash<std::string> string_hash;
+	// One entry of a program's uniform table.
+	struct UniformSlot
+	{
+		UniformId	id;
+		GLint		location;
+		// GL type of the uniform. 0 marks an empty slot.
+		GLenum		type;
+		// Last value set, in ProgramUniformCache::values.
+		uint32_t	valueOffset;
+		uint32_t	valueSize;
+		bool		hasValue;
+	};
+
+	// Reflection cache of a linked program: an open-addressed (linear probing) table keyed by UniformId,
+	// plus a shadow copy of every uniform's last value.
+	struct ProgramUniformCache
+	{
+		std::vector<UniformSlot>	slots;
+		// slots.size() - 1, slots.size() is a power of two.
+		uint32_t					mask = 0;
+		std::vector<char>			values;
+	};
 
-	ShaderSource default_unlit_texture =
+	std::unordered_map<ShaderHandle, ProgramUniformCache> programUniformCaches;
+	// Cache of the program bound with UseShader.
+	ProgramUniformCache* currentUniformCache = nullptr;
+
+	// GLSL declarations of FrameUniforms and ObjectUniforms. Both stages of a program must declare a block identically.
+#define FRAME_UNIFORM_BLOCK \
+		"layout(std140) uniform Frame { \n" \
+		"mat4 view; \n" \
+		"mat4 projection; \n" \
+		"mat4 viewProjection; \n" \
+		"vec4 lightDir; \n" \
+		"}; \n"
+
+#define OBJECT_UNIFORM_BLOCK \
+		"layout(std140) uniform Object { \n" \
+		"mat4 mvp; \n" \
+		"mat4 model; \n" \
+		"vec4 color; \n" \
+		"}; \n"
+
+	ShaderSource default_shader =
 	{
 		"#version 330 core \n"
 		"layout(location = 0) in vec3 position; \n"
-		"layout(location = 1) in vec2 uv; \n"
-		"uniform mat4 mvp; \n"
+		"#ifdef LIT \n"
+		"layout(location = 1) in vec3 normal; \n"
+		"#endif \n"
+		"#ifdef TEXTURE \n"
+		"layout(location = 2) in vec2 uv; \n"
+		"#endif \n"
+		"#ifdef VERTEX_COLOR \n"
+		"layout(location = 3) in vec4 vertexColor; \n"
+		"#endif \n"
+		"#ifdef INSTANCED \n"
+		"layout(location = 4) in mat4 instanceModel; \n"
+		"layout(location = 8) in vec4 instanceColor; \n"
+		"layout(location = 9) in vec4 instancePositionScale; \n"
+		"layout(location = 10) in vec4 instancePositionOffset; \n"
+		FRAME_UNIFORM_BLOCK
+		"#else \n"
+		OBJECT_UNIFORM_BLOCK
+		"#endif \n"
 		"out VS_OUT { \n"
+		"vec4 color; \n"
+		"#ifdef LIT \n"
+		"vec3 normal; \n"
+		"#endif \n"
+		"#ifdef TEXTURE \n"
 		"vec2 uv; \n"
+		"#endif \n"
 		"} vs_out; \n"
-		""
 		"void main() { \n"
-		"vs_out.uv = uv; \n"
+		"#ifdef INSTANCED \n"
+		"mat4 objectModel = instanceModel; \n"
+		"vs_out.color = instanceColor; \n"
+		"vec3 meshPosition = position * instancePositionScale.xyz + instancePositionOffset.xyz; \n"
+		"gl_Position = viewProjection * instanceModel * vec4(meshPosition, 1.0); \n"
+		"#else \n"
+		"mat4 objectModel = model; \n"
+		"vs_out.color = color; \n"
 		"gl_Position = mvp * vec4(position, 1.0); \n"
+		"#endif \n"
+		"#ifdef VERTEX_COLOR \n"
+		"vs_out.color *= vertexColor; \n"
+		"#endif \n"
+		"#ifdef LIT \n"
+		"vs_out.normal = normalize(vec3(objectModel * vec4(normal, 0.0))); \n"
+		"#endif \n"
+		"#ifdef TEXTURE \n"
+		"vs_out.uv = uv; \n"
+		"#endif \n"
 		"}",
 
 		std::optional<std::string>(),
@@ -26,88 +113,94 @@ namespace gfx
 		std::optional<std::string>(),
 
 		"#version 330 core \n"
+		"#ifdef LIT \n"
+		FRAME_UNIFORM_BLOCK
+		"#endif \n"
+		"#ifdef TEXTURE \n"
 		"uniform sampler2D textureMap; \n"
+		"#endif \n"
 		"in VS_OUT { \n"
+		"vec4 color; \n"
+		"#ifdef LIT \n"
+		"vec3 normal; \n"
+		"#endif \n"
+		"#ifdef TEXTURE \n"
 		"vec2 uv; \n"
+		"#endif \n"
 		"} fs_in; \n"
 		"out vec4 fragment; \n"
 		"void main() { \n"
-		"fragment = texture(textureMap, fs_in.uv); \n"
+		"fragment = fs_in.color; \n"
+		"#ifdef TEXTURE \n"
+		"fragment *= texture(textureMap, fs_in.uv); \n"
+		"#endif \n"
+		"#ifdef LIT \n"
+		"fragment.rgb *= dot(fs_in.normal, lightDir.xyz); \n"
+		"#endif \n"
+		"#ifdef ALPHA_TEST \n"
 		"if(fragment.a < 0.5) discard; \n"
-		//"fragment = vec4(1,0,0,1); \n"
+		"#endif \n"
 		"} \n"
 	};
 
-	ShaderSource default_unlit_color =
-	{
-		"#version 330 core \n"
-		"layout(location = 0) in vec3 position; \n"
-		"uniform mat4 mvp; \n"
-		""
-		"void main() { \n"
-		"gl_Position = mvp * vec4(position, 1.0); \n"
-		"}",
-
-		std::optional<std::string>(),
-		std::optional<std::string>(),
-		std::optional<std::string>(),
+	ShaderSource default_unlit_texture = SpecializeShader(default_shader, MakeShaderVariantKey(ShaderFeature_Texture, ShaderFeature_AlphaTest));
+	ShaderSource default_unlit_color = SpecializeShader(default_shader, MakeShaderVariantKey(ShaderFeature_AlphaTest));
+	ShaderSource default_lit_color = SpecializeShader(default_shader, MakeShaderVariantKey(ShaderFeature_Lit, ShaderFeature_AlphaTest));
+	ShaderSource default_lit_color_instanced =
+		SpecializeShader(default_shader, MakeShaderVariantKey(ShaderFeature_Lit, ShaderFeature_Instanced, ShaderFeature_AlphaTest));
 
-		"#version 330 core \n"
-		"uniform vec4 color; \n"
-		"out vec4 fragment; \n"
-		"void main() { \n"
-		"fragment = color; \n"
-		"if(fragment.a < 0.5) discard; \n"
-		"} \n"
-	};
+	// Macro names of the ShaderFeature bits, in bit order.
+	const char* const shaderFeatureNames[ShaderFeature_Count] = { "LIT", "TEXTURE", "VERTEX_COLOR", "INSTANCED", "ALPHA_TEST" };
 
-	ShaderSource default_lit_color =
+	// Inserts {defines} after the #version line of {stage}, which GLSL requires to come first.
+	std::string specialize_stage(const std::string& stage, const std::string& defines)
 	{
-		"#version 330 core \n"
-		"layout(location = 0) in vec3 position; \n"
-		"layout(location = 1) in vec3 normal; \n"
-		"uniform mat4 mvp; \n"
-		"uniform mat4 model; \n"
-		"out VS_OUT{ \n"
-		"vec3 normal;\n"
-		"} vs_out;\n"
-		"void main() { \n"
-		"vs_out.normal = normalize(vec3(model * vec4(normal, 0.0)));\n"
-		"gl_Position = mvp * vec4(position, 1.0); \n"
-		"}",
+		const size_t version = stage.find("#version");
+		if (version == std::string::npos)
+		{
+			return defines + stage;
+		}
+		const size_t lineEnd = stage.find('\n', version);
+		const size_t at = lineEnd == std::string::npos ? stage.size() : lineEnd + 1;
+		std::string specialized = stage.substr(0, at);
+		if (lineEnd == std::string::npos) specialized += '\n';
+		return specialized + defines + stage.substr(at);
+	}
 
-		std::optional<std::string>(),
-		std::optional<std::string>(),
-		std::optional<std::string>(),
+	ShaderSource SpecializeShader(const ShaderSource& base, ShaderVariantKey key)
+	{
+		std::string defines;
+		for (uint32_t feature = 0; feature < ShaderFeature_Count; ++feature)
+		{
+			if (key & (1u << feature))
+			{
+				defines += "#define ";
+				defines += shaderFeatureNames[feature];
+				defines += " \n";
+			}
+		}
 
-		"#version 330 core \n"
-		"uniform vec4 color; \n"
-		"uniform vec3 lightDir; \n"
-		"in VS_OUT{ \n"
-		"vec3 normal; \n"
-		"} fs_in; \n"
-		"out vec4 fragment; \n"
-		"void main() { \n"
-		"float ndl = dot(fs_in.normal, lightDir); \n"
-		"fragment = vec4(color.rgb * ndl, color.a); \n"
-		//"fragment = vec4(fs_in.normal.rgb, color.a); \n"
-		"if(fragment.a < 0.5) discard; \n"
-		"} \n"
-	};
+		ShaderSource specialized;
+		specialized.vertex = specialize_stage(base.vertex, defines);
+		if (base.control)		specialized.control = specialize_stage(*base.control, defines);
+		if (base.evaluation)	specialized.evaluation = specialize_stage(*base.evaluation, defines);
+		if (base.geometry)		specialized.geometry = specialize_stage(*base.geometry, defines);
+		specialized.fragment = specialize_stage(base.fragment, defines);
+		return specialized;
+	}
 
-	bool compile_shader_source(GLenum type, GLsizei count, const std::string& source, GLuint& shaderHandle)
+	// Creates and compiles one stage and attaches it to {programHandle}. Queries nothing, so it never waits for the compiler.
+	GLuint attach_shader_source(GLuint programHandle, GLenum type, const std::string& source)
 	{
-		shaderHandle = glCreateShader(type);
-
-		int compiled = 0;
+		const GLuint shaderHandle = glCreateShader(type);
 
 		const char* src = source.c_str();
 		const int length = source.length();
-		glShaderSource(shaderHandle, count, &src, &length);
+		glShaderSource(shaderHandle, 1, &src, &length);
 		glCompileShader(shaderHandle);
-		glGetShaderiv(shaderHandle, GL_COMPILE_STATUS, &compiled);
+		glAttachShader(programHandle, shaderHandle);
 
-		return static_cast<bool>(compiled);
+		return shaderHandle;
 	}
 
 	void cleanup_shaders(GLuint vertex, GLuint control, GLuint evaluation, GLuint geometry, GLuint fragment)
@@ -119,92 +212,656 @@ namespace gfx
 		if (fragment)	glDeleteShader(fragment);
 	}
 
-	ShaderHandle CompileShader(const ShaderSource& source)
+	// Binds the program's "Frame" and "Object" blocks, if it has them, to their fixed binding points.
+	void bind_uniform_blocks(ShaderHandle handle)
 	{
-		GLuint programHandle = glCreateProgram();
+		const GLuint frameBlock = glGetUniformBlockIndex(handle, "Frame");
+		if (frameBlock != GL_INVALID_INDEX) glUniformBlockBinding(handle, frameBlock, UniformBlock_Frame);
 
-		GLuint vertexShader = 0;
-		GLuint controlShader = 0;
-		GLuint evaluationShader = 0;
-		GLuint geometryShader = 0;
-		GLuint fragmentShader = 0;
+		const GLuint objectBlock = glGetUniformBlockIndex(handle, "Object");
+		if (objectBlock != GL_INVALID_INDEX) glUniformBlockBinding(handle, objectBlock, UniformBlock_Object);
+	}
 
-		if (!compile_shader_source(GL_VERTEX_SHADER, 1, source.vertex, vertexShader))
+	// Size in bytes of one element of a uniform of GL type {type}.
+	uint32_t uniform_value_size(GLenum type)
+	{
+		switch (type)
 		{
-			cleanup_shaders(vertexShader, controlShader, evaluationShader, geometryShader, fragmentShader);
-			return 0;
+		case GL_FLOAT:
+		case GL_INT:
+		case GL_UNSIGNED_INT:
+		case GL_BOOL:			return 4;
+		case GL_FLOAT_VEC2:
+		case GL_INT_VEC2:		return 8;
+		case GL_FLOAT_VEC3:
+		case GL_INT_VEC3:		return 12;
+		case GL_FLOAT_VEC4:
+		case GL_INT_VEC4:		return 16;
+		case GL_FLOAT_MAT3:		return 36;
+		case GL_FLOAT_MAT4:		return 64;
+		default:				return 4; // Samplers
 		}
+	}
 
-		if (!compile_shader_source(GL_FRAGMENT_SHADER, 1, source.fragment, fragmentShader))
+	// Array uniforms are reported as "name[0]", look them up by their plain name.
+	std::string_view uniform_base_name(std::string_view name)
+	{
+		if (name.size() > 3 && name.substr(name.size() - 3) == "[0]")
 		{
-			cleanup_shaders(vertexShader, controlShader, evaluationShader, geometryShader, fragmentShader);
-			return 0;
+			name.remove_suffix(3);
 		}
+		return name;
+	}
 
-		if (source.control.has_value())
+	UniformSlot* find_uniform(ProgramUniformCache& cache, UniformId id)
+	{
+		if (cache.slots.empty())
 		{
-			if (!compile_shader_source(GL_TESS_CONTROL_SHADER, 1, source.control.value(), controlShader))
-			{
-				cleanup_shaders(vertexShader, controlShader, evaluationShader, geometryShader, fragmentShader);
-				return 0;
-			}
+			return nullptr;
 		}
 
-		if (source.evaluation.has_value())
+		for (uint32_t i = id & cache.mask;; i = (i + 1) & cache.mask)
 		{
-			if (!compile_shader_source(GL_TESS_EVALUATION_SHADER, 1, source.evaluation.value(), evaluationShader))
+			UniformSlot& slot = cache.slots[i];
+			if (slot.type == 0)	return nullptr;
+			if (slot.id == id)	return &slot;
+		}
+	}
+
+	// Returns false if two uniforms of the program hash alike: SetUniform could not tell them apart.
+	bool build_uniform_cache(ShaderHandle handle)
+	{
+		const std::vector<ShaderUniform> uniforms = GetShaderUniforms(handle);
+
+		ProgramUniformCache& cache = programUniformCaches[handle];
+		cache = ProgramUniformCache{};
+
+		// Keep the load factor at or below 1/2 so probe sequences stay short and always reach an empty slot.
+		uint32_t capacity = 4;
+		while (capacity < uniforms.size() * 2)
+		{
+			capacity *= 2;
+		}
+		cache.slots.assign(capacity, UniformSlot{});
+		cache.mask = capacity - 1;
+
+		for (const ShaderUniform& uniform : uniforms)
+		{
+			// Uniforms inside uniform blocks have no location.
+			if (uniform.location < 0)
+			{
+				continue;
+			}
+
+			uint32_t i = uniform.id & cache.mask;
+			while (cache.slots[i].type != 0 && cache.slots[i].id != uniform.id)
+			{
+				i = (i + 1) & cache.mask;
+			}
+
+			if (cache.slots[i].type != 0)
 			{
-				cleanup_shaders(vertexShader, controlShader, evaluationShader, geometryShader, fragmentShader);
-				return 0;
+				std::cerr << "[Shader] Uniform name hash collision in program " << handle << ", uniform at location " << uniform.location << " hashes like another one, rename one of them" << std::endl;
+				programUniformCaches.erase(handle);
+				return false;
 			}
+
+			// Arrays are shadowed (and set) through their first element only.
+			UniformSlot& slot = cache.slots[i];
+			slot.id = uniform.id;
+			slot.location = uniform.location;
+			slot.type = uniform.type;
+			slot.valueOffset = static_cast<uint32_t>(cache.values.size());
+			slot.valueSize = uniform_value_size(uniform.type);
+			slot.hasValue = false;
+			cache.values.resize(cache.values.size() + slot.valueSize);
+		}
+		return true;
+	}
+
+	// Looks up {id} in the current program and updates its shadow copy.
+	// Returns the uniform's location, or -1 if the uniform doesn't exist or already holds {value}.
+	template<typename T>
+	GLint update_uniform(UniformId id, const T& value)
+	{
+		if (currentUniformCache == nullptr)
+		{
+			return -1;
+		}
+
+		UniformSlot* slot = find_uniform(*currentUniformCache, id);
+		if (slot == nullptr)
+		{
+			return -1;
 		}
 
-		if (source.geometry.has_value())
+		// A value of a different size than the uniform can't be shadowed. Upload it and let GL report the mismatch.
+		if (sizeof(T) != slot->valueSize)
 		{
-			if (!compile_shader_source(GL_GEOMETRY_SHADER, 1, source.geometry.value(), geometryShader))
+			slot->hasValue = false;
+			return slot->location;
+		}
+
+		char* shadow = &currentUniformCache->values[slot->valueOffset];
+		if (slot->hasValue && memcmp(shadow, &value, sizeof(T)) == 0)
+		{
+			return -1;
+		}
+
+		memcpy(shadow, &value, sizeof(T));
+		slot->hasValue = true;
+		return slot->location;
+	}
+
+	void SetUniform(UniformId id, int value)
+	{
+		const GLint location = update_uniform(id, value);
+		if (location >= 0) glUniform1i(location, value);
+	}
+
+	void SetUniform(UniformId id, float value)
+	{
+		const GLint location = update_uniform(id, value);
+		if (location >= 0) glUniform1f(location, value);
+	}
+
+	void SetUniform(UniformId id, const glm::vec2& value)
+	{
+		const GLint location = update_uniform(id, value);
+		if (location >= 0) glUniform2fv(location, 1, &value[0]);
+	}
+
+	void SetUniform(UniformId id, const glm::vec3& value)
+	{
+		const GLint location = update_uniform(id, value);
+		if (location >= 0) glUniform3fv(location, 1, &value[0]);
+	}
+
+	void SetUniform(UniformId id, const glm::vec4& value)
+	{
+		const GLint location = update_uniform(id, value);
+		if (location >= 0) glUniform4fv(location, 1, &value[0]);
+	}
+
+	void SetUniform(UniformId id, const glm::mat3& value)
+	{
+		const GLint location = update_uniform(id, value);
+		if (location >= 0) glUniformMatrix3fv(location, 1, GL_FALSE, &value[0][0]);
+	}
+
+	void SetUniform(UniformId id, const glm::mat4& value)
+	{
+		const GLint location = update_uniform(id, value);
+		if (location >= 0) glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+	}
+
+	std::string shaderCacheDirectory;
+	ShaderCacheStats shaderCacheStats{};
+
+	// Program binary file: this header, then the driver's binary.
+	const uint32_t ProgramBinaryMagic = 0x4E494250; // "PBIN"
+	// Bump whenever the header or the key changes.
+	const uint32_t ProgramBinaryVersion = 1;
+
+	struct ProgramBinaryHeader
+	{
+		uint32_t	magic;
+		uint32_t	version;
+		uint64_t	key;
+		uint32_t	format;
+		uint32_t	length;
+	};
+
+	// Binary formats the driver accepts. Empty if it has none, which turns the binary cache off.
+	std::vector<GLint> program_binary_formats()
+	{
+		GLint count = 0;
+		if (GLEW_ARB_get_program_binary)
+		{
+			glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &count);
+		}
+
+		std::vector<GLint> formats(std::max(count, 0));
+		if (!formats.empty())
+		{
+			glGetIntegerv(GL_PROGRAM_BINARY_FORMATS, formats.data());
+		}
+		return formats;
+	}
+
+	// FNV-1a hash of every stage and of the driver identity: a binary is only valid for the exact source and driver that built it.
+	uint64_t program_binary_key(const ShaderSource& source)
+	{
+		uint64_t hash = 14695981039346656037ull;
+		auto hashString = [&](std::string_view text)
+		{
+			// Length first, so the boundaries between strings are part of the key.
+			const uint64_t length = text.size();
+			for (size_t i = 0; i < sizeof(length); ++i)
 			{
-				cleanup_shaders(vertexShader, controlShader, evaluationShader, geometryShader, fragmentShader);
-				return 0;
+				hash = (hash ^ static_cast<unsigned char>(length >> (i * 8))) * 1099511628211ull;
 			}
-		}
+			for (char c : text)
+			{
+				hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+			}
+		};
+		auto hashStage = [&](const std::optional<std::string>& stage)
+		{
+			hashString(stage.has_value() ? "+" : "-");
+			hashString(stage.value_or(std::string()));
+		};
 
-		glAttachShader(programHandle, vertexShader);
-		glAttachShader(programHandle, fragmentShader);
+		hashString(source.vertex);
+		hashStage(source.control);
+		hashStage(source.evaluation);
+		hashStage(source.geometry);
+		hashString(source.fragment);
 
-		if (source.control.has_value())		glAttachShader(programHandle, controlShader);
-		if (source.evaluation.has_value())	glAttachShader(programHandle, evaluationShader);
-		if (source.geometry.has_value())	glAttachShader(programHandle, geometryShader);
+		for (GLenum name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+		{
+			const GLubyte* driver = glGetString(name);
+			hashString(driver ? reinterpret_cast<const char*>(driver) : "");
+		}
+		return hash;
+	}
 
-		glLinkProgram(programHandle);
+	std::string program_binary_path(uint64_t key)
+	{
+		char name[32];
+		snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(key));
+		return (std::filesystem::path(shaderCacheDirectory) / name).string();
+	}
 
-		glDetachShader(programHandle, vertexShader);
-		glDetachShader(programHandle, fragmentShader);
+	// Creates a program from the binary at {path}. Returns 0 if there is no file, it was built for another key or format,
+	// or the driver refuses it.
+	GLuint load_program_binary(const std::string& path, uint64_t key, const std::vector<GLint>& formats)
+	{
+		MappedFile file;
+		if (!file.Open(path.c_str()))
+		{
+			return 0;
+		}
 
-		if (source.control.has_value())		glDetachShader(programHandle, controlShader);
-		if (source.evaluation.has_value())	glDetachShader(programHandle, evaluationShader);
-		if (source.geometry.has_value())	glDetachShader(programHandle, geometryShader);
+		ProgramBinaryHeader header{};
+		if (file.Size() >= sizeof(header))
+		{
+			memcpy(&header, file.Data(), sizeof(header));
+		}
+		if (header.magic != ProgramBinaryMagic || header.version != ProgramBinaryVersion || header.key != key ||
+			header.length != file.Size() - sizeof(header) || std::find(formats.begin(), formats.end(), static_cast<GLint>(header.format)) == formats.end())
+		{
+			++shaderCacheStats.binaryRejects;
+			return 0;
+		}
 
-		cleanup_shaders(vertexShader, controlShader, evaluationShader, geometryShader, fragmentShader);
+		const GLuint programHandle = glCreateProgram();
+		glProgramBinary(programHandle, header.format, file.Data() + sizeof(header), header.length);
 
 		GLint linked = 0;
 		glGetProgramiv(programHandle, GL_LINK_STATUS, &linked);
 		if (!linked)
 		{
+			glDeleteProgram(programHandle);
+			++shaderCacheStats.binaryRejects;
 			return 0;
 		}
 
+		++shaderCacheStats.binaryLoads;
 		return programHandle;
 	}
 
+	// Writes the binary of the linked {programHandle} to {path}, through a temporary file so readers never see a partial one.
+	void save_program_binary(GLuint programHandle, const std::string& path, uint64_t key)
+	{
+		GLint length = 0;
+		glGetProgramiv(programHandle, GL_PROGRAM_BINARY_LENGTH, &length);
+		if (length <= 0)
+		{
+			return;
+		}
+
+		std::vector<char> contents(sizeof(ProgramBinaryHeader) + length);
+		GLsizei written = 0;
+		GLenum format = 0;
+		glGetProgramBinary(programHandle, length, &written, &format, contents.data() + sizeof(ProgramBinaryHeader));
+		if (written <= 0)
+		{
+			return;
+		}
+
+		const ProgramBinaryHeader header = { ProgramBinaryMagic, ProgramBinaryVersion, key, format, static_cast<uint32_t>(written) };
+		memcpy(contents.data(), &header, sizeof(header));
+		contents.resize(sizeof(header) + written);
+
+		std::error_code error;
+		std::filesystem::create_directories(shaderCacheDirectory, error);
+
+		const std::string temporaryPath = path + ".tmp";
+		FILE* file = fopen(temporaryPath.c_str(), "wb");
+		if (!file)
+		{
+			return;
+		}
+		bool ok = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+		ok = fclose(file) == 0 && ok;
+
+		if (ok)
+		{
+			std::filesystem::rename(temporaryPath, path, error);
+		}
+		if (!ok || error)
+		{
+			std::filesystem::remove(temporaryPath, error);
+			return;
+		}
+		++shaderCacheStats.binaryWrites;
+	}
+
+	// Compiles every stage of {source} into {shaders} and links them into a new program without querying any status, so with
+	// KHR_parallel_shader_compile none of it blocks. {retrievable} asks the driver to keep the binary for glGetProgramBinary.
+	GLuint begin_program(const ShaderSource& source, bool retrievable, GLuint (&shaders)[5])
+	{
+		const GLuint programHandle = glCreateProgram();
+		if (retrievable)
+		{
+			glProgramParameteri(programHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		}
+
+		shaders[0] = attach_shader_source(programHandle, GL_VERTEX_SHADER, source.vertex);
+		shaders[1] = source.control.has_value() ? attach_shader_source(programHandle, GL_TESS_CONTROL_SHADER, source.control.value()) : 0;
+		shaders[2] = source.evaluation.has_value() ? attach_shader_source(programHandle, GL_TESS_EVALUATION_SHADER, source.evaluation.value()) : 0;
+		shaders[3] = source.geometry.has_value() ? attach_shader_source(programHandle, GL_GEOMETRY_SHADER, source.geometry.value()) : 0;
+		shaders[4] = attach_shader_source(programHandle, GL_FRAGMENT_SHADER, source.fragment);
+
+		glLinkProgram(programHandle);
+		return programHandle;
+	}
+
+	// Waits for the link of {programHandle} if it still runs, then releases its shaders. A stage that failed to compile fails the link.
+	// Returns false, having deleted the program, on failure.
+	bool finish_program(GLuint programHandle, const GLuint (&shaders)[5])
+	{
+		GLint linked = 0;
+		glGetProgramiv(programHandle, GL_LINK_STATUS, &linked);
+
+		for (GLuint shaderHandle : shaders)
+		{
+			if (shaderHandle) glDetachShader(programHandle, shaderHandle);
+		}
+		cleanup_shaders(shaders[0], shaders[1], shaders[2], shaders[3], shaders[4]);
+
+		if (!linked)
+		{
+			glDeleteProgram(programHandle);
+			return false;
+		}
+
+		++shaderCacheStats.compiles;
+		return true;
+	}
+
+	ShaderHandle CompileShader(const ShaderSource& source)
+	{
+		ShaderCompiler compiler;
+		const ShaderCompileTicket ticket = compiler.Request(source);
+		compiler.Finish();
+		return compiler.IsReady(ticket) ? compiler.Take(ticket) : 0;
+	}
+
 	void DeleteShader(ShaderHandle& handle)
 	{
-		glDeleteProgram(handle);
-		handle = 0;
+		auto cache = programUniformCaches.find(handle);
+		if (cache != programUniformCaches.end())
+		{
+			if (currentUniformCache == &cache->second) currentUniformCache = nullptr;
+			programUniformCaches.erase(cache);
+		}
+
+		DeleteProgram(handle);
+	}
+
+	ShaderCompiler::~ShaderCompiler()
+	{
+		Clear();
+	}
+
+	ShaderCompileTicket ShaderCompiler::Request(const ShaderSource& source)
+	{
+		const ShaderCompileTicket ticket = static_cast<ShaderCompileTicket>(requests.size());
+		Build build{};
+		build.state = State_Compiling;
+
+		const std::vector<GLint> formats = shaderCacheDirectory.empty() ? std::vector<GLint>() : program_binary_formats();
+		if (!formats.empty())
+		{
+			build.binaryKey = program_binary_key(source);
+			build.binaryPath = program_binary_path(build.binaryKey);
+			build.program = load_program_binary(build.binaryPath, build.binaryKey, formats);
+		}
+
+		if (build.program)
+		{
+			// Block bindings are set again on loaded binaries too: the binary only has to restore what linking produced.
+			bind_uniform_blocks(build.program);
+			if (build_uniform_cache(build.program))
+			{
+				build.state = State_Ready;
+			}
+			else
+			{
+				glDeleteProgram(build.program);
+				build.program = 0;
+				build.state = State_Failed;
+			}
+			build.binaryPath.clear();
+		}
+		else
+		{
+			// Without this the driver may keep compiling on the calling thread.
+			if (GLEW_KHR_parallel_shader_compile && compiling.empty())
+			{
+				glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+			}
+			build.program = begin_program(source, !formats.empty(), build.shaders);
+			compiling.push_back(ticket);
+		}
+
+		requests.push_back(std::move(build));
+		return ticket;
+	}
+
+	size_t ShaderCompiler::Poll()
+	{
+		const bool parallel = GLEW_KHR_parallel_shader_compile;
+		size_t finished = 0;
+		for (size_t i = 0; i < compiling.size();)
+		{
+			const ShaderCompileTicket ticket = compiling[i];
+			if (parallel)
+			{
+				GLint complete = GL_FALSE;
+				glGetProgramiv(requests[ticket].program, GL_COMPLETION_STATUS_KHR, &complete);
+				if (!complete)
+				{
+					++i;
+					continue;
+				}
+			}
+			else if (finished > 0)
+			{
+				break;
+			}
+
+			finish(ticket);
+			compiling.erase(compiling.begin() + i);
+			++finished;
+		}
+		return finished;
+	}
+
+	void ShaderCompiler::Finish()
+	{
+		for (ShaderCompileTicket ticket : compiling)
+		{
+			finish(ticket);
+		}
+		compiling.clear();
+	}
+
+	ShaderHandle ShaderCompiler::Get(ShaderCompileTicket ticket, ShaderHandle fallback) const
+	{
+		const Build& build = requests[ticket];
+		return build.state == State_Ready && build.program ? build.program : fallback;
+	}
+
+	ShaderHandle ShaderCompiler::Take(ShaderCompileTicket ticket)
+	{
+		const ShaderHandle program = requests[ticket].program;
+		requests[ticket].program = 0;
+		return program;
+	}
+
+	void ShaderCompiler::Clear()
+	{
+		for (Build& build : requests)
+		{
+			if (build.state == State_Compiling)
+			{
+				// Deleting the program detaches its shaders, and the driver drops whatever it was still building.
+				cleanup_shaders(build.shaders[0], build.shaders[1], build.shaders[2], build.shaders[3], build.shaders[4]);
+				glDeleteProgram(build.program);
+			}
+			else if (build.program)
+			{
+				DeleteShader(build.program);
+			}
+		}
+		requests.clear();
+		compiling.clear();
+	}
+
+	void ShaderCompiler::finish(ShaderCompileTicket ticket)
+	{
+		Build& build = requests[ticket];
+		if (!finish_program(build.program, build.shaders))
+		{
+			build.program = 0;
+			build.state = State_Failed;
+			return;
+		}
+
+		// Checked before saving the binary, so a program that fails here isn't loaded from the cache next time either.
+		if (!build_uniform_cache(build.program))
+		{
+			glDeleteProgram(build.program);
+			build.program = 0;
+			build.state = State_Failed;
+			build.binaryPath.clear();
+			return;
+		}
+
+		if (!build.binaryPath.empty())
+		{
+			save_program_binary(build.program, build.binaryPath, build.binaryKey);
+			build.binaryPath.clear();
+		}
+
+		bind_uniform_blocks(build.program);
+		build.state = State_Ready;
+	}
+
+	ShaderVariants::ShaderVariants(const ShaderSource& base)
+		: base(&base), variants(size_t(1) << ShaderFeature_Count, Variant{}), count(0)
+	{
+	}
+
+	ShaderVariants::~ShaderVariants()
+	{
+		Clear();
+	}
+
+	ShaderHandle ShaderVariants::Get(ShaderVariantKey key)
+	{
+		if (key >= variants.size())
+		{
+			return 0;
+		}
+
+		Variant& variant = variants[key];
+		if (variant.compiler)
+		{
+			// Requested asynchronously before: wait for that request rather than building the variant twice.
+			variant.compiler->Finish();
+			poll(variant);
+		}
+		else if (!variant.program && !variant.failed)
+		{
+			variant.program = CompileShader(SpecializeShader(*base, key));
+			variant.failed = variant.program == 0;
+			++count;
+		}
+		return variant.program;
+	}
+
+	ShaderHandle ShaderVariants::Get(ShaderVariantKey key, ShaderCompiler& compiler, ShaderHandle fallback)
+	{
+		if (key >= variants.size())
+		{
+			return fallback;
+		}
+
+		Variant& variant = variants[key];
+		if (variant.program)
+		{
+			return variant.program;
+		}
+		if (variant.failed)
+		{
+			return fallback;
+		}
+
+		if (!variant.compiler)
+		{
+			variant.compiler = &compiler;
+			variant.ticket = compiler.Request(SpecializeShader(*base, key));
+			++count;
+		}
+
+		poll(variant);
+		return variant.program ? variant.program : fallback;
+	}
+
+	void ShaderVariants::poll(Variant& variant)
+	{
+		if (variant.compiler->IsReady(variant.ticket))
+		{
+			variant.program = variant.compiler->Take(variant.ticket);
+			variant.compiler = nullptr;
+		}
+		else if (variant.compiler->IsFailed(variant.ticket))
+		{
+			variant.compiler = nullptr;
+			variant.failed = true;
+		}
+	}
+
+	void ShaderVariants::Clear()
+	{
+		for (Variant& variant : variants)
+		{
+			DeleteShader(variant.program);
+			variant = Variant{};
+		}
+		count = 0;
 	}
 
 	void UseShader(ShaderHandle handle)
 	{
-		glUseProgram(handle);
+		BindProgram(handle);
+
+		auto cache = programUniformCaches.find(handle);
+		currentUniformCache = cache != programUniformCaches.end() ? &cache->second : nullptr;
 	}
 
 	std::vector<ShaderVertexAttribute> GetShaderVertexAttributes(ShaderHandle handle)
@@ -259,13 +916,11 @@ namespace gfx
 			glGetActiveUniform(handle, i, uniformMaxLength, &written, &size, &type, glName);
 			location = glGetUniformLocation(handle, glName);
 
-			std::string name(glName, written);
-
 			ShaderUniform uniform;
-			uniform.id = string_hash(name);
+			uniform.id = HashUniformName(uniform_base_name(std::string_view(glName, written)));
 			uniform.location = location;
 			uniform.type = type;
-			uniforms.push_back(uniform);
+			uniforms[i] = uniform;
 		}
 
 		delete[] glName;
@@ -275,8 +930,23 @@ namespace gfx
 
 	GLint GetShaderUniformLocation(ShaderHandle handle, const std::string& name)
 	{
+		auto cache = programUniformCaches.find(handle);
+		if (cache != programUniformCaches.end())
+		{
+			const UniformSlot* slot = find_uniform(cache->second, HashUniformName(uniform_base_name(name)));
+			if (slot)
+			{
+				return slot->location;
+			}
+		}
+
+		// Not cached: array elements past [0] ("lights[2]") only have a location GL can resolve.
 		const GLchar* glName = static_cast<const GLchar*>(name.c_str());
-		GLint location = glGetUniformLocation(handle, glName);
-		return location;
+		return glGetUniformLocation(handle, glName);
+	}
+
+	ShaderCacheStats GetShaderCacheStats()
+	{
+		return shaderCacheStats;
 	}
-}
\ No newline at end of file
+}
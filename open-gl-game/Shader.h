@@ -1,8 +1,11 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <string_view>
 #include <optional>
 #include <vector>
+#include <glm/glm.hpp>
 
 
 namespace gfx
@@ -16,9 +19,24 @@ namespace gfx
 		std::string fragment;
 	};
 
+	// Uniform names are identified by their 32-bit FNV-1a hash. A program with two uniforms hashing alike fails to build.
+	typedef uint32_t UniformId;
+
+	// constexpr, so constant names hash at compile time: constexpr UniformId mvp = HashUniformName("mvp");
+	constexpr UniformId HashUniformName(std::string_view name)
+	{
+		UniformId hash = 2166136261u;
+		for (char c : name)
+		{
+			hash ^= static_cast<unsigned char>(c);
+			hash *= 16777619u;
+		}
+		return hash;
+	}
+
 	struct ShaderUniform
 	{
-		int id;
+		UniformId id;
 		int location;
 		unsigned int  type;
 	};
@@ -35,16 +53,209 @@ namespace gfx
 		std::string	name;
 	};
 
+	// Uniform block binding points. CompileShader binds a program's "Frame" and "Object" blocks to them.
+	enum UniformBlockBinding : unsigned int
+	{
+		UniformBlock_Frame = 0,
+		UniformBlock_Object = 1,
+	};
+
+	// std140 layout of the "Frame" uniform block, written once per frame.
+	struct FrameUniforms
+	{
+		glm::mat4 view;
+		glm::mat4 projection;
+		glm::mat4 viewProjection;
+		// xyz is the direction towards the light. std140 pads a vec3 to 16 bytes anyway.
+		glm::vec4 lightDir;
+	};
+
+	// std140 layout of the "Object" uniform block, written per draw.
+	struct ObjectUniforms
+	{
+		glm::mat4 mvp;
+		glm::mat4 model;
+		glm::vec4 color;
+	};
+
+	// Features of default_shader. SpecializeShader turns each bit of a ShaderVariantKey into a #define, and the shader compiles
+	// only the code of the features defined.
+	enum ShaderFeature : uint32_t
+	{
+		// LIT: normal attribute, N.L lighting towards the "Frame" block's lightDir.
+		ShaderFeature_Lit			= 1 << 0,
+		// TEXTURE: uv attribute, the color is multiplied by the textureMap sampler.
+		ShaderFeature_Texture		= 1 << 1,
+		// VERTEX_COLOR: color attribute, multiplied into the color.
+		ShaderFeature_VertexColor	= 1 << 2,
+		// INSTANCED: model matrix, color and position dequantization read per instance (see gfx::InstanceData) instead of the "Object" block.
+		ShaderFeature_Instanced		= 1 << 3,
+		// ALPHA_TEST: discards fragments with alpha below 0.5. Leave it off for opaque draws, a discard turns off early depth testing.
+		ShaderFeature_AlphaTest		= 1 << 4,
+		ShaderFeature_Count			= 5
+	};
+
+	// Set of ShaderFeature bits naming one variant of a shader.
+	typedef uint32_t ShaderVariantKey;
+
+	// constexpr, so fixed feature sets make their key at compile time:
+	// constexpr ShaderVariantKey key = MakeShaderVariantKey(ShaderFeature_Lit, ShaderFeature_Instanced);
+	template<typename... Features>
+	constexpr ShaderVariantKey MakeShaderVariantKey(Features... features)
+	{
+		return (ShaderVariantKey(0) | ... | static_cast<ShaderVariantKey>(features));
+	}
+
+	// The uber shader behind the built-in shaders, see ShaderFeature. It reads per-frame data from the "Frame" block and,
+	// unless instanced, per-object data from the "Object" block.
+	extern ShaderSource default_shader;
+
+	// Fixed variants of default_shader, all alpha tested.
 	extern ShaderSource default_unlit_texture;
 	extern ShaderSource default_unlit_color;
 	extern ShaderSource default_lit_color;
+	extern ShaderSource default_lit_color_instanced;
+
+	// {base} with a "#define <FEATURE>" line for every bit of {key} after the #version line of each stage.
+	ShaderSource SpecializeShader(const ShaderSource& base, ShaderVariantKey key);
 
 	typedef unsigned int ShaderHandle;
 
+	struct ShaderCacheStats
+	{
+		// Programs created from a cached binary, and cached binaries the driver (or a source change) made stale.
+		size_t binaryLoads;
+		size_t binaryRejects;
+		// Programs compiled and linked from source, and binaries written for them.
+		size_t compiles;
+		size_t binaryWrites;
+	};
+
+	// When not empty, CompileShader stores the linked binary of every program in this directory and creates the program from it
+	// on later runs, skipping compilation. A binary is keyed by the source of every stage and the GL vendor, renderer and version
+	// strings, so a driver update starts over; one the driver rejects anyway is compiled again and replaced.
+	// Empty (off) by default. Without ARB_get_program_binary, or any binary format, CompileShader always compiles.
+	extern std::string shaderCacheDirectory;
+
+	// Compiles and links {source}, or loads its cached binary (see shaderCacheDirectory). Returns 0 if it doesn't compile or link,
+	// or two of its uniform names hash alike.
 	ShaderHandle CompileShader(const ShaderSource& source);
 	void DeleteShader(ShaderHandle& handle);
+
+	// Identifies a ShaderCompiler request.
+	typedef uint32_t ShaderCompileTicket;
+
+	// Builds programs without stalling the GL thread. Request issues the compile of every stage and the link right away, and
+	// nothing queries a status until Poll. With KHR_parallel_shader_compile the driver builds them on its own threads and Poll only
+	// collects those GL_COMPLETION_STATUS_KHR reports done; without it Poll finishes one request per call, which may block.
+	// Programs come out exactly as CompileShader makes them, through the binary cache too (see shaderCacheDirectory).
+	// Until a request is ready, draw with a fallback program (see Get) or skip what needs it.
+	class ShaderCompiler
+	{
+	public:
+		ShaderCompiler() = default;
+		ShaderCompiler(const ShaderCompiler&) = delete;
+		ShaderCompiler& operator=(const ShaderCompiler&) = delete;
+		~ShaderCompiler();
+
+		// Starts building {source}. A cached binary is loaded on the spot, so such a request is finished when this returns.
+		ShaderCompileTicket Request(const ShaderSource& source);
+		// Finishes the requests the driver is done with. Returns the number finished.
+		size_t Poll();
+		// Blocks until every request is finished.
+		void Finish();
+
+		inline bool IsReady(ShaderCompileTicket ticket) const { return requests[ticket].state == State_Ready; }
+		// Finished, but a stage failed to compile, the program failed to link or two of its uniform names hash alike.
+		inline bool IsFailed(ShaderCompileTicket ticket) const { return requests[ticket].state == State_Failed; }
+		// Number of requests not finished yet.
+		inline size_t Pending() const { return compiling.size(); }
+		// The program of {ticket} once it is ready, else {fallback}. The compiler keeps owning it.
+		ShaderHandle Get(ShaderCompileTicket ticket, ShaderHandle fallback = 0) const;
+		// Hands the ready program to the caller, who must DeleteShader it. Only valid once, after IsReady.
+		ShaderHandle Take(ShaderCompileTicket ticket);
+		// Deletes every program not taken, finished or not. Invalidates all tickets.
+		void Clear();
+
+	private:
+		enum State
+		{
+			State_Compiling,
+			State_Ready,
+			State_Failed
+		};
+
+		struct Build
+		{
+			ShaderHandle	program;
+			// Vertex, control, evaluation, geometry and fragment stage, 0 if absent. Released once the program is finished.
+			unsigned int	shaders[5];
+			State			state;
+			// Program binary to write once linked, empty without a cache.
+			uint64_t		binaryKey;
+			std::string		binaryPath;
+		};
+
+		void finish(ShaderCompileTicket ticket);
+
+		std::vector<Build>					requests;
+		std::vector<ShaderCompileTicket>	compiling;
+	};
+
+	// The variants of one base shader, each built the first time it is asked for and kept until Clear.
+	// A lookup is an array index, cheap enough to pick the variant of every draw. {base} must outlive the variants.
+	class ShaderVariants
+	{
+	public:
+		explicit ShaderVariants(const ShaderSource& base = default_shader);
+		ShaderVariants(const ShaderVariants&) = delete;
+		ShaderVariants& operator=(const ShaderVariants&) = delete;
+		~ShaderVariants();
+
+		// The program of {key}, compiled on the spot the first time. 0 if it doesn't compile or link, or {key} has bits
+		// beyond ShaderFeature_Count. If {key} was requested from a compiler and is still pending, blocks until it is done.
+		ShaderHandle Get(ShaderVariantKey key);
+		// Never blocks: the first time requests {key} from {compiler}, then returns {fallback} until it is ready.
+		// {compiler} must not be cleared while the request is pending. Invalid keys get {fallback}.
+		ShaderHandle Get(ShaderVariantKey key, ShaderCompiler& compiler, ShaderHandle fallback);
+		// Number of variants built, or being built.
+		inline size_t Count() const { return count; }
+		// Deletes every variant. A request still pending is left to its compiler, which deletes it when cleared.
+		void Clear();
+
+	private:
+		struct Variant
+		{
+			ShaderHandle		program;
+			// Set while the variant is being built by this compiler.
+			ShaderCompiler*		compiler;
+			ShaderCompileTicket	ticket;
+			bool				failed;
+		};
+
+		// Takes the program of the pending request of {variant} once it finished.
+		void poll(Variant& variant);
+
+		const ShaderSource*		base;
+		// Indexed by key.
+		std::vector<Variant>	variants;
+		size_t					count;
+	};
 	void UseShader(ShaderHandle handle);
 	std::vector<ShaderVertexAttribute> GetShaderVertexAttributes(ShaderHandle handle);
 	std::vector<ShaderUniform> GetShaderUniforms(ShaderHandle handle);
+	// Looked up in the reflection cache of {handle} first; names it doesn't hold, like array elements past [0], are asked from GL.
 	GLint GetShaderUniformLocation(ShaderHandle handle, const std::string& name);
+	ShaderCacheStats GetShaderCacheStats();
+
+	// Sets a uniform of the program bound with UseShader, looked up in the reflection cache built by CompileShader.
+	// The last value set is shadowed per program, so setting an unchanged value makes no GL call.
+	// Unknown (or optimized out) uniforms are ignored.
+	void SetUniform(UniformId id, int value);
+	void SetUniform(UniformId id, float value);
+	void SetUniform(UniformId id, const glm::vec2& value);
+	void SetUniform(UniformId id, const glm::vec3& value);
+	void SetUniform(UniformId id, const glm::vec4& value);
+	void SetUniform(UniformId id, const glm::mat3& value);
+	void SetUniform(UniformId id, const glm::mat4& value);
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+#include <cstring>
+#include "GLState.h"
+#include "UniformBuffer.h"
+
+namespace gfx
+{
+	void UniformRingBuffer::Create(size_t size)
+	{
+		GLint offsetAlignment = 0;
+		glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+		alignment = offsetAlignment > 0 ? offsetAlignment : 256;
+
+		capacity = AlignedSize(size > 0 ? size : 1);
+		head = 0;
+
+		glGenBuffers(1, &buffer);
+		BindBuffer(GL_UNIFORM_BUFFER, buffer);
+		glBufferData(GL_UNIFORM_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+	}
+
+	void UniformRingBuffer::Destroy()
+	{
+		DeleteBuffer(buffer);
+		capacity = 0;
+		head = 0;
+		staging.clear();
+		staging.shrink_to_fit();
+	}
+
+	// Orphans the storage when {size} more bytes don't fit after {head}: draws in flight keep the old one, new writes go to
+	// fresh memory. A request larger than the whole buffer grows it. The buffer must be bound to GL_UNIFORM_BUFFER.
+	void orphanIfFull(size_t size, size_t& head, size_t& capacity)
+	{
+		if (head + size <= capacity)
+		{
+			return;
+		}
+
+		while (size > capacity)
+		{
+			capacity *= 2;
+		}
+		glBufferData(GL_UNIFORM_BUFFER, capacity, nullptr, GL_STREAM_DRAW);
+		head = 0;
+	}
+
+	void UniformRingBuffer::Reserve(size_t size)
+	{
+		BindBuffer(GL_UNIFORM_BUFFER, buffer);
+		head = AlignedSize(head);
+		orphanIfFull(AlignedSize(size), head, capacity);
+	}
+
+	char* UniformRingBuffer::Map(size_t size, size_t& offset)
+	{
+		BindBuffer(GL_UNIFORM_BUFFER, buffer);
+
+		size_t start = AlignedSize(head);
+		orphanIfFull(size, start, capacity);
+
+		head = start + size;
+		mappedOffset = start;
+		mappedSize = size;
+		offset = start;
+
+		void* data = glMapBufferRange(GL_UNIFORM_BUFFER, start, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+		mapped = data != nullptr;
+		if (mapped)
+		{
+			return static_cast<char*>(data);
+		}
+
+		if (staging.size() < size)
+		{
+			staging.resize(size);
+		}
+		return staging.data();
+	}
+
+	void UniformRingBuffer::Unmap()
+	{
+		if (mapped)
+		{
+			glUnmapBuffer(GL_UNIFORM_BUFFER);
+		}
+		else
+		{
+			glBufferSubData(GL_UNIFORM_BUFFER, mappedOffset, mappedSize, staging.data());
+		}
+
+		mapped = false;
+	}
+
+	size_t UniformRingBuffer::Write(const void* data, size_t size)
+	{
+		size_t offset = 0;
+		memcpy(Map(size, offset), data, size);
+		Unmap();
+		return offset;
+	}
+
+	void UniformRingBuffer::BindRange(GLuint binding, size_t offset, size_t size) const
+	{
+		BindUniformBufferRange(binding, buffer, offset, size);
+	}
+}
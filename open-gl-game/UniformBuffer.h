@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+#include <GL/glew.h>
+
+namespace gfx
+{
+	// Streams uniform block data into one large uniform buffer.
+	// Allocations only move forward. When the buffer is full it is orphaned and writing restarts at the front,
+	// so a mapped range never overlaps data a draw in flight may still read and can be mapped unsynchronized.
+	class UniformRingBuffer
+	{
+	public:
+		void Create(size_t capacity);
+		void Destroy();
+
+		// Offsets passed to BindRange must be a multiple of this (GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT).
+		inline size_t Alignment() const { return alignment; }
+		// {size} rounded up to Alignment(). Use it as the stride between blocks written with a single Map.
+		inline size_t AlignedSize(size_t size) const { return (size + alignment - 1) / alignment * alignment; }
+
+		// Makes sure the next {size} bytes of Maps (each started at an Alignment() boundary) fit without orphaning, orphaning
+		// now if they wouldn't. An orphan invalidates every range bound before it, so reserve a frame's data before binding any of it.
+		void Reserve(size_t size);
+		// Reserves {size} bytes and returns a write-only pointer to them. {offset} receives their offset in the buffer.
+		// Unmap before drawing with the data.
+		char* Map(size_t size, size_t& offset);
+		void Unmap();
+		// Map, copy and Unmap in one go. Returns the offset of the data in the buffer.
+		size_t Write(const void* data, size_t size);
+
+		// Binds [offset, offset + size) to uniform block binding point {binding}.
+		void BindRange(GLuint binding, size_t offset, size_t size) const;
+
+	private:
+		GLuint				buffer = 0;
+		size_t				capacity = 0;
+		size_t				head = 0;
+		size_t				alignment = 256;
+
+		// Used instead of a mapping when the buffer can't be mapped.
+		std::vector<char>	staging;
+		size_t				mappedOffset = 0;
+		size_t				mappedSize = 0;
+		bool				mapped = false;
+	};
+}
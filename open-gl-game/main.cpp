@@ -8,47 +8,21 @@
 
 #include "GLErrorCheck.h"
 
-#include <glm/gtc/matrix_transform.hpp>
-
+#include "Game.h"
+#include "MeshCache.h"
 #include "Shader.h"
-#include "Mesh.h"
-#include "Primitives.h"
-#include "Camera.h"
 
 using namespace std;
 
 bool quit = false;
 int windowWidth = 640;
 int windowHeight = 480;
-bool wireframe = false;
-
-float nearPlane = 0.1f;
-float farPlane = 100.0f;
-float fieldOfView = 70;
-
-gfx::ShaderHandle shader;
-glm::mat4 projection;
-glm::mat4 view;
 
 Uint64 NOW = SDL_GetPerformanceCounter();
 Uint64 LAST = 0;
 double deltaTime = 0;
 
-bool input_up;
-bool input_down;
-bool input_right;
-bool input_left;
-bool input_rightMouse;
-glm::vec2 mouseDelta;
-Camera camera(glm::vec3(0, 1, 3));
-
-struct DrawCall
-{
-	gfx::Mesh mesh;
-	glm::mat4 matrix;
-};
-
-std::vector<DrawCall> drawCalls;
+GameInput input{};
 
 int startup(SDL_Window*& window, const char* title, int width, int height)
 {
@@ -118,27 +92,27 @@ void shutdown(SDL_Window*& window)
 
 void key_down(const SDL_KeyboardEvent& event)
 {
-	if (event.keysym.sym == SDLK_w) input_up = true;
-	if (event.keysym.sym == SDLK_s) input_down = true;
-	if (event.keysym.sym == SDLK_d) input_right = true;
-	if (event.keysym.sym == SDLK_a) input_left = true;
-	if (event.keysym.sym == SDLK_TAB) wireframe = !wireframe;
+	if (event.keysym.sym == SDLK_w) input.up = true;
+	if (event.keysym.sym == SDLK_s) input.down = true;
+	if (event.keysym.sym == SDLK_d) input.right = true;
+	if (event.keysym.sym == SDLK_a) input.left = true;
+	if (event.keysym.sym == SDLK_TAB) input.wireframe = !input.wireframe;
 }
 void key_up(const SDL_KeyboardEvent& event)
 {
-	if (event.keysym.sym == SDLK_w) input_up	= false;
-	if (event.keysym.sym == SDLK_s) input_down	= false;
-	if (event.keysym.sym == SDLK_d) input_right = false;
-	if (event.keysym.sym == SDLK_a) input_left	= false;
+	if (event.keysym.sym == SDLK_w) input.up	= false;
+	if (event.keysym.sym == SDLK_s) input.down	= false;
+	if (event.keysym.sym == SDLK_d) input.right = false;
+	if (event.keysym.sym == SDLK_a) input.left	= false;
 }
 
 void mouse_button_down(const SDL_MouseButtonEvent& event)
 {
-	if (event.button == SDL_BUTTON_RIGHT) input_rightMouse = true;
+	if (event.button == SDL_BUTTON_RIGHT) input.rightMouse = true;
 }
 void mouse_button_up(const SDL_MouseButtonEvent& event)
 {
-	if (event.button == SDL_BUTTON_RIGHT) input_rightMouse = false;
+	if (event.button == SDL_BUTTON_RIGHT) input.rightMouse = false;
 }
 
 void process_events()
@@ -175,80 +149,19 @@ void process_events()
 			mouse_button_up(event.button);
 			break;
 		case SDL_MOUSEMOTION:
-			mouseDelta.x = event.motion.xrel;
-			mouseDelta.y = event.motion.yrel;
+			input.mouseDelta.x = event.motion.xrel;
+			input.mouseDelta.y = event.motion.yrel;
 			break;
 		}
 	}
 }
 
-void begin_game()
-{
-	shader = gfx::CompileShader(gfx::default_lit_color);
-	GL_ERRORCHECK();
-	drawCalls =
-	{
-		{
-			gfx::CreateMesh(gfx::primitive::Quad(1.0f, 1.0f), false),
-			glm::translate(glm::identity<glm::mat4>(), glm::vec3(-1, 0, 0))
-		},
-		{
-			gfx::CreateMesh(gfx::primitive::Box(1.0f, 1.0f, 1.0f), false),
-			glm::translate(glm::identity<glm::mat4>(), glm::vec3(0, 0, 0))
-		},
-		{
-			gfx::CreateMesh(gfx::primitive::Sphere(2, 0.5f)),
-			glm::translate(glm::identity<glm::mat4>(), glm::vec3(0,0,0)),
-		},
-		{
-			gfx::CreateMesh(gfx::primitive::Cylinder(0.5f, 1.0f, 16)),
-			glm::translate(glm::identity<glm::mat4>(), glm::vec3(0,0,0)),
-		},
-		{
-			gfx::CreateMesh(gfx::primitive::Capsule(0.5f, 1.0f, 16, 16, 0)),
-			glm::translate(glm::identity<glm::mat4>(), glm::vec3(0,0,0)),
-		},
-	};
-
-	projection = glm::perspective(	glm::radians(fieldOfView),					// The vertical Field of View in radians (the amount of "zoom").
-									(float) windowWidth / (float) windowHeight,	// Aspect Ratio.
-									nearPlane,									// Near clipping plane. Keep as big as possible, or you'll get precision issues.
-									farPlane);									// Far clipping plane. Keep as little as possible.
-
-	//view = glm::translate(glm::identity<glm::mat4>(), glm::vec3(0, 0, -5));
-	glm::vec3 cameraPosition = glm::vec3(0, 1, -3);
-	view = glm::translate(glm::identity<glm::mat4>(), cameraPosition) *
-			glm::lookAt(cameraPosition, glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
-	auto attribs = gfx::GetShaderVertexAttributes(shader);
-
-	for (const auto& attrib : attribs)
-	{
-		std::cout << attrib.name << ": size=" << attrib.size << ", type=" << attrib.type << ", location=" << attrib.location << std::endl;
-	}
-}
-
-void end_game()
-{
-	gfx::DeleteShader(shader);
-	for (auto& drawcall : drawCalls)
-	{
-		gfx::DeleteMesh(drawcall.mesh);
-	}
-}
-
 void game_loop(SDL_Window* window)
 {
-	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
-	glCullFace(GL_BACK);
-	glEnable(GL_DEPTH_TEST);
-	begin_game();
-
-	GL_ERRORCHECK();
-
-	GLint mvpLocation = gfx::GetShaderUniformLocation(shader, "mvp");
-	GLint modelLocation = gfx::GetShaderUniformLocation(shader, "model");
-	GLint colorLocation = gfx::GetShaderUniformLocation(shader, "color");
-	GLint lightDirLocation = gfx::GetShaderUniformLocation(shader, "lightDir");
+	// The first run bakes the scene's meshes and shader binaries, later runs load them straight from the files.
+	gfx::meshFileDirectory = "mesh-cache";
+	gfx::shaderCacheDirectory = "shader-cache";
+	begin_game(windowWidth, windowHeight);
 
 	GL_ERRORCHECK();
 
@@ -262,37 +175,10 @@ void game_loop(SDL_Window* window)
 		deltaTime *= 0.001;
 
 		process_events();
-		if (input_up)		camera.ProcessKeyboard(Camera_Movement::FORWARD, deltaTime);
-		if (input_down)		camera.ProcessKeyboard(Camera_Movement::BACKWARD, deltaTime);
-		if (input_right)	camera.ProcessKeyboard(Camera_Movement::RIGHT, deltaTime);
-		if (input_left)		camera.ProcessKeyboard(Camera_Movement::LEFT, deltaTime);
-		if (input_rightMouse)
-		{
-			camera.ProcessMouseMovement(mouseDelta.x, -mouseDelta.y);
-		}
-		mouseDelta = glm::vec2(0, 0);
+		update_game(input, deltaTime);
+		input.mouseDelta = glm::vec2(0, 0);
 
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		if (wireframe)      glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
-		else                glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-
-		gfx::UseShader(shader);
-
-		int index = 0;
-		for (auto& drawcall : drawCalls)
-		{
-			drawcall.matrix = glm::translate(glm::identity<glm::mat4>(), glm::vec3(-3 + index++ * 2, 0, 0));
-								//* glm::rotate(glm::identity<glm::mat4>(), (float)((SDL_GetTicks() / 100) % 360), glm::vec3(0.f, 1.f, 0.f));
-				
-			glm::mat4 mvp = projection * camera.GetViewMatrix() * drawcall.matrix;
-			glUniformMatrix4fv(mvpLocation, 1, GL_FALSE, &mvp[0][0]);
-			glUniformMatrix4fv(modelLocation, 1, GL_FALSE, &drawcall.matrix[0][0]);
-			glm::vec4 color(0.f, 1.f, 0.f, 1.f);
-			glUniform4fv(colorLocation, 1, &color[0]);
-			glm::vec3 lightDir = glm::normalize(glm::vec3(-1.5, 2, 1));
-			glUniform3fv(lightDirLocation, 1, &lightDir[0]);
-			gfx::DrawMesh(drawcall.mesh);
-		}
+		render_game(input);
 
 		SDL_GL_SwapWindow(window);
 	}